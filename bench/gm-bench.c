@@ -0,0 +1,933 @@
+/*
+File:       gm-bench.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+m-gen benchmark ('make bench'):
+
+    - synthetic .gm files: every target and mix of modes, from 10 pins to all pins of target
+        (every PORT & PIN is used once - no warnings), and pathological files up to 1 000 000
+        requested pins: long comments, many sections ('$x'), many escaped dollars ('$$'),
+    - every file is converted in memory by libmgen - time of phases: open (sections & targets),
+        parse (pins), emit (headers of all targets),
+    - and by m-gen program - end-to-end time (reading, checking, writing files, ...),
+    - results are written to baseline file (tab separated values) - it can be compared
+        with baseline of other version: '--compare old.tsv'.
+
+Generator alone:
+    gm-bench --generate TARGET MIX PINS [VARIANT] > file.gm
+
+POSIX only (clock_gettime(), system()).
+*/
+
+#define _POSIX_C_SOURCE 200809L     // clock_gettime(), unlink()
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), free(), system()
+#include <string.h>
+#include <math.h>   //log(), exp()
+#include <time.h>
+#include <unistd.h>     //unlink()
+#include <sys/stat.h>   //mkdir()
+
+#include "m-gen.h"
+#include "gm-output.h"
+#include "libmgen.h"
+
+
+
+/* pathological variants of file */
+typedef enum{
+
+    VAR_NONE,
+    VAR_COMMENTS,   // 1000 characters of comments per requested pin
+    VAR_SECTIONS,   // 10 section marks ('$x') per requested pin in '$o' section
+    VAR_DOLLARS     // 10 escaped dollars ('$$') per requested pin in header, '$c' and '$o'
+
+} GM_BENCH_VARIANT;
+
+static const char* variantNames[] = { "", "comments", "sections", "dollars" };
+
+#define VARIANTS_NUM    ((int) (sizeof(variantNames) / sizeof(variantNames[0])))
+
+
+/* mixes of pin modes */
+static const struct{
+
+    const char* name;
+    const char* modes;
+
+} mixes[] = {
+
+    { "all",    "iodlhb" },
+    { "gpio",   "iod" },
+    { "active", "lhb" }
+};
+
+#define MIXES_NUM   ((int) (sizeof(mixes) / sizeof(mixes[0])))
+
+
+/* targets in '$t' section - one file can have many of them */
+static const char* targetSets[] = { "avr", "lpc111x", "lpc17xx", "avr lpc17xx" };
+
+#define TARGET_SETS_NUM     ((int) (sizeof(targetSets) / sizeof(targetSets[0])))
+
+
+static const int sizes[] = { 10, 1000, 100000, 1000000 };
+
+#define SIZES_NUM   ((int) (sizeof(sizes) / sizeof(sizes[0])))
+
+
+
+/* one benchmark */
+typedef struct{
+
+    char name[64];
+
+    const char* targets;
+    const char* modes;
+    int size;       // requested pins - pathological parts of file grow with it
+    int pins;       // pins in file - max. all pins of targets
+    GM_BENCH_VARIANT variant;
+
+    // results [ms] - best of runs
+    size_t gmBytes;
+    size_t hBytes;
+    double open;
+    double parse;
+    double emit;
+    double e2e;     // -1 - m-gen failed
+
+} GM_BENCH_CASE;
+
+
+/* options */
+typedef struct{
+
+    const char* program;    // m-gen
+    const char* dir;        // for .gm & .h files
+    const char* baseline;
+    const char* compare;    // NULL if not given
+    const char* filter;     // only cases containing this text (NULL - all)
+
+    int maxPins;
+    int runs;
+    int jobs;
+
+    bool keep;              // don't delete generated files
+    bool trace;             // m-gen --trace=DIR/case.json
+
+} GM_BENCH_OPTIONS;
+
+
+
+
+/*---------------------------------------------------*/
+
+/* time in milliseconds */
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+
+
+/*---------------------------------------------------*/
+/*  generator                                        */
+/*---------------------------------------------------*/
+
+/* pins of lpc111x with warning or error in template (RESET, SWCLK, SWDIO, bootloader select,
+    open drain only) - not used, port * 12 + pin in ascending order */
+static const int lpc111xSkipped[] = { 0, 1, 4, 5, 10, 12 + 3 };
+
+#define LPC111X_SKIPPED_NUM     ((int) (sizeof(lpc111xSkipped) / sizeof(lpc111xSkipped[0])))
+
+
+/* number of different locations (PORT & PIN) of target - max. pins in file */
+static int targetPins(const char* target)
+{
+    if(strncmp(target, "avr", 3) == 0)
+        return 26 * 8;      // PORTA ... PORTZ, 8 pins each
+
+    if(strncmp(target, "lpc111x", 7) == 0)
+        return 4 * 12 - LPC111X_SKIPPED_NUM;
+
+    return 5 * 32;
+}
+
+
+/* pins of all targets in list - the smallest number */
+static int targetsPins(const char* targets)
+{
+    int pins = -1;
+
+    for(const char* t = targets + strspn(targets, " "); *t; t += strspn(t, " "))
+    {
+        if(pins < 0 || targetPins(t) < pins)
+            pins = targetPins(t);
+
+        t += strcspn(t, " ");
+    }
+
+    return (pins < 0) ? 0 : pins;
+}
+
+
+/* PORT & PIN of pin nr 'i' (less than targetPins()) - every pin has other location,
+    different forms of the same values, valid for every mode */
+static void putLocation(GM_BUF* out, const char* target, int i)
+{
+    if(strncmp(target, "avr", 3) == 0)
+    {
+        char port = 'A' + i / 8;
+
+        // 'P' alone is the beginning of prefix "PORT" - only PORTP
+        if(i % 2 || port == 'P')
+            bufPrintf(out, "PORT%c\tP%c%d", port, port, i % 8);
+        else
+            bufPrintf(out, "%c\t%d", port, i % 8);
+    }
+
+    else if(strncmp(target, "lpc111x", 7) == 0)
+    {
+        for(int j=0; j<LPC111X_SKIPPED_NUM; ++j)
+            i += (i >= lpc111xSkipped[j]);
+
+        bufPrintf(out, "%d\t%d", i / 12, i % 12);
+    }
+
+    else
+        bufPrintf(out, "%d\t%d", i / 32, i % 32);
+}
+
+
+/* n escaped dollars in lines of text */
+static void putDollars(GM_BUF* out, int n)
+{
+    for(int i=0; i<n; ++i)
+        bufPuts(out, (i % 8 == 7) ? "$$9\n" : "$$9 ");
+
+    bufPutc(out, '\n');
+}
+
+
+/*
+Whole .gm file: header, '$t', '$c', '$m' (pins) and '$o' sections.
+'size' pins are requested - max. all pins of targets are written (see targetsPins()),
+    pathological parts of file grow with 'size'.
+Returns number of pins in file
+*/
+static int generate(GM_BUF* out, const char* targets, const char* modes, int size, GM_BENCH_VARIANT variant)
+{
+    int pins = (size < targetsPins(targets)) ? size : targetsPins(targets);
+    int modesNum = strlen(modes);
+
+
+    bufPrintf(out, "Synthetic file for m-gen benchmark (gm-bench)\n\n");
+
+    if(variant == VAR_DOLLARS)
+        putDollars(out, size * 4);
+
+
+    bufPrintf(out, "$t\n%s\n\n", targets);
+
+    bufPrintf(out, "$c\nTable of %d pins\n    generated by gm-bench\n", pins);
+
+    if(variant == VAR_DOLLARS)
+        putDollars(out, size * 4);
+
+    bufPrintf(out, "\n$m\nMode ");
+
+    // PORT & PIN columns of every target (in order of '$t' section)
+    for(const char* t = targets + strspn(targets, " "); *t; t += strspn(t, " "))
+    {
+        bufPuts(out, "PORT PIN ");
+        t += strcspn(t, " ");
+    }
+
+    bufPrintf(out, "Name Comment\n\n");
+
+
+    for(int i=0; i<pins; ++i)
+    {
+        bufPrintf(out, "%c", modes[i % modesNum]);
+
+        for(const char* t = targets + strspn(targets, " "); *t; t += strspn(t, " "))
+        {
+            bufPutc(out, '\t');
+            putLocation(out, t, i);
+            t += strcspn(t, " ");
+        }
+
+        bufPrintf(out, "\tsig_%d\t", i);
+
+        // comments of all requested pins in pins of file
+        if(variant == VAR_COMMENTS)
+        {
+            for(int j = 100 * (long long) size * i / pins; j < 100 * (long long) size * (i + 1) / pins; ++j)
+                bufPuts(out, "long text");
+        }
+
+        bufPrintf(out, "Signal nr %d\n", i);
+    }
+
+
+    bufPrintf(out, "\n$o\nOther notes\n");
+
+    if(variant == VAR_DOLLARS)
+        putDollars(out, size * 2);
+
+    if(variant == VAR_SECTIONS)
+    {
+        // only first occurrence of each section is used - all next ones are skipped by m-gen
+        for(int i=0; i<size * 10; ++i)
+            bufPrintf(out, (i % 16 == 15) ? "$%c\n" : "$%c ", 'a' + i % 26);
+    }
+
+    return pins;
+}
+
+
+
+/*---------------------------------------------------*/
+/*  measurements                                     */
+/*---------------------------------------------------*/
+
+/* output of libmgen - only counted */
+static int countBytes(const char* data, size_t size, void* ctx)
+{
+    (void) data;
+
+    *(size_t*) ctx += size;
+
+    return 0;
+}
+
+
+/* warnings (i. e. the same port & pin for many names) are expected - not printed */
+static void ignoreMessage(int level, const char* text, void* ctx)
+{
+    if(level >= MGEN_ERR)
+        fprintf(stderr, "%s", text);
+
+    (void) ctx;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* phases of conversion in memory; returns 0 or -1 */
+static int runLibrary(GM_BENCH_CASE* c, const GM_BUF* gm, const GM_BENCH_OPTIONS* opts)
+{
+    MGEN_DOCUMENT* doc;
+    double t0, t1, t2, t3;
+
+    c->hBytes = 0;
+
+    t0 = now();
+
+    if( (doc = mgen_open(gm->data, gm->size, NULL)) == NULL)
+        return -1;
+
+    mgen_setThreads(doc, opts->jobs);
+
+    t1 = now();
+
+    if(mgen_parse(doc) < 0)
+    {
+        mgen_close(doc);
+        return -1;
+    }
+
+    t2 = now();
+
+    for(int i=0; i<mgen_targetsNum(doc); ++i)
+    {
+        if(mgen_emitTo(doc, i, "bench.h", &countBytes, &c->hBytes) != 0)
+        {
+            mgen_close(doc);
+            return -1;
+        }
+    }
+
+    t3 = now();
+
+    mgen_close(doc);
+
+
+    if(c->open < 0 || t1 - t0 < c->open)
+        c->open = t1 - t0;
+
+    if(c->parse < 0 || t2 - t1 < c->parse)
+        c->parse = t2 - t1;
+
+    if(c->emit < 0 || t3 - t2 < c->emit)
+        c->emit = t3 - t2;
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* output files of m-gen ('-o name.h' - with many targets: name_avr.h, ...) are deleted */
+static void removeOutputs(const GM_BENCH_CASE* c, const char* dir)
+{
+    char path[1024];
+    const char* t = c->targets;
+
+    snprintf(path, sizeof(path), "%.900s/%.63s.h", dir, c->name);
+    unlink(path);
+
+    if(strchr(t, ' ') == NULL)
+        return;
+
+    while(*t)
+    {
+        int len = strcspn(t, " ");
+
+        snprintf(path, sizeof(path), "%.900s/%.63s_%.*s.h", dir, c->name, len > 32 ? 32 : len, t);
+        unlink(path);
+
+        t += len;
+        t += (*t == ' ');
+    }
+}
+
+
+/* end-to-end conversion by m-gen program; returns 0 or -1 */
+static int runProgram(GM_BENCH_CASE* c, const GM_BENCH_OPTIONS* opts)
+{
+    GM_BUF cmd;
+    double t;
+    int retval = 0;
+
+    bufInit(&cmd);
+
+    bufPrintf(&cmd, "\"%s\" \"%s/%s.gm\" -s -j %d", opts->program, opts->dir, c->name, opts->jobs);
+
+    if(opts->trace)
+        bufPrintf(&cmd, " \"--trace=%s/%s.json\"", opts->dir, c->name);
+
+    bufPrintf(&cmd, " -o \"%s/%s.h\" 2>/dev/null", opts->dir, c->name);
+    bufPutc(&cmd, '\0');
+
+    if(cmd.error)
+    {
+        bufFree(&cmd);
+        return -1;
+    }
+
+
+    // existing output would be up to date - nothing to do
+    removeOutputs(c, opts->dir);
+
+    t = now();
+
+    if(system(cmd.data) != 0)
+    {
+        fprintf(stderr, "%s: m-gen failed\n    %s\n", c->name, cmd.data);
+        retval = -1;
+    }
+
+    t = now() - t;
+
+    if(retval == 0 && (c->e2e < 0 || t < c->e2e))
+        c->e2e = t;
+
+    bufFree(&cmd);
+
+    return retval;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* one benchmark - all runs; returns 0 or -1 */
+static int runCase(GM_BENCH_CASE* c, const GM_BENCH_OPTIONS* opts)
+{
+    char path[1024];
+    GM_BUF gm;
+
+    // big files - one run (they take seconds)
+    int runs = (c->size >= 100000) ? 1 : opts->runs;
+
+    int retval = 0;
+
+
+    bufInit(&gm);
+    generate(&gm, c->targets, c->modes, c->size, c->variant);
+
+    if(gm.error)
+    {
+        fprintf(stderr, "%s: out of memory\n", c->name);
+        bufFree(&gm);
+        return -1;
+    }
+
+    c->gmBytes = gm.size;
+    c->open = c->parse = c->emit = c->e2e = -1;
+
+
+    snprintf(path, sizeof(path), "%.900s/%.63s.gm", opts->dir, c->name);
+
+    if(writeOutput(&gm, path, NULL) != 0)
+    {
+        perror(path);
+        bufFree(&gm);
+        return -1;
+    }
+
+
+    for(int i=0; i<runs && retval == 0; ++i)
+        retval = runLibrary(c, &gm, opts);
+
+    bufFree(&gm);
+
+    for(int i=0; i<runs && retval == 0; ++i)
+        retval = runProgram(c, opts);
+
+
+    if( ! opts->keep)
+    {
+        removeOutputs(c, opts->dir);
+        unlink(path);
+    }
+
+    return retval;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* all cases (max. 'capacity') - returns their number */
+static int createCases(GM_BENCH_CASE cases[], int capacity, const GM_BENCH_OPTIONS* opts)
+{
+    int n = 0;
+
+
+    for(int s=0; s<SIZES_NUM; ++s)
+    {
+        for(int t=0; t<TARGET_SETS_NUM; ++t)
+        {
+            int pins = targetsPins(targetSets[t]);
+
+            // files bigger than all pins of target are the same
+            if(s > 0 && sizes[s-1] >= pins)
+                continue;
+
+            if(sizes[s] < pins)
+                pins = sizes[s];
+
+            for(int m=0; m<MIXES_NUM; ++m)
+            {
+                // many targets in one file - only mix of all modes
+                if(strchr(targetSets[t], ' ') != NULL && m > 0)
+                    continue;
+
+                if(n < capacity)
+                {
+                    cases[n] = (GM_BENCH_CASE) { .targets = targetSets[t], .modes = mixes[m].modes,
+                                                 .size = sizes[s], .pins = pins, .variant = VAR_NONE };
+
+                    snprintf(cases[n].name, sizeof(cases[n].name), "%s-%s-%d", targetSets[t], mixes[m].name, pins);
+                    ++n;
+                }
+            }
+        }
+    }
+
+
+    // pathological files - AVR, all modes (name - requested pins)
+    for(int v=1; v<VARIANTS_NUM; ++v)
+    {
+        for(int size = 1000; size <= 100000; size *= 100)
+        {
+            if(n < capacity)
+            {
+                cases[n] = (GM_BENCH_CASE) { .targets = "avr", .modes = mixes[0].modes,
+                                             .size = (v == VAR_COMMENTS) ? size / 10 : size, .variant = v };
+
+                cases[n].pins = (cases[n].size < targetsPins("avr")) ? cases[n].size : targetsPins("avr");
+
+                snprintf(cases[n].name, sizeof(cases[n].name), "avr-%s-%d", variantNames[v], cases[n].size);
+                ++n;
+            }
+        }
+    }
+
+
+    // "avr lpc17xx" -> "avr+lpc17xx" (names of files)
+    for(int i=0; i<n; ++i)
+    {
+        char* space;
+
+        while( (space = strchr(cases[i].name, ' ')) != NULL)
+            *space = '+';
+    }
+
+
+    // selected by user
+    {
+        int selected = 0;
+
+        for(int i=0; i<n; ++i)
+        {
+            if(cases[i].size > opts->maxPins)
+                continue;
+
+            if(opts->filter != NULL && strstr(cases[i].name, opts->filter) == NULL)
+                continue;
+
+            cases[selected++] = cases[i];
+        }
+
+        n = selected;
+    }
+
+    return n;
+}
+
+
+
+/*---------------------------------------------------*/
+/*  baseline                                         */
+/*---------------------------------------------------*/
+
+/* tab separated values - one line per case */
+static int writeBaseline(const GM_BENCH_CASE cases[], int n, const GM_BENCH_OPTIONS* opts)
+{
+    GM_BUF out;
+    int retval = 0;
+
+    bufInit(&out);
+
+    bufPrintf(&out, "# m-gen benchmark (gm-bench) - m-gen v%s, threads: %d\n", mgen_version(), opts->jobs);
+    bufPrintf(&out, "# times in microseconds (best of runs), e2e - m-gen program (-1 - failed)\n");
+    bufPrintf(&out, "case\tpins\tgm_bytes\th_bytes\topen_us\tparse_us\temit_us\te2e_us\n");
+
+    for(int i=0; i<n; ++i)
+    {
+        const GM_BENCH_CASE* c = &cases[i];
+
+        bufPrintf(&out, "%s\t%d\t%u\t%u\t%d\t%d\t%d\t%d\n", c->name, c->pins,
+                (unsigned) c->gmBytes, (unsigned) c->hBytes,
+                (int) (c->open * 1e3), (int) (c->parse * 1e3), (int) (c->emit * 1e3),
+                (c->e2e < 0) ? -1 : (int) (c->e2e * 1e3));
+    }
+
+    if(writeOutput(&out, opts->baseline, NULL) != 0)
+    {
+        perror(opts->baseline);
+        retval = -1;
+    }
+
+    bufFree(&out);
+
+    return retval;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* compares results with other baseline file - ratio new / old */
+static int compareBaseline(const GM_BENCH_CASE cases[], int n, const char* oldName)
+{
+    FILE* fp = fopen(oldName, "r");
+    char line[512];
+
+    double logSum = 0;
+    int compared = 0;
+
+
+    if(fp == NULL)
+    {
+        perror(oldName);
+        return -1;
+    }
+
+    printf("\nCompared with %s (new / old time):\n\n", oldName);
+    printf("%-28s %8s %8s %8s %8s\n", "case", "parse", "emit", "m-gen", "pins");
+
+
+    while(fgets(line, sizeof(line), fp) != NULL)
+    {
+        char name[64];
+        int pins, open, parse, emit, e2e;
+        unsigned gmBytes, hBytes;
+
+        if(line[0] == '#' || sscanf(line, "%63s %d %u %u %d %d %d %d",
+                                    name, &pins, &gmBytes, &hBytes, &open, &parse, &emit, &e2e) != 8)
+            continue;
+
+        for(int i=0; i<n; ++i)
+        {
+            const GM_BENCH_CASE* c = &cases[i];
+
+            if(strcmp(c->name, name) != 0 || c->e2e < 0 || e2e <= 0)
+                continue;
+
+            printf("%-28s %8.2f %8.2f %8.2f %8d\n", name,
+                    (parse > 0) ? c->parse * 1e3 / parse : 1.0,
+                    (emit > 0) ? c->emit * 1e3 / emit : 1.0,
+                    c->e2e * 1e3 / e2e, pins);
+
+            logSum += log(c->e2e * 1e3 / e2e);
+            ++compared;
+        }
+    }
+
+    fclose(fp);
+
+
+    if(compared > 0)
+        printf("\nm-gen time (geometric mean of %d cases): %.3f x old\n", compared, exp(logSum / compared));
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+/*  main                                             */
+/*---------------------------------------------------*/
+
+static void usage(void)
+{
+    printf( "gm-bench - m-gen benchmark\n\n"
+            "    gm-bench [options]\n"
+            "        --program m-gen     m-gen program (default: bin/cc/m-gen)\n"
+            "        --dir dir           directory for generated files (default: bench/out)\n"
+            "        --baseline file     results (default: dir/baseline.tsv)\n"
+            "        --compare old.tsv   compare results with baseline of other version\n"
+            "        --filter text       only cases with 'text' in name (i. e. 'lpc17xx', '-1000')\n"
+            "        --max pins          only files up to 'pins' requested pins (default: 1000000)\n"
+            "        --runs n            best of n runs (default: 3, 100000 requested pins and more: 1)\n"
+            "        --jobs n            threads emitting one file (m-gen -j, default: 1)\n"
+            "        --keep              don't delete generated .gm & .h files\n"
+            "        --trace             m-gen writes trace of phases: dir/case.json (see m-gen --trace)\n"
+            "\n"
+            "    gm-bench --generate TARGETS MIX PINS [VARIANT] > file.gm\n"
+            "        TARGETS - i. e. avr, lpc17xx, \"avr lpc17xx\"\n"
+            "        PINS - max. all pins of targets (avr: 208, lpc111x: 42, lpc17xx: 160)\n"
+            "        MIX - all, gpio, active\n"
+            "        VARIANT - comments, sections, dollars\n");
+}
+
+
+/* '--generate TARGETS MIX PINS [VARIANT]' */
+static int generateOnly(int argc, char* argv[])
+{
+    GM_BUF out;
+    const char* modes = NULL;
+    int variant = VAR_NONE;
+
+
+    if(argc < 5)
+    {
+        usage();
+        return 1;
+    }
+
+    for(int i=0; i<MIXES_NUM; ++i)
+    {
+        if(strcmp(argv[3], mixes[i].name) == 0)
+            modes = mixes[i].modes;
+    }
+
+    if(argc > 5)
+    {
+        for(variant = VARIANTS_NUM - 1; variant > 0 && strcmp(argv[5], variantNames[variant]) != 0; --variant)
+            ;
+    }
+
+    if(modes == NULL || atoi(argv[4]) <= 0 || (argc > 5 && variant == VAR_NONE))
+    {
+        usage();
+        return 1;
+    }
+
+
+    bufInit(&out);
+
+    // every PORT & PIN only once - not more pins than targets have
+    if(generate(&out, argv[2], modes, atoi(argv[4]), variant) < atoi(argv[4]))
+        fprintf(stderr, "Only %d pins written (all pins of targets)\n", targetsPins(argv[2]));
+
+    if(out.error || fwrite(out.data, 1, out.size, stdout) != out.size)
+    {
+        fprintf(stderr, "Cannot write file\n");
+        bufFree(&out);
+        return 1;
+    }
+
+    bufFree(&out);
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+int main(int argc, char* argv[])
+{
+    static GM_BENCH_CASE cases[256];
+    char baseline[1024];
+    int n;
+    int failed = 0;
+
+    GM_BENCH_OPTIONS opts = {
+        .program = "bin/cc/m-gen",
+        .dir = "bench/out",
+        .baseline = NULL,
+        .compare = NULL,
+        .filter = NULL,
+        .maxPins = 1000000,
+        .runs = 3,
+        .jobs = 1,
+        .keep = false,
+        .trace = false
+    };
+
+
+    if(argc > 1 && strcmp(argv[1], "--generate") == 0)
+        return generateOnly(argc, argv);
+
+
+    for(int i=1; i<argc; ++i)
+    {
+        const char** value = NULL;
+        int* number = NULL;
+
+        if(strcmp(argv[i], "--program") == 0)
+            value = &opts.program;
+        else if(strcmp(argv[i], "--dir") == 0)
+            value = &opts.dir;
+        else if(strcmp(argv[i], "--baseline") == 0)
+            value = &opts.baseline;
+        else if(strcmp(argv[i], "--compare") == 0)
+            value = &opts.compare;
+        else if(strcmp(argv[i], "--filter") == 0)
+            value = &opts.filter;
+        else if(strcmp(argv[i], "--max") == 0)
+            number = &opts.maxPins;
+        else if(strcmp(argv[i], "--runs") == 0)
+            number = &opts.runs;
+        else if(strcmp(argv[i], "--jobs") == 0)
+            number = &opts.jobs;
+        else if(strcmp(argv[i], "--keep") == 0)
+            opts.keep = true;
+        else if(strcmp(argv[i], "--trace") == 0)
+            opts.trace = true;
+
+        else if(strcmp(argv[i], "--help") == 0)
+        {
+            usage();
+            return 0;
+        }
+
+        else
+        {
+            fprintf(stderr, "Unknown option: %s (see --help)\n", argv[i]);
+            return 1;
+        }
+
+        if( (value != NULL || number != NULL) && i + 1 >= argc)
+        {
+            fprintf(stderr, "Value expected after %s\n", argv[i]);
+            return 1;
+        }
+
+        if(value != NULL)
+            *value = argv[++i];
+
+        if(number != NULL && (*number = atoi(argv[++i])) < 0)
+        {
+            fprintf(stderr, "Bad value: %s %s\n", argv[i-1], argv[i]);
+            return 1;
+        }
+    }
+
+    if(opts.runs < 1)
+        opts.runs = 1;
+
+    if(opts.baseline == NULL)
+    {
+        snprintf(baseline, sizeof(baseline), "%.900s/baseline.tsv", opts.dir);
+        opts.baseline = baseline;
+    }
+
+    mkdir(opts.dir, 0777);
+
+    mgen_setMessageHandler(&ignoreMessage, NULL);
+
+
+    n = createCases(cases, sizeof(cases) / sizeof(cases[0]), &opts);
+
+    printf("m-gen benchmark - %d files, m-gen v%s, threads: %d\n\n", n, mgen_version(), opts.jobs);
+    printf("%-28s %8s %10s %9s %9s %9s %9s %10s %8s\n",
+            "case", "pins", ".gm [KB]", "open", "parse", "emit", "m-gen", "pins/s", "MB/s");
+    printf("%-28s %8s %10s %9s %9s %9s %9s\n", "", "", "", "[ms]", "[ms]", "[ms]", "[ms]");
+
+    for(int i=0; i<n; ++i)
+    {
+        GM_BENCH_CASE* c = &cases[i];
+
+        if(runCase(c, &opts) != 0)
+        {
+            ++failed;
+            continue;
+        }
+
+        printf("%-28s %8d %10.1f %9.3f %9.3f %9.3f %9.3f %10.0f %8.1f\n",
+                c->name, c->pins, c->gmBytes / 1024.0, c->open, c->parse, c->emit, c->e2e,
+                c->pins / (c->e2e / 1e3), c->hBytes / (c->e2e * 1e3));
+
+        fflush(stdout);
+    }
+
+
+    if(writeBaseline(cases, n, &opts) != 0)
+        return 1;
+
+    printf("\nBaseline: %s\n", opts.baseline);
+
+    if(opts.compare != NULL && compareBaseline(cases, n, opts.compare) != 0)
+        return 1;
+
+    return (failed > 0) ? 1 : 0;
+}
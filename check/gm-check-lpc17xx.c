@@ -0,0 +1,461 @@
+/*
+File:       gm-check-lpc17xx.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Host model of LPC17xx registers - compiled by gm-check ('make check')
+    with headers generated from the same pins:
+
+    lpc17xx_rmw_X.h - read-modify-write macros (default),
+    lpc17xx_bb_X.h - macros with '--bitband',
+
+    X - mode of all pins in header (i, o, d, l, h, b), every pin of P0 ... P4.
+
+Every function of every pin is called twice from the same (random) state of registers:
+    read-modify-write version and bit-band version - new state of registers
+    and result (of 'is...' functions) must be the same.
+
+Word of bit-band alias region is mapped back to its register (FIODIR, FIOPIN, PINMODE)
+    and bit - it is stored in 'aliasWord' and written back to bit of register
+    before next access to alias region and after every function.
+Writes to FIOSET / FIOCLR are applied to FIOPIN after every function (FIOMASK is always 0).
+
+Groups (lpc17xx_groups.def - written by gm-check): set(), clear(), write() and read() of both headers
+    are compared with model of FIOPIN - every pin of group is bit of value, other pins are not changed.
+    FIOPIN0 ... FIOPIN3, FIOPINL, FIOPINH are parts of FIOPIN (little endian host - as the MCU).
+*/
+
+#include <stdio.h>
+#include <stdlib.h> //rand(), exit()
+#include <string.h>
+#include <stdint.h>
+
+
+
+/* registers - the same layout as in LPC17xx.h */
+typedef struct{
+
+    volatile uint32_t FIODIR;
+    uint32_t RESERVED0[3];
+    volatile uint32_t FIOMASK;
+
+    union{
+
+        volatile uint32_t FIOPIN;
+
+        struct{
+            volatile uint16_t FIOPINL;
+            volatile uint16_t FIOPINH;
+        };
+
+        struct{
+            volatile uint8_t FIOPIN0;
+            volatile uint8_t FIOPIN1;
+            volatile uint8_t FIOPIN2;
+            volatile uint8_t FIOPIN3;
+        };
+    };
+
+    volatile uint32_t FIOSET;
+    volatile uint32_t FIOCLR;
+
+} CHECK_GPIO;
+
+
+typedef struct{
+
+    volatile uint32_t PINSEL[11];
+    uint32_t RESERVED0[5];
+    volatile uint32_t PINMODE0;
+    volatile uint32_t PINMODE1;
+    volatile uint32_t PINMODE2;
+    volatile uint32_t PINMODE3;
+    volatile uint32_t PINMODE4;
+    volatile uint32_t PINMODE5;
+    volatile uint32_t PINMODE6;
+    volatile uint32_t PINMODE7;
+    volatile uint32_t PINMODE8;
+    volatile uint32_t PINMODE9;
+
+} CHECK_PINCON;
+
+
+typedef struct{
+
+    CHECK_GPIO gpio[5];
+    CHECK_PINCON pincon;
+
+} CHECK_STATE;
+
+
+static CHECK_STATE regs;
+
+#define LPC_GPIO0   (&regs.gpio[0])
+#define LPC_GPIO1   (&regs.gpio[1])
+#define LPC_GPIO2   (&regs.gpio[2])
+#define LPC_GPIO3   (&regs.gpio[3])
+#define LPC_GPIO4   (&regs.gpio[4])
+#define LPC_PINCON  (&regs.pincon)
+
+
+/* addresses of registers in MCU */
+#define GPIO_BASE       (0x2009C000u)
+#define GPIO_SIZE       (0x20u)
+#define PINMODE_BASE    (0x4002C040u)
+#define PINMODE_NUM     (10)
+
+/* bit-band regions */
+#define SRAM_BASE       (0x20000000u)
+#define SRAM_ALIAS      (0x22000000u)
+#define PERIPH_BASE     (0x40000000u)
+#define PERIPH_ALIAS    (0x42000000u)
+
+
+
+/*-----------------------------------------------------------------------------------------------*/
+
+
+
+/* bit of register behind current word of alias region (NULL - none) */
+static volatile uint32_t* aliasReg;
+static int aliasBit;
+static uint32_t aliasWord;
+
+
+/* writes current word of alias region back to its bit of register */
+static void aliasFlush(void)
+{
+    if(aliasReg == NULL)
+        return;
+
+    if(aliasWord & 1)
+        *aliasReg |= (1u << aliasBit);
+    else
+        *aliasReg &= ~(1u << aliasBit);
+
+    aliasReg = NULL;
+}
+
+
+/* word of alias region - address is mapped back to register and bit */
+static uint32_t* alias(uint32_t address)
+{
+    uint32_t base = (address >= PERIPH_ALIAS) ? PERIPH_ALIAS : SRAM_ALIAS;
+    uint32_t reg = ((base == PERIPH_ALIAS) ? PERIPH_BASE : SRAM_BASE) + ((address - base) >> 7) * 4;
+
+    aliasFlush();
+
+    aliasBit = ((address - base) >> 2) & 31;
+
+    if(base == PERIPH_ALIAS && reg >= PINMODE_BASE && reg < PINMODE_BASE + PINMODE_NUM * 4)
+        aliasReg = &regs.pincon.PINMODE0 + (reg - PINMODE_BASE) / 4;
+
+    else if(base == SRAM_ALIAS && reg >= GPIO_BASE && reg < GPIO_BASE + 5 * GPIO_SIZE
+            && (reg % GPIO_SIZE == 0x00 || reg % GPIO_SIZE == 0x14))
+        aliasReg = (volatile uint32_t*) &regs.gpio[(reg - GPIO_BASE) / GPIO_SIZE] + (reg % GPIO_SIZE) / 4;
+
+    else
+    {
+        printf("Error: alias 0x%08x - register 0x%08x is not FIODIR, FIOPIN or PINMODE\n",
+                (unsigned) address, (unsigned) reg);
+        exit(1);
+    }
+
+    aliasWord = (*aliasReg >> aliasBit) & 1;
+
+    return &aliasWord;
+}
+
+#define gm_BITBAND(address)     (*alias(address))
+
+
+
+#include "lpc17xx_rmw_i.h"
+#include "lpc17xx_rmw_o.h"
+#include "lpc17xx_rmw_d.h"
+#include "lpc17xx_rmw_l.h"
+#include "lpc17xx_rmw_h.h"
+#include "lpc17xx_rmw_b.h"
+
+#include "lpc17xx_bb_i.h"
+#include "lpc17xx_bb_o.h"
+#include "lpc17xx_bb_d.h"
+#include "lpc17xx_bb_l.h"
+#include "lpc17xx_bb_h.h"
+#include "lpc17xx_bb_b.h"
+
+
+
+/*-----------------------------------------------------------------------------------------------*/
+
+
+
+static CHECK_STATE before;
+static CHECK_STATE expected;
+
+static int tests;
+static int fails;
+
+
+static uint32_t random32(void)
+{
+    return ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+}
+
+
+static void randomState(void)
+{
+    memset(&regs, 0, sizeof(regs));
+
+    for(int i=0; i<5; ++i)
+    {
+        regs.gpio[i].FIODIR = random32();
+        regs.gpio[i].FIOPIN = random32();
+    }
+
+    for(volatile uint32_t* reg = &regs.pincon.PINMODE0; reg <= &regs.pincon.PINMODE9; ++reg)
+        *reg = random32();
+
+    memcpy(&before, &regs, sizeof(regs));
+}
+
+
+/* end of function - alias region and FIOSET / FIOCLR are written to registers */
+static void settle(void)
+{
+    aliasFlush();
+
+    for(int i=0; i<5; ++i)
+    {
+        regs.gpio[i].FIOPIN = (regs.gpio[i].FIOPIN | regs.gpio[i].FIOSET) & ~regs.gpio[i].FIOCLR;
+        regs.gpio[i].FIOSET = 0;
+        regs.gpio[i].FIOCLR = 0;
+    }
+}
+
+
+/* registers must be the same as 'expected' (only the first failures are shown) */
+static void compare(int resultIsGood, const char* name)
+{
+    const char* reason = NULL;
+
+    ++tests;
+
+    if(memcmp(&regs, &expected, sizeof(regs)) != 0)
+        reason = "other state of registers";
+    else if(!resultIsGood)
+        reason = "other result";
+
+    if(reason != NULL && ++fails <= 20)
+        printf("Failed: %s - %s\n", name, reason);
+}
+
+
+
+/* function 'fn' of pin (prefix: rmw_ or bb_) - i. e. rmw_i0_5_dirIn */
+#define PIN_FN(prefix, mode, port, pin, fn)     prefix##mode##port##_##pin##_##fn
+
+
+#define CHECK_PROC(mode, port, pin, fn) \
+    do{ \
+        randomState(); \
+        PIN_FN(rmw_, mode, port, pin, fn)(); \
+        settle(); \
+        memcpy(&expected, &regs, sizeof(regs)); \
+        memcpy(&regs, &before, sizeof(regs)); \
+        PIN_FN(bb_, mode, port, pin, fn)(); \
+        settle(); \
+        compare(1, #mode #port "_" #pin "_" #fn); \
+    } while(0);
+
+
+#define CHECK_COND(mode, port, pin, fn) \
+    do{ \
+        int rmwResult, bbResult; \
+        randomState(); \
+        rmwResult = PIN_FN(rmw_, mode, port, pin, fn)(); \
+        settle(); \
+        memcpy(&expected, &regs, sizeof(regs)); \
+        memcpy(&regs, &before, sizeof(regs)); \
+        bbResult = PIN_FN(bb_, mode, port, pin, fn)(); \
+        settle(); \
+        compare(!rmwResult == !bbResult, #mode #port "_" #pin "_" #fn); \
+    } while(0);
+
+
+/* all functions of pin in every mode */
+#define CHECK_PIN(port, pin) \
+    CHECK_PROC(i, port, pin, dirIn) \
+    CHECK_COND(i, port, pin, isHigh) \
+    CHECK_COND(i, port, pin, isLow) \
+    CHECK_PROC(o, port, pin, dirOut) \
+    CHECK_PROC(o, port, pin, setHigh) \
+    CHECK_PROC(o, port, pin, setLow) \
+    CHECK_PROC(o, port, pin, toggle) \
+    CHECK_PROC(d, port, pin, init) \
+    CHECK_PROC(d, port, pin, dirIn) \
+    CHECK_PROC(d, port, pin, dirOut) \
+    CHECK_COND(d, port, pin, isHigh) \
+    CHECK_COND(d, port, pin, isLow) \
+    CHECK_PROC(d, port, pin, setHigh) \
+    CHECK_PROC(d, port, pin, setLow) \
+    CHECK_PROC(d, port, pin, toggle) \
+    CHECK_PROC(l, port, pin, On) \
+    CHECK_PROC(l, port, pin, Off) \
+    CHECK_PROC(l, port, pin, asOutput) \
+    CHECK_PROC(l, port, pin, toggle) \
+    CHECK_PROC(h, port, pin, On) \
+    CHECK_PROC(h, port, pin, Off) \
+    CHECK_PROC(h, port, pin, asOutput) \
+    CHECK_PROC(h, port, pin, toggle) \
+    CHECK_PROC(b, port, pin, asInput) \
+    CHECK_COND(b, port, pin, isActive) \
+    CHECK_COND(b, port, pin, isInactive)
+
+
+#define CHECK_PORT(port) \
+    CHECK_PIN(port, 0)  CHECK_PIN(port, 1)  CHECK_PIN(port, 2)  CHECK_PIN(port, 3) \
+    CHECK_PIN(port, 4)  CHECK_PIN(port, 5)  CHECK_PIN(port, 6)  CHECK_PIN(port, 7) \
+    CHECK_PIN(port, 8)  CHECK_PIN(port, 9)  CHECK_PIN(port, 10) CHECK_PIN(port, 11) \
+    CHECK_PIN(port, 12) CHECK_PIN(port, 13) CHECK_PIN(port, 14) CHECK_PIN(port, 15) \
+    CHECK_PIN(port, 16) CHECK_PIN(port, 17) CHECK_PIN(port, 18) CHECK_PIN(port, 19) \
+    CHECK_PIN(port, 20) CHECK_PIN(port, 21) CHECK_PIN(port, 22) CHECK_PIN(port, 23) \
+    CHECK_PIN(port, 24) CHECK_PIN(port, 25) CHECK_PIN(port, 26) CHECK_PIN(port, 27) \
+    CHECK_PIN(port, 28) CHECK_PIN(port, 29) CHECK_PIN(port, 30) CHECK_PIN(port, 31)
+
+
+
+static void checkPins(void)
+{
+    CHECK_PORT(0)
+    CHECK_PORT(1)
+    CHECK_PORT(2)
+    CHECK_PORT(3)
+    CHECK_PORT(4)
+}
+
+
+
+/*-----------------------------------------------------------------------------------------------*/
+
+
+
+/* 'expected' - state after set ('s'), clear ('c') or write ('w') of group from state 'before' */
+static void expectGroup(const int* pins, int count, char fn, uint32_t arg)
+{
+    memcpy(&expected, &before, sizeof(before));
+
+    for(int i=0; i<count; ++i)
+    {
+        volatile uint32_t* fiopin = &expected.gpio[pins[i] / 32].FIOPIN;
+        uint32_t bit = 1u << (pins[i] % 32);
+        int value = (arg >> i) & 1;
+
+        if(value && fn != 'c')
+            *fiopin |= bit;
+        else if((value && fn == 'c') || (!value && fn == 'w'))
+            *fiopin &= ~bit;
+    }
+}
+
+
+/* value of group in state 'before' */
+static uint32_t groupValue(const int* pins, int count)
+{
+    uint32_t value = 0;
+
+    for(int i=0; i<count; ++i)
+        value |= ((before.gpio[pins[i] / 32].FIOPIN >> (pins[i] % 32)) & 1) << i;
+
+    return value;
+}
+
+
+#define PINS_NUM(pins)      ((int) (sizeof(pins) / sizeof(pins[0])))
+
+
+/* set(), clear(), write() - argument must be evaluated once */
+#define CHECK_GROUP_WRITE(prefix, name, fn, pins) \
+    do{ \
+        uint32_t arg = random32(); \
+        int calls = 0; \
+        randomState(); \
+        prefix##name##_##fn((++calls, arg)); \
+        settle(); \
+        expectGroup(pins, PINS_NUM(pins), #fn[0], arg); \
+        compare(calls == 1, #prefix #name "_" #fn); \
+    } while(0);
+
+
+#define CHECK_GROUP_READ(prefix, name, pins) \
+    do{ \
+        uint32_t result; \
+        randomState(); \
+        result = prefix##name##_read(); \
+        settle(); \
+        memcpy(&expected, &before, sizeof(before)); \
+        compare(result == groupValue(pins, PINS_NUM(pins)), #prefix #name "_read"); \
+    } while(0);
+
+
+#define CHECK_GROUP_OF(prefix, name, pins) \
+    CHECK_GROUP_WRITE(prefix, name, set, pins) \
+    CHECK_GROUP_WRITE(prefix, name, clear, pins) \
+    CHECK_GROUP_WRITE(prefix, name, write, pins) \
+    CHECK_GROUP_READ(prefix, name, pins)
+
+
+/* group from lpc17xx_groups.def - pins: port * 32 + pin, the first one is bit 0 */
+#define CHECK_GROUP(name, ...) \
+    { \
+        static const int pins[] = { __VA_ARGS__ }; \
+        CHECK_GROUP_OF(rmw_, name, pins) \
+        CHECK_GROUP_OF(bb_, name, pins) \
+    }
+
+
+
+static void checkGroups(void)
+{
+#include "lpc17xx_groups.def"
+}
+
+
+
+int main(void)
+{
+    // every function from a few random states
+    for(int i=0; i<4; ++i)
+        checkPins();
+
+    for(int i=0; i<1000; ++i)
+        checkGroups();
+
+    printf("lpc17xx: %d checks, %d failed\n", tests, fails);
+
+    return (fails > 0) ? 1 : 0;
+}
@@ -0,0 +1,408 @@
+/*
+File:       gm-check.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+m-gen checks ('make check') - generated macros are compiled for host
+    and run on models of registers:
+
+    - lpc17xx '--bitband': every pin of P0 ... P4 in every mode (gm-check-lpc17xx.c),
+        result must be the same as of read-modify-write macros,
+    - lpc17xx groups: set / clear / write / read of byte, half-word and full-port groups
+        (FIOPIN0 ... FIOPIN3, FIOPINL, FIOPINH, FIOPIN) and of other ones (FIOSET / FIOCLR),
+    - for every variant of flags: macros, inline functions (-I), atomic mode (-a), ...
+
+.gm files are converted in memory by libmgen, headers and programs are written to '--dir'.
+
+POSIX only (system()).
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h> //system()
+#include <string.h>
+#include <sys/stat.h>   //mkdir()
+
+#include "m-gen.h"
+#include "gm-output.h"
+#include "libmgen.h"
+
+
+
+typedef struct{
+
+    const char* compiler;
+    const char* src;    // directory of models (gm-check-*.c)
+    const char* dir;    // output directory
+
+} GM_CHECK_OPTIONS;
+
+
+/* variants of flags */
+static const struct{
+
+    const char* name;
+    MGEN_OPTIONS options;
+
+} variants[] = {
+
+    { "macros",         { .compatibilityMode = 0, .inlineFunc = 0, .atomicMode = 0 } },
+    { "inline",         { .compatibilityMode = 0, .inlineFunc = 1, .atomicMode = 0 } },
+    { "atomic",         { .compatibilityMode = 0, .inlineFunc = 0, .atomicMode = 1 } },
+    { "inline-atomic",  { .compatibilityMode = 0, .inlineFunc = 1, .atomicMode = 1 } }
+};
+
+#define VARIANTS_NUM    ((int) (sizeof(variants) / sizeof(variants[0])))
+
+
+static const char pinModes[] = "iodlhb";
+
+
+/* groups of lpc17xx (written to .gm file of pins in 'mode'):
+    pins - "port.pin" or "port.first-last" (also descending), the first pin is bit 0 */
+static const struct{
+
+    char mode;
+    const char* name;
+    const char* pins;
+
+} groups[] = {
+
+    { 'o', "byte1",         "0.8-15" },
+    { 'o', "byte3Reversed", "0.31-24" },
+    { 'o', "byte0",         "3.0-7" },
+    { 'o', "halfUpper",     "2.16-31" },
+    { 'o', "halfLower",     "1.0-15" },
+    { 'o', "unaligned",     "4.4-11" },
+    { 'o', "mixed",         "1.16-23 4.0-1 3.16-31" },
+    { 'o', "byteAndRmw",    "0.0-7 4.12-19" },
+    { 'o', "hole",          "2.0-6" },
+    { 'o', "shifted",       "4.30 1.24-31" },
+    { 'd', "full",          "2.0-31" },
+    { 'd', "fullReversed",  "3.31-0" }
+};
+
+#define GROUPS_NUM  ((int) (sizeof(groups) / sizeof(groups[0])))
+
+
+
+/*-----------------------------------------------------------------------------------------------*/
+
+
+
+static void usage(void)
+{
+    printf(
+        "m-gen checks - generated macros compared on host models of registers\n"
+        "\n"
+        "Usage: gm-check [options]\n"
+        "    --cc COMMAND    compiler of models (default: gcc)\n"
+        "    --src DIR       directory of models (default: check)\n"
+        "    --dir DIR       output directory (default: check/out)\n"
+        "    --help\n"
+    );
+}
+
+
+
+/* pins of group (port * 32 + pin) - returns number of pins */
+static int groupPins(const char* pins, int* out, int max)
+{
+    int n = 0;
+    int port, first, last, length;
+
+    while(sscanf(pins, " %d.%d%n", &port, &first, &length) == 2)
+    {
+        pins += length;
+        last = first;
+
+        if(*pins == '-' && sscanf(pins, "-%d%n", &last, &length) == 1)
+            pins += length;
+
+        for(int pin = first; ; pin += (last < first) ? -1 : 1)
+        {
+            if(n < max)
+                out[n++] = port * 32 + pin;
+
+            if(pin == last)
+                break;
+        }
+    }
+
+    return n;
+}
+
+
+
+/* .gm file - all pins of P0 ... P4 in one mode and groups of them, names: i. e. 'rmw_d3_17', 'rmw_full' */
+static void createInput(GM_BUF* out, char mode, const char* prefix)
+{
+    int pins[32];
+
+    bufPrintf(out, "$t\nlpc17xx\n\n$c\nAll pins in mode '%c'\n    generated by gm-check\n", mode);
+
+    bufPrintf(out, "\n$m\nMode PORT PIN Name Comment\n\n");
+
+    for(int port=0; port<5; ++port)
+    {
+        for(int pin=0; pin<32; ++pin)
+            bufPrintf(out, "%c\t%d\t%d\t%s%c%d_%d\tP%d.%d\n", mode, port, pin, prefix, mode, port, pin, port, pin);
+    }
+
+    bufPrintf(out, "\n$g\nName Pins\n\n");
+
+    for(int i=0; i<GROUPS_NUM; ++i)
+    {
+        int n;
+
+        if(groups[i].mode != mode)
+            continue;
+
+        n = groupPins(groups[i].pins, pins, 32);
+
+        bufPrintf(out, "%s%s", prefix, groups[i].name);
+
+        for(int j=0; j<n; ++j)
+            bufPrintf(out, "\t%s%c%d_%d", prefix, mode, pins[j] / 32, pins[j] % 32);
+
+        bufPutc(out, '\n');
+    }
+}
+
+
+
+/* 'dir/lpc17xx_groups.def' - for model: CHECK_GROUP(name, pins (port * 32 + pin) ...) */
+static int writeGroups(const GM_CHECK_OPTIONS* opts)
+{
+    GM_BUF def;
+    char path[1024];
+    int pins[32];
+    int retval = 0;
+
+    bufInit(&def);
+
+    bufPrintf(&def, "/* generated by gm-check */\n\n");
+
+    for(int i=0; i<GROUPS_NUM; ++i)
+    {
+        int n = groupPins(groups[i].pins, pins, 32);
+
+        bufPrintf(&def, "CHECK_GROUP(%s", groups[i].name);
+
+        for(int j=0; j<n; ++j)
+            bufPrintf(&def, ", %d", pins[j]);
+
+        bufPrintf(&def, ")\n");
+    }
+
+    snprintf(path, sizeof(path), "%.900s/lpc17xx_groups.def", opts->dir);
+
+    if(def.error || writeOutput(&def, path, NULL) != 0)
+    {
+        fprintf(stderr, "%s: cannot write file\n", path);
+        retval = -1;
+    }
+
+    bufFree(&def);
+
+    return retval;
+}
+
+
+
+/* header 'dir/lpc17xx_PREFIXMODE.h' (prefix without '_') */
+static int generateHeader(const GM_CHECK_OPTIONS* opts, const MGEN_OPTIONS* flags, char mode, const char* prefix)
+{
+    GM_BUF gm;
+    GM_BUF header;
+    char name[64];
+    char path[1024];
+    char* data = NULL;
+    size_t size = 0;
+    int retval = 0;
+
+    bufInit(&gm);
+    bufInit(&header);
+
+    createInput(&gm, mode, prefix);
+
+    snprintf(name, sizeof(name), "lpc17xx_%.*s_%c.h", (int) strlen(prefix) - 1, prefix, mode);
+    snprintf(path, sizeof(path), "%.900s/%s", opts->dir, name);
+
+    if(gm.error || mgen_generate(gm.data, gm.size, flags, name, &data, &size) != 0)
+    {
+        fprintf(stderr, "%s: m-gen failed\n", name);
+        retval = -1;
+    }
+
+    // bit-band headers never use read-modify-write of FIODIR / PINMODE
+    else if(flags->bitbandMode && (strstr(data, "->FIODIR") != NULL || strstr(data, "->PINMODE") != NULL))
+    {
+        fprintf(stderr, "%s: read-modify-write of FIODIR / PINMODE in '--bitband' mode\n", name);
+        retval = -1;
+    }
+
+    else
+    {
+        bufWrite(&header, data, size);
+
+        if(header.error || writeOutput(&header, path, NULL) != 0)
+        {
+            fprintf(stderr, "%s: cannot write file\n", path);
+            retval = -1;
+        }
+    }
+
+    mgen_free(data);
+    bufFree(&header);
+    bufFree(&gm);
+
+    return retval;
+}
+
+
+
+/* compiles and runs model 'src/gm-check-TARGET.c' */
+static int runModel(const GM_CHECK_OPTIONS* opts, const char* target)
+{
+    GM_BUF cmd;
+    int retval = 0;
+
+    bufInit(&cmd);
+
+    bufPrintf(&cmd, "%s -std=gnu99 -Wall -Wextra -Werror -I\"%s\" \"%s/gm-check-%s.c\" -o \"%s/gm-check-%s\"",
+            opts->compiler, opts->dir, opts->src, target, opts->dir, target);
+
+    bufPrintf(&cmd, " && \"%s/gm-check-%s\"", opts->dir, target);
+    bufPutc(&cmd, '\0');
+
+    if(cmd.error || system(cmd.data) != 0)
+    {
+        fprintf(stderr, "%s: model failed\n    %s\n", target, cmd.error ? "" : cmd.data);
+        retval = -1;
+    }
+
+    bufFree(&cmd);
+
+    return retval;
+}
+
+
+
+/* lpc17xx: '--bitband' against read-modify-write macros, groups against model of FIOPIN */
+static int checkLpc17xx(const GM_CHECK_OPTIONS* opts, const MGEN_OPTIONS* flags)
+{
+    MGEN_OPTIONS rmw = *flags;
+    MGEN_OPTIONS bitband = *flags;
+
+    rmw.bitbandMode = 0;
+    bitband.bitbandMode = 1;
+
+    for(const char* mode = pinModes; *mode; ++mode)
+    {
+        if(generateHeader(opts, &rmw, *mode, "rmw_") != 0
+            || generateHeader(opts, &bitband, *mode, "bb_") != 0)
+            return -1;
+    }
+
+    if(writeGroups(opts) != 0)
+        return -1;
+
+    return runModel(opts, "lpc17xx");
+}
+
+
+
+/*-----------------------------------------------------------------------------------------------*/
+
+
+
+int main(int argc, char* argv[])
+{
+    int failed = 0;
+
+    GM_CHECK_OPTIONS opts = {
+        .compiler = "gcc",
+        .src = "check",
+        .dir = "check/out"
+    };
+
+
+    for(int i=1; i<argc; ++i)
+    {
+        const char** value = NULL;
+
+        if(strcmp(argv[i], "--cc") == 0)
+            value = &opts.compiler;
+        else if(strcmp(argv[i], "--src") == 0)
+            value = &opts.src;
+        else if(strcmp(argv[i], "--dir") == 0)
+            value = &opts.dir;
+
+        else if(strcmp(argv[i], "--help") == 0)
+        {
+            usage();
+            return 0;
+        }
+
+        else
+        {
+            fprintf(stderr, "Unknown option: %s (see --help)\n", argv[i]);
+            return 1;
+        }
+
+        if(i + 1 >= argc)
+        {
+            fprintf(stderr, "Value expected after %s\n", argv[i]);
+            return 1;
+        }
+
+        *value = argv[++i];
+    }
+
+
+    mkdir(opts.dir, 0777);
+
+    // notes and warnings are shown - generated .gm files should not have any
+    mgen_setSilentLevel(MGEN_NOTE);
+
+    printf("m-gen checks - m-gen v%s\n\n", mgen_version());
+
+    for(int i=0; i<VARIANTS_NUM; ++i)
+    {
+        printf("%s:\n", variants[i].name);
+        fflush(stdout);
+
+        if(checkLpc17xx(&opts, &variants[i].options) != 0)
+            ++failed;
+    }
+
+    printf("\n%s\n", (failed > 0) ? "FAILED" : "All checks passed");
+
+    return (failed > 0) ? 1 : 0;
+}
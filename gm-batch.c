@@ -0,0 +1,564 @@
+/*
+File:       gm-batch.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#define _POSIX_C_SOURCE 200809L     // pthreads, opendir(), fcntl()
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), realloc(), qsort()
+#include <string.h>
+#include <errno.h>
+
+#include "m-gen.h"
+#include "gm-batch.h"
+
+
+#if defined __unix__ || defined __APPLE__
+  #include <unistd.h>
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <dirent.h>
+  #include <pthread.h>
+  #include <sys/stat.h>
+
+  #define GM_HAVE_THREADS
+#endif
+
+
+
+
+/*---------------------------------------------------*/
+
+void fileListInit(GM_FILE_LIST* list)
+{
+    list->paths = NULL;
+    list->num = 0;
+    list->capacity = 0;
+}
+
+
+
+void fileListFree(GM_FILE_LIST* list)
+{
+    for(int i=0; i<list->num; ++i)
+        free(list->paths[i]);
+
+    free(list->paths);
+
+    fileListInit(list);
+}
+
+
+
+/*---------------------------------------------------*/
+
+// copies path to the end of list
+static int appendPath(GM_FILE_LIST* list, const char* path)
+{
+    if(list->num == list->capacity)
+    {
+        int capacity = (list->capacity == 0) ? 64 : 2 * list->capacity;
+        char** paths = realloc(list->paths, capacity * sizeof(char*));
+
+        if(paths == NULL)
+            return -1;
+
+        list->paths = paths;
+        list->capacity = capacity;
+    }
+
+    list->paths[list->num] = malloc(strlen(path) + 1);
+
+    if(list->paths[list->num] == NULL)
+        return -1;
+
+    strcpy(list->paths[list->num++], path);
+
+    return 0;
+}
+
+
+
+static int comparePaths(const void* a, const void* b)
+{
+    return strcmp(*(char* const*) a, *(char* const*) b);
+}
+
+
+
+/*---------------------------------------------------*/
+
+#ifdef GM_HAVE_THREADS
+
+// all .gm files from directory and subdirectories
+static int addDirectory(GM_FILE_LIST* list, const char* dir)
+{
+    DIR* d = opendir(dir);
+    struct dirent* entry;
+    int retval = 0;
+
+
+    if(d == NULL)
+    {
+        perror(dir);
+        return -1;
+    }
+
+    while( retval == 0  &&  (entry = readdir(d)) != NULL )
+    {
+        struct stat st;
+        size_t len = strlen(entry->d_name);
+        char* path;
+
+
+        // hidden files, "." and ".."
+        if(entry->d_name[0] == '.')
+            continue;
+
+        path = malloc(strlen(dir) + len + 2);
+
+        if(path == NULL)
+        {
+            message(ERR, "Out of memory\n");
+            retval = -1;
+            break;
+        }
+
+        sprintf(path, "%s/%s", dir, entry->d_name);
+
+
+        if(stat(path, &st) == 0)
+        {
+            if(S_ISDIR(st.st_mode))
+                retval = addDirectory(list, path);
+
+            else if(len > 3  &&  strcmp(entry->d_name + len - 3, ".gm") == 0)
+            {
+                if(appendPath(list, path) != 0)
+                {
+                    message(ERR, "Out of memory\n");
+                    retval = -1;
+                }
+            }
+        }
+
+        free(path);
+    }
+
+    closedir(d);
+
+    return retval;
+}
+
+#endif  // GM_HAVE_THREADS
+
+
+
+/*---------------------------------------------------*/
+
+int pathIsDirectory(const char* path)
+{
+#ifdef GM_HAVE_THREADS
+    struct stat st;
+
+    return stat(path, &st) == 0  &&  S_ISDIR(st.st_mode);
+#else
+    (void) path;
+
+    return 0;
+#endif
+}
+
+
+
+/*---------------------------------------------------*/
+
+int fileListAdd(GM_FILE_LIST* list, const char* path)
+{
+#ifdef GM_HAVE_THREADS
+    if(pathIsDirectory(path))
+    {
+        int first = list->num;
+
+        // trailing '/' is not needed
+        char* dir = malloc(strlen(path) + 1);
+
+        if(dir == NULL)
+        {
+            message(ERR, "Out of memory\n");
+            return -1;
+        }
+
+        strcpy(dir, path);
+
+        for(size_t len = strlen(dir); len > 1 && dir[len-1] == '/'; --len)
+            dir[len-1] = 0;
+
+
+        if(addDirectory(list, dir) != 0)
+        {
+            free(dir);
+            return -1;
+        }
+
+        free(dir);
+
+        if(list->num == first)
+            message(WARN, "No .gm files in %s\n", path);
+
+        // always the same order
+        qsort(list->paths + first, list->num - first, sizeof(char*), &comparePaths);
+
+        return 0;
+    }
+#endif
+
+    if(appendPath(list, path) != 0)
+    {
+        message(ERR, "Out of memory\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+#ifdef GM_HAVE_THREADS
+
+
+/*
+GNU make jobserver - pipe (or fifo) with tokens (one byte = one job).
+Every process has one free token, next ones must be read from pipe
+    and written back after job.
+*/
+typedef struct{
+
+    int readFd;     // -1 if there is no jobserver
+    int writeFd;
+    int ownFds;     // 1 if fifo was opened by m-gen
+
+} GM_JOBSERVER;
+
+
+static int fdIsValid(int fd)
+{
+    return fd >= 0 && fcntl(fd, F_GETFD) != -1;
+}
+
+
+/*
+Reads jobserver from MAKEFLAGS:
+    --jobserver-auth=R,W        (make 4.2+, old: --jobserver-fds=R,W)
+    --jobserver-auth=fifo:PATH  (make 4.4+)
+*/
+static void jobserverOpen(GM_JOBSERVER* js)
+{
+    const char* flags = getenv("MAKEFLAGS");
+    const char* auth = NULL;
+    const char* p;
+
+    js->readFd = -1;
+    js->writeFd = -1;
+    js->ownFds = 0;
+
+    if(flags == NULL)
+        return;
+
+
+    // last one is valid
+    for(p = flags; (p = strstr(p, "--jobserver-")) != NULL; ++p)
+    {
+        if(strncmp(p, "--jobserver-auth=", 17) == 0)
+            auth = p + 17;
+        else if(strncmp(p, "--jobserver-fds=", 16) == 0)
+            auth = p + 16;
+    }
+
+    if(auth == NULL)
+        return;
+
+
+    if(strncmp(auth, "fifo:", 5) == 0)
+    {
+        size_t len = strcspn(auth + 5, " ");
+        char* path = malloc(len + 1);
+
+        if(path == NULL)
+            return;
+
+        memcpy(path, auth + 5, len);
+        path[len] = 0;
+
+        js->readFd = open(path, O_RDWR);
+        js->writeFd = js->readFd;
+        js->ownFds = 1;
+
+        free(path);
+    }
+
+    else
+    {
+        int r, w;
+
+        if(sscanf(auth, "%d,%d", &r, &w) != 2)
+            return;
+
+        // recipe without '+' - make closes jobserver for it
+        if( ! fdIsValid(r) || ! fdIsValid(w) )
+            return;
+
+        js->readFd = r;
+        js->writeFd = w;
+    }
+}
+
+
+static void jobserverClose(GM_JOBSERVER* js)
+{
+    if(js->ownFds && js->readFd >= 0)
+        close(js->readFd);
+
+    js->readFd = -1;
+}
+
+
+// returns token (to give it back) or -1 in case of error (job is done without token)
+static int jobserverAcquire(const GM_JOBSERVER* js)
+{
+    unsigned char token;
+
+    for(;;)
+    {
+        long n = read(js->readFd, &token, 1);
+
+        if(n == 1)
+            return token;
+
+        if(n < 0 && errno == EINTR)
+            continue;
+
+        // non-blocking pipe - waiting for token
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            struct pollfd fd = { .fd = js->readFd, .events = POLLIN };
+
+            poll(&fd, 1, -1);
+            continue;
+        }
+
+        return -1;
+    }
+}
+
+
+static void jobserverRelease(const GM_JOBSERVER* js, int token)
+{
+    unsigned char c = (unsigned char) token;
+
+    if(token < 0)
+        return;
+
+    while(write(js->writeFd, &c, 1) < 0  &&  errno == EINTR)
+        ;
+}
+
+
+
+
+/*
+State of batch - shared by all threads
+*/
+typedef struct{
+
+    const GM_FILE_LIST* list;
+
+    GM_GENERATE_FN generate;
+    void* ctx;
+
+    GM_JOBSERVER jobserver;
+
+    pthread_mutex_t lock;
+    int next;       // next file from list
+    int errors;
+
+} GM_BATCH;
+
+
+typedef struct{
+
+    GM_BATCH* batch;
+    int freeToken;  // 1 - first thread uses token of m-gen process
+
+} GM_WORKER;
+
+
+
+static void* worker(void* arg)
+{
+    GM_WORKER* w = arg;
+    GM_BATCH* b = w->batch;
+
+    for(;;)
+    {
+        int file;
+        int token = -1;
+        int retval;
+
+        pthread_mutex_lock(&b->lock);
+        file = b->next++;
+        pthread_mutex_unlock(&b->lock);
+
+        if(file >= b->list->num)
+            break;
+
+
+        if( ! w->freeToken  &&  b->jobserver.readFd >= 0)
+            token = jobserverAcquire(&b->jobserver);
+
+        retval = b->generate(b->list->paths[file], b->ctx);
+
+        if( ! w->freeToken  &&  b->jobserver.readFd >= 0)
+            jobserverRelease(&b->jobserver, token);
+
+
+        if(retval != 0)
+        {
+            pthread_mutex_lock(&b->lock);
+            ++b->errors;
+            pthread_mutex_unlock(&b->lock);
+        }
+    }
+
+    return NULL;
+}
+
+
+
+int runBatch(const GM_FILE_LIST* list, int jobs, GM_GENERATE_FN generate, void* ctx)
+{
+    GM_BATCH batch = {
+        .list = list,
+        .generate = generate,
+        .ctx = ctx,
+        .next = 0,
+        .errors = 0
+    };
+
+    pthread_t* threads;
+    GM_WORKER* workers;
+    int started = 0;
+
+
+    if(jobs <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        jobs = (cpus > 0) ? (int) cpus : 1;
+    }
+
+    if(jobs > list->num)
+        jobs = list->num;
+
+    if(jobs <= 0)
+        return 0;
+
+
+    threads = malloc(jobs * sizeof(pthread_t));
+    workers = malloc(jobs * sizeof(GM_WORKER));
+
+    if(threads == NULL || workers == NULL)
+    {
+        free(threads);
+        free(workers);
+
+        message(ERR, "Out of memory\n");
+        return list->num;
+    }
+
+
+    pthread_mutex_init(&batch.lock, NULL);
+
+    jobserverOpen(&batch.jobserver);
+
+
+    for(int i=0; i<jobs; ++i)
+    {
+        workers[i].batch = &batch;
+        workers[i].freeToken = (i == 0);
+
+        if(pthread_create(&threads[i], NULL, &worker, &workers[i]) != 0)
+            break;
+
+        ++started;
+    }
+
+    // if no thread is started - everything in this thread
+    if(started == 0)
+    {
+        GM_WORKER w = { .batch = &batch, .freeToken = 1 };
+
+        worker(&w);
+    }
+
+    for(int i=0; i<started; ++i)
+        pthread_join(threads[i], NULL);
+
+
+    jobserverClose(&batch.jobserver);
+
+    pthread_mutex_destroy(&batch.lock);
+
+    free(threads);
+    free(workers);
+
+    return batch.errors;
+}
+
+
+
+#else   // GM_HAVE_THREADS
+
+
+int runBatch(const GM_FILE_LIST* list, int jobs, GM_GENERATE_FN generate, void* ctx)
+{
+    int errors = 0;
+
+    (void) jobs;
+
+    for(int i=0; i<list->num; ++i)
+    {
+        if(generate(list->paths[i], ctx) != 0)
+            ++errors;
+    }
+
+    return errors;
+}
+
+
+#endif  // GM_HAVE_THREADS
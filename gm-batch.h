@@ -0,0 +1,84 @@
+#ifndef GM_BATCH_H
+#define GM_BATCH_H
+
+/*
+File:       gm-batch.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Batch mode - many .gm files converted by many threads at once.
+*/
+
+
+
+/*
+List of input files (paths)
+*/
+typedef struct{
+
+    char** paths;
+    int num;
+    int capacity;
+
+} GM_FILE_LIST;
+
+
+void fileListInit(GM_FILE_LIST* list);
+
+void fileListFree(GM_FILE_LIST* list);
+
+
+/*
+Adds file to list
+    or all .gm files from directory (and its subdirectories) if path is a directory.
+Returns 0 if success
+    or -1 in case of error (message is printed).
+*/
+int fileListAdd(GM_FILE_LIST* list, const char* path);
+
+
+/*
+Returns 1 if path is a directory
+    or 0 if not (or directories are not supported).
+*/
+int pathIsDirectory(const char* path);
+
+
+
+/*
+Converts all files from list - 'generate' is called for each file (see GM_GENERATE_FN in m-gen.h)
+    by 'jobs' threads (0 - number of processors).
+If m-gen is started by GNU make with jobserver (i. e. 'make -j8'),
+    every thread except first one takes a token from make before each file,
+    so make and m-gen together run no more jobs than given by '-j'.
+Returns number of files with errors.
+*/
+int runBatch(const GM_FILE_LIST* list, int jobs, GM_GENERATE_FN generate, void* ctx);
+
+
+
+#endif // GM_BATCH_H
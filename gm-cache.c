@@ -0,0 +1,634 @@
+/*
+File:       gm-cache.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#define _POSIX_C_SOURCE 200809L     // pthreads, link(), fchmod()
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), realloc(), free(), qsort()
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "m-gen.h"
+#include "gm-common.h"
+#include "gm-output.h"
+#include "gm-cache.h"
+#include "libmgen.h"
+
+
+#if defined __unix__ || defined __APPLE__
+  #include <unistd.h>
+  #include <dirent.h>
+  #include <pthread.h>
+  #include <sys/stat.h>
+
+  #define GM_HAVE_CACHE
+#endif
+
+
+
+#ifdef GM_HAVE_CACHE
+
+
+#define GM_CACHE_DEFAULT_SIZE   (1024ULL * 1024 * 1024)
+
+/* after eviction, entries take max. 90% of limit - not every next header starts it again */
+#define GM_CACHE_LOW_PERCENT    (90)
+
+/* temporary files older than that are left by killed processes [s] */
+#define GM_CACHE_TEMP_AGE       (3600)
+
+/* eviction scans whole directory - it's started if size known since last scan is over limit,
+   or after this number of stores (other processes add entries too); the first one is random,
+   so many processes with few headers don't scan it every time */
+#define GM_CACHE_SCAN_STORES    (64)
+
+/* "HASH.h" */
+#define GM_CACHE_ENTRY_LENGTH   (MGEN_HASH_LENGTH - 1 + 2)
+
+/* "HASH.sum" - checksum of whole entry */
+#define GM_CACHE_SUM_LENGTH     (MGEN_HASH_LENGTH - 1 + 4)
+
+
+
+/* one entry - for eviction */
+typedef struct{
+
+    char name[GM_CACHE_ENTRY_LENGTH + 1];
+    unsigned long long size;
+    time_t used;
+
+} GM_CACHE_ENTRY;
+
+
+
+/* static variables */
+
+static const char* cacheDir = NULL;
+static unsigned long long cacheMaxSize = GM_CACHE_DEFAULT_SIZE;
+static bool cacheLink = false;
+
+// size of entries after last scan + size of stored ones since then
+static unsigned long long knownSize = 0;
+static bool sizeKnown = false;
+static unsigned storesToScan = 0;
+
+static pthread_mutex_t cacheMutex = PTHREAD_MUTEX_INITIALIZER;     // variables above
+static pthread_mutex_t evictMutex = PTHREAD_MUTEX_INITIALIZER;     // one scan at once
+
+
+
+
+/*---------------------------------------------------*/
+
+static void lock(void)
+{
+    pthread_mutex_lock(&cacheMutex);
+}
+
+
+static void unlock(void)
+{
+    pthread_mutex_unlock(&cacheMutex);
+}
+
+
+
+/* "dir/name" - allocated (NULL if out of memory) */
+static char* cachePath(const char* name)
+{
+    char* path = malloc(strlen(cacheDir) + strlen(name) + 2);
+
+    if(path != NULL)
+        sprintf(path, "%s/%s", cacheDir, name);
+
+    return path;
+}
+
+
+
+/* "dir/HASH.h" */
+static char* entryPath(const char* hash)
+{
+    char name[GM_CACHE_ENTRY_LENGTH + 1];
+
+    snprintf(name, sizeof(name), "%s.h", hash);
+
+    return cachePath(name);
+}
+
+
+/* "dir/HASH.sum" */
+static char* sumPath(const char* hash)
+{
+    char name[GM_CACHE_SUM_LENGTH + 1];
+
+    snprintf(name, sizeof(name), "%s.sum", hash);
+
+    return cachePath(name);
+}
+
+
+
+/* "HASH.h" (16 hex digits) */
+static bool isEntry(const char* name)
+{
+    if(strlen(name) != GM_CACHE_ENTRY_LENGTH || strcmp(&name[MGEN_HASH_LENGTH - 1], ".h") != 0)
+        return false;
+
+    return strspn(name, "0123456789abcdef") == MGEN_HASH_LENGTH - 1;
+}
+
+
+/* "HASH.sum" */
+static bool isSum(const char* name)
+{
+    if(strlen(name) != GM_CACHE_SUM_LENGTH || strcmp(&name[MGEN_HASH_LENGTH - 1], ".sum") != 0)
+        return false;
+
+    return strspn(name, "0123456789abcdef") == MGEN_HASH_LENGTH - 1;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int cacheEnable(const char* dir, unsigned long long maxSize, bool link)
+{
+    struct stat st;
+
+    if(mkdir(dir, 0777) != 0 && errno != EEXIST)
+    {
+        perror(dir);
+        return -1;
+    }
+
+    if(stat(dir, &st) != 0 || S_ISDIR(st.st_mode) == 0 || access(dir, W_OK) != 0)
+    {
+        message(ERR, "Cache directory is not writable: %s\n", dir);
+        return -1;
+    }
+
+    cacheDir = dir;
+    cacheMaxSize = maxSize ? maxSize : GM_CACHE_DEFAULT_SIZE;
+    cacheLink = link;
+
+    storesToScan = (unsigned) (getpid() ^ time(NULL)) % GM_CACHE_SCAN_STORES;
+
+    return 0;
+}
+
+
+
+bool cacheEnabled(void)
+{
+    return cacheDir != NULL;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+/*
+Checksum of whole file (MGEN_HASH_LENGTH chars: hex + '\0').
+Returns 0 or -1 if file can't be read.
+*/
+static int fileChecksum(const char* path, char* sum)
+{
+    unsigned long long h = GM_HASH_INIT;
+    char chunk[65536];
+    size_t len;
+    int retval;
+    FILE* fp = fopen(path, "rb");
+
+    if(fp == NULL)
+        return -1;
+
+    while( (len = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+        h = hashData(h, chunk, len);
+
+    retval = ferror(fp) ? -1 : 0;
+
+    fclose(fp);
+
+    snprintf(sum, MGEN_HASH_LENGTH, "%016llx", h);
+
+    return retval;
+}
+
+
+
+/*
+Checksum stored with entry ("HASH.sum").
+Returns 0 or -1 if there isn't any.
+*/
+static int readChecksum(const char* hash, char* sum)
+{
+    char* path = sumPath(hash);
+    FILE* fp = (path != NULL) ? fopen(path, "rb") : NULL;
+    size_t len = 0;
+
+    if(fp != NULL)
+    {
+        len = fread(sum, 1, MGEN_HASH_LENGTH - 1, fp);
+        fclose(fp);
+    }
+
+    free(path);
+
+    sum[len] = '\0';
+
+    return (len == MGEN_HASH_LENGTH - 1) ? 0 : -1;
+}
+
+
+
+/* entry and its checksum */
+static void removeEntry(const char* hash)
+{
+    char* path = entryPath(hash);
+    char* sum = sumPath(hash);
+
+    if(path != NULL)
+        remove(path);
+
+    if(sum != NULL)
+        remove(sum);
+
+    free(path);
+    free(sum);
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+Time of last use of entry is its ctime (status change):
+    - new entry and hard link (link count) change it,
+    - copied entry - chmod() with the same mode changes it.
+(mtime is not touched - hard-linked headers are the same files, make would rebuild them)
+*/
+static void touchEntry(FILE* fp)
+{
+    struct stat st;
+
+    if(fstat(fileno(fp), &st) == 0)
+        fchmod(fileno(fp), st.st_mode & 07777);
+}
+
+
+
+int cacheFetch(const char* hash, const char* filename, const char* backupName)
+{
+    char storedSum[MGEN_HASH_LENGTH];
+    char sum[MGEN_HASH_LENGTH];
+    char* path;
+    FILE* fp;
+    GM_OUTPUT out;
+    int retval = -1;
+
+
+    if(cacheDir == NULL || (path = entryPath(hash)) == NULL)
+        return -1;
+
+    // entry (or its checksum) isn't there
+    if(readChecksum(hash, storedSum) != 0 || fileChecksum(path, sum) != 0)
+    {
+        free(path);
+        return -1;
+    }
+
+    // whole entry was changed (i. e. hard-linked header edited in place) - it's generated again
+    if(strcmp(sum, storedSum) != 0)
+    {
+        removeEntry(hash);
+        free(path);
+        return -1;
+    }
+
+
+    if(cacheLink && outputOpenLink(&out, filename, path) == 0)
+    {
+        retval = outputCommit(&out, backupName);
+    }
+
+    // copy (also if entry is on other filesystem than header)
+    else if( (fp = fopen(path, "rb")) != NULL)
+    {
+        touchEntry(fp);
+
+        if(outputOpen(&out, filename) == 0)
+        {
+            char chunk[65536];
+            size_t len;
+
+            while( (len = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+                outputWrite(chunk, len, &out);
+
+            if(ferror(fp))
+                outputAbort(&out);
+            else
+                retval = outputCommit(&out, backupName);
+        }
+
+        fclose(fp);
+    }
+
+    free(path);
+
+    return retval;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+static int compareEntries(const void* a, const void* b)
+{
+    time_t x = ((const GM_CACHE_ENTRY*) a)->used;
+    time_t y = ((const GM_CACHE_ENTRY*) b)->used;
+
+    return (x > y) - (x < y);
+}
+
+
+
+/*
+Removes least recently used entries if all of them take more than limit
+(and temporary files of killed processes). Other processes can do the same
+at once - files which are already removed are skipped.
+Other threads don't wait for it - they skip it.
+*/
+static void evict(void)
+{
+    DIR* dir;
+    struct dirent* de;
+
+    GM_CACHE_ENTRY* entries = NULL;
+    int entriesNum = 0;
+    int capacity = 0;
+
+    unsigned long long sum = 0;
+    time_t now = time(NULL);
+
+
+    if(pthread_mutex_trylock(&evictMutex) != 0)
+        return;
+
+    if( (dir = opendir(cacheDir)) == NULL)
+    {
+        pthread_mutex_unlock(&evictMutex);
+        return;
+    }
+
+    while( (de = readdir(dir)) != NULL)
+    {
+        struct stat st;
+        char* path;
+        bool entry = isEntry(de->d_name);
+        bool checksum = isSum(de->d_name);
+
+        if(entry == false && checksum == false && strstr(de->d_name, ".m_gen.") == NULL)
+            continue;
+
+        if( (path = cachePath(de->d_name)) == NULL)
+            break;
+
+        // checksum without entry (entry removed while it was stored)
+        if(checksum)
+        {
+            char name[GM_CACHE_ENTRY_LENGTH + 1];
+            char* entryName;
+
+            snprintf(name, sizeof(name), "%.*s.h", MGEN_HASH_LENGTH - 1, de->d_name);
+
+            if( (entryName = cachePath(name)) != NULL && access(entryName, F_OK) != 0)
+                remove(path);
+
+            free(entryName);
+            free(path);
+            continue;
+        }
+
+        if(stat(path, &st) != 0)
+        {
+            free(path);
+            continue;
+        }
+
+        if(entry == false)
+        {
+            if(now - st.st_mtime > GM_CACHE_TEMP_AGE)
+                remove(path);
+
+            free(path);
+            continue;
+        }
+
+        free(path);
+
+
+        if(entriesNum == capacity)
+        {
+            int newCapacity = capacity ? 2 * capacity : 256;
+            GM_CACHE_ENTRY* p = realloc(entries, newCapacity * sizeof(GM_CACHE_ENTRY));
+
+            if(p == NULL)
+                break;
+
+            entries = p;
+            capacity = newCapacity;
+        }
+
+        strcpy(entries[entriesNum].name, de->d_name);
+        entries[entriesNum].size = st.st_size;
+        entries[entriesNum].used = st.st_ctime;
+        ++entriesNum;
+
+        sum += st.st_size;
+    }
+
+    closedir(dir);
+
+
+    if(sum > cacheMaxSize)
+    {
+        unsigned long long low = cacheMaxSize / 100 * GM_CACHE_LOW_PERCENT;
+
+        qsort(entries, entriesNum, sizeof(GM_CACHE_ENTRY), &compareEntries);
+
+        for(int i=0; i<entriesNum && sum > low; ++i)
+        {
+            // "HASH.h" -> "HASH"
+            entries[i].name[MGEN_HASH_LENGTH - 1] = '\0';
+
+            removeEntry(entries[i].name);
+
+            sum -= entries[i].size;
+        }
+    }
+
+    free(entries);
+
+
+    lock();
+
+    knownSize = sum;
+    sizeKnown = true;
+    storesToScan = GM_CACHE_SCAN_STORES;
+
+    unlock();
+
+    pthread_mutex_unlock(&evictMutex);
+}
+
+
+
+void cacheStore(const char* hash, const char* filename)
+{
+    char sum[MGEN_HASH_LENGTH];
+    char* path;
+    char* sumName;
+    FILE* fp;
+    GM_OUTPUT out;
+    struct stat st;
+    bool scan;
+
+
+    if(cacheDir == NULL || (path = entryPath(hash)) == NULL)
+        return;
+
+    // already stored by other process / thread (checksum is written after entry)
+    if(access(path, F_OK) == 0 && readChecksum(hash, sum) == 0)
+    {
+        free(path);
+        return;
+    }
+
+
+    if(cacheLink && outputOpenLink(&out, path, filename) == 0)
+    {
+        outputCommit(&out, NULL);
+    }
+
+    else if( (fp = fopen(filename, "rb")) != NULL)
+    {
+        if(outputOpen(&out, path) == 0)
+        {
+            char chunk[65536];
+            size_t len;
+
+            while( (len = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+                outputWrite(chunk, len, &out);
+
+            if(ferror(fp))
+                outputAbort(&out);
+            else
+                outputCommit(&out, NULL);
+        }
+
+        fclose(fp);
+    }
+
+
+    // checksum of whole entry - see cacheFetch()
+    if(fileChecksum(path, sum) == 0 && (sumName = sumPath(hash)) != NULL)
+    {
+        GM_BUF buf;
+
+        bufInit(&buf);
+        bufPuts(&buf, sum);
+
+        writeOutput(&buf, sumName, NULL);
+
+        bufFree(&buf);
+        free(sumName);
+    }
+
+
+    lock();
+
+    if(stat(path, &st) == 0)
+        knownSize += st.st_size;
+
+    scan = (sizeKnown && knownSize > cacheMaxSize) || storesToScan == 0;
+
+    if(storesToScan > 0)
+        --storesToScan;
+
+    unlock();
+
+    free(path);
+
+    if(scan)
+        evict();
+}
+
+
+
+#else   // GM_HAVE_CACHE
+
+
+int cacheEnable(const char* dir, unsigned long long maxSize, bool link)
+{
+    (void) dir;
+    (void) maxSize;
+    (void) link;
+
+    message(ERR, "'--cache' is supported only on POSIX systems\n");
+
+    return -1;
+}
+
+
+bool cacheEnabled(void)
+{
+    return false;
+}
+
+
+int cacheFetch(const char* hash, const char* filename, const char* backupName)
+{
+    (void) hash;
+    (void) filename;
+    (void) backupName;
+
+    return -1;
+}
+
+
+void cacheStore(const char* hash, const char* filename)
+{
+    (void) hash;
+    (void) filename;
+}
+
+
+#endif  // GM_HAVE_CACHE
@@ -0,0 +1,80 @@
+#ifndef GM_CACHE_H
+#define GM_CACHE_H
+
+/*
+File:       gm-cache.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Shared cache of generated headers ('--cache dir') - like ccache, for many builds
+of the same .gm files (CI, many boards, many working copies):
+    - key is hash of everything what affects output (see mgen_outputHash()),
+      entry is file "dir/HASH.h" - the same header as in output,
+      and "dir/HASH.sum" - checksum of whole entry: entry changed after it was stored
+      (i. e. hard-linked header edited in place) is removed instead of copied,
+    - on hit, header is copied (or hard-linked - '--cache-link') into place,
+      without parsing & emitting,
+    - entries are written to temporary files and renamed, so many processes
+      can use one cache directory at once,
+    - if entries take more than max. size, least recently used ones are removed
+      (directory is scanned only sometimes - cache can be a bit bigger for a moment).
+All functions can be called by many threads (batch mode).
+
+Needs: stdbool.h
+*/
+
+
+/*
+Enables cache:
+    dir - cache directory (created if it doesn't exist),
+    maxSize - max. size of all entries in bytes (0 - default: 1 GB),
+    link - headers are hard links to entries instead of copies
+        (faster, but headers must not be edited in place).
+Returns 0 or -1 (message is printed) - i. e. on systems without POSIX files.
+*/
+int cacheEnable(const char* dir, unsigned long long maxSize, bool link);
+
+bool cacheEnabled(void);
+
+
+/*
+Writes header with given hash (MGEN_HASH_LENGTH chars) from cache to 'filename'
+(existing file is renamed to 'backupName', if not NULL).
+Returns 0 (hit) or -1 (miss - header must be generated).
+*/
+int cacheFetch(const char* hash, const char* filename, const char* backupName);
+
+
+/*
+Stores header 'filename' (just written, with given hash) in cache.
+Errors are ignored - cache is only a shortcut.
+*/
+void cacheStore(const char* hash, const char* filename);
+
+
+
+#endif // GM_CACHE_H
@@ -25,43 +25,222 @@ with m-gen. If not, see
 */
 
 #include <stdio.h>
-#include <ctype.h>  //toupper()
+#include <string.h> //memchr()
+#include <ctype.h>  //toupper(), isspace()
 
+#include "m-gen.h"
 #include "gm-common.h"
 
 
 /*---------------------------------------------------*/
 
-int getActualLine(FILE* fp)
+void lexInit(GM_LEXER* lex, const char* pos, const char* end, int line, int column)
 {
-    int line = 1;
+    lex->pos = pos;
+    lex->end = end;
 
-    long position = ftell(fp);
+    lex->line = line;
+    lex->column = column;
 
+    lex->tokenLine = line;
+    lex->tokenColumn = column;
+}
+
+
+
+int lexReadWord(GM_LEXER* lex, GM_STR* word)
+{
+    const char* p = lex->pos;
+
+
+    // skipping whitespaces
+    while( p < lex->end && isspace((unsigned char) *p) )
+    {
+        if(*p == '\n')
+        {
+            ++lex->line;
+            lex->column = 1;
+        }
+        else
+            ++lex->column;
+
+        ++p;
+    }
+
+    lex->tokenLine = lex->line;
+    lex->tokenColumn = lex->column;
+
+    word->str = p;
+
+    while( p < lex->end && !isspace((unsigned char) *p) )
+        ++p;
+
+    word->len = (int) (p - word->str);
+
+    lex->column += word->len;
+    lex->pos = p;
+
+    return word->len;
+}
+
+
+
+/*
+Finds next token in line (between pos and eol) - skips spaces & tabs.
+Returns 1 if found, 0 if not
+*/
+static int nextToken(const char** pos, const char* eol, GM_STR* token)
+{
+    const char* p = *pos;
+
+    while( p < eol && isspace((unsigned char) *p) )
+        ++p;
+
+    token->str = p;
+
+    while( p < eol && !isspace((unsigned char) *p) )
+        ++p;
+
+    token->len = (int) (p - token->str);
+    *pos = p;
+
+    return token->len > 0;
+}
+
+
+
+int lexReadRow(GM_LEXER* lex, GM_ROW* row, int targetsNum)
+{
+    while(lex->pos < lex->end)
+    {
+        const char* p = lex->pos;
+
+        // end of line - memchr() is much faster than checking char by char
+        const char* eol = memchr(p, '\n', lex->end - p);
+        const char* next;
+
+        if(eol == NULL)
+            eol = next = lex->end;
+        else
+            next = eol + 1;
+
+
+        lex->tokenLine = lex->line;
+
+        // mode - first token in line
+        if( ! nextToken(&p, eol, &row->mode) )
+        {
+            // empty line
+            lex->pos = next;
+            ++lex->line;
+            lex->column = 1;
+            continue;
+        }
+
+        lex->tokenColumn = lex->column + (int) (row->mode.str - lex->pos);
+
+        // end of section
+        if(row->mode.str[0] == '$')
+            return 0;
+
+
+        row->line = lex->line;
+
+        for(int i=0; i<targetsNum; ++i)
+        {
+            if( ! nextToken(&p, eol, &row->port[i])
+                || ! nextToken(&p, eol, &row->pin[i]) )
+            {
+                lex->tokenColumn = lex->column + (int) (p - lex->pos);
+                return -1;
+            }
+        }
 
-    fseek(fp, 0, 0);
+        if( ! nextToken(&p, eol, &row->name) )
+        {
+            lex->tokenColumn = lex->column + (int) (p - lex->pos);
+            return -1;
+        }
 
-    while( ftell(fp) < position)
+        // comment - rest of line
+        row->comment.str = p;
+        row->comment.len = (int) (next - p);
+
+
+        lex->pos = next;
+        ++lex->line;
+        lex->column = 1;
+
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+void lexSkipLine(GM_LEXER* lex)
+{
+    const char* eol = memchr(lex->pos, '\n', lex->end - lex->pos);
+
+    if(eol == NULL)
     {
-        if(fgetc(fp) == '\n')
-            ++line;
+        lex->column += (int) (lex->end - lex->pos);
+        lex->pos = lex->end;
     }
 
+    else
+    {
+        lex->pos = eol + 1;
+        ++lex->line;
+        lex->column = 1;
+    }
+}
+
+
+
 
-    // TODO fix line counter
-    // target module reads file line by line (WITH '\n' ),
-    // NEXT process it - so when processing:
-    // actual line == processed line + 1 (but not always)
-    // so generateMacros() call getActualLine() when position in file is set at next line
-    // BUT when error occur in early stage of processing in target module, it's possible to call getActualLine()
-    // with position in CORRECT line.
-    line -=1;   // <- !!!
+/*---------------------------------------------------*/
+
+int strToInt(GM_STR str, int* value)
+{
+    int i = 0;
+    int sign = 1;
+    int val = 0;
+
+    if(str.len > 0 && (str.str[0] == '-' || str.str[0] == '+') )
+    {
+        if(str.str[0] == '-')
+            sign = -1;
 
-    return line;
+        ++i;
+    }
+
+    if(i >= str.len)
+        return -1;
+
+    for(; i<str.len; ++i)
+    {
+        if( ! isdigit((unsigned char) str.str[i]) || val > 100000000)
+            return -1;
+
+        val = val*10 + (str.str[i] - '0');
+    }
+
+    *value = sign * val;
+
+    return 0;
 }
 
 
 
+int strIsEqual(GM_STR str, const char* cstr)
+{
+    return ( (int) strlen(cstr) == str.len )
+            && ( memcmp(str.str, cstr, str.len) == 0 );
+}
+
+
 
 /*---------------------------------------------------*/
 
@@ -92,3 +271,18 @@ void strToLower(char* str)
 }
 
 
+
+/*---------------------------------------------------*/
+
+unsigned long long hashData(unsigned long long hash, const void* data, size_t size)
+{
+    const unsigned char* p = data;
+
+    for(size_t i=0; i<size; ++i)
+    {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
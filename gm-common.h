@@ -29,7 +29,50 @@ with m-gen. If not, see
 
 
 
-int getActualLine(FILE* fp);
+/*
+Lexer functions - see GM_LEXER in m-gen.h
+
+lexInit() - start reading from 'pos' to 'end',
+    line and column - position of 'pos' in file.
+*/
+void lexInit(GM_LEXER* lex, const char* pos, const char* end, int line, int column);
+
+/*
+Skips whitespaces (also new lines) and reads one word (as " %s" in scanf()).
+Returns length of word
+    or 0 if end of data is reached.
+*/
+int lexReadWord(GM_LEXER* lex, GM_STR* word);
+
+/*
+Reads one row (pin) from '$m' section - see GM_ROW in m-gen.h
+targetsNum - number of PORT & PIN column pairs.
+Empty lines are skipped.
+Returns 1 if row is read,
+    0 at the end of section (line beginning with '$') or end of file,
+    or -1 if row is incomplete (lex->tokenLine/tokenColumn - position of error).
+*/
+int lexReadRow(GM_LEXER* lex, GM_ROW* row, int targetsNum);
+
+/*
+Skips rest of actual line (with '\n')
+*/
+void lexSkipLine(GM_LEXER* lex);
+
+
+
+/*
+Converts string view into decimal number.
+Returns 0 if success
+    or -1 if it's not a number.
+*/
+int strToInt(GM_STR str, int* value);
+
+/*
+Returns 1 if string view is equal to given C string
+    or 0 if not.
+*/
+int strIsEqual(GM_STR str, const char* cstr);
 
 void strToUpper(char* str);
 
@@ -37,4 +80,15 @@ void strToLower(char* str);
 
 
 
+/*
+64-bit FNV-1a hash of data.
+First call with hash = GM_HASH_INIT, next ones with previous result
+    (many blocks are hashed as one).
+*/
+#define GM_HASH_INIT    14695981039346656037ull
+
+unsigned long long hashData(unsigned long long hash, const void* data, size_t size);
+
+
+
 #endif  // GM_COMMON_H
@@ -0,0 +1,681 @@
+/*
+File:       gm-document.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#include <stdio.h>
+#include <string.h> //memchr(), strlen()
+
+#include "m-gen.h"
+#include "gm-utils.h"
+#include "gm-common.h"
+#include "gm-output.h"
+#include "gm-table.h"
+#include "gm-emit.h"
+#include "gm-template.h"
+#include "gm-document.h"
+
+// targets:
+#include "avr.h"
+#include "lpc111x.h"
+#include "lpc17xx.h"
+
+
+
+
+// pointers to initializers
+static const TARGET_LABEL labels[HOW_MANY_TARGETS] = {
+
+    //AVR
+    [_AVR] = {
+        .name = "avr",
+        .getData = &avr_getData
+    },
+
+    [_LPC111X] = {
+        .name = "lpc111x",
+        .getData = &lpc111x_getData
+    },
+
+    [_LPC17XX] = {
+        .name = "lpc17xx",
+        .getData = &lpc17xx_getData
+    }
+
+    // next targets should be initialized here
+
+};
+/*
+This array contains references to supported targets.
+All operations on it must use following syntax:
+labels[_TARGETMACRO] or labels[TARGETS_enumeration]
+_TARGETMACRO is defined in m-gen.h file as a constans number.
+enumeration TARGETS - i. e. flags.target
+*/
+
+
+
+
+/*---------------------------------------------------*/
+
+const TARGET_LABEL* getTargetLabels(void)
+{
+    return labels;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+static int readTargets(const GM_SECTIONS* sections, TARGETS targets[])
+{
+    GM_LEXER lex;
+    GM_STR targetName;
+
+    int targetsNum = 0;
+
+
+    if( gotoSection(&lex, sections, 't') < 0) // go to start of '$t' section in .gm file
+        return -1;
+
+
+    // section ends at next '$'
+    while(lexReadWord(&lex, &targetName) > 0  &&  targetName.str[0] != '$')
+    {
+        TARGETS target = ANY;
+
+        for(int i=0; i<HOW_MANY_TARGETS; ++i)
+        {
+            if(strIsEqual(targetName, labels[i].name))
+                target = i;
+        }
+
+
+        if(target == ANY)
+        {
+            message(ERR, "Unknown target '%.*s'\n", GM_STR_ARG(targetName));
+            return -1;
+        }
+
+        for(int i=0; i<targetsNum; ++i)
+        {
+            if(targets[i] == target)
+            {
+                message(ERR, "Target '%s' is given twice\n", labels[target].name);
+                return -1;
+            }
+        }
+
+
+        targets[targetsNum++] = target;
+    }
+
+
+    if(targetsNum == 0)
+    {
+        message(ERR, "Target not specified in '$t' section\n");
+        return -1;
+    }
+
+    return targetsNum;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+static int createHeader(GM_BUF* out, const char* outputFileName, const char* hash, const GM_SECTIONS* sections,
+                        const TARGET_ATTRIBUTES* attrs, const GM_TABLE* table, const TARGET_FLAGS* fls, int threads)
+{
+    GM_LEXER lex;
+
+
+    /*
+        #ifndef NAME_H
+        #define NAME_H
+
+
+        ... at the end
+        #endif // NAME_H
+    */
+
+    bufPrintf(out, "#ifndef ");
+    createHeaderGuard(out, outputFileName);
+
+    bufPrintf(out, "\n#define ");
+    createHeaderGuard(out, outputFileName);
+
+    bufPrintf(out, "\n\n");
+
+
+    /*
+        "extern C" for C++
+        (for macros it doesn't matter, but for future implementation of functions ... )
+    */
+
+    bufPrintf(out, "#ifdef __cplusplus\n"
+                   "  extern \"C\" {\n"
+                   "#endif\n\n" );
+
+
+    /*
+        Preface
+    */
+    bufPrintf(out,
+         "/*\n"
+         "File auto-generated by m-gen v%s\n"
+         "    (see https://github.com/Leopardus4/m-gen )\n"
+         "\n"
+         "DO NOT EDIT THIS FILE!\n"
+         "Please edit apprioritate .gm file and run m-gen\n"
+         "\n"
+         GM_HASH_TAG "%s\n"
+         "*/\n\n", VERSION, hash);
+
+
+
+
+    /*
+        User's comment from .gm file
+    */
+
+    bufPrintf(out, "/*\n");
+
+    {
+        const char* p;
+        const char* d;
+
+        if(gotoSection(&lex, sections, 'c') < 0)
+            return 1;
+
+        p = lex.pos;
+
+        //loop breaks at the end of section, but every "$$" is written as one '$'
+        while( (d = memchr(p, '$', lex.end - p)) != NULL )
+        {
+            bufWrite(out, p, d - p);
+
+            if(d + 1 >= lex.end || d[1] != '$')
+                break;
+
+            bufPutc(out, '$');
+            p = d + 2;
+        }
+
+        if(d == NULL)
+            bufWrite(out, p, lex.end - p);
+    }
+
+    bufPrintf(out, "*/\n");
+
+
+
+    bufPrintf(out, "\n\n\n\n//------------------------------------------------------------------------//\n\n");
+
+
+
+    /*
+        Macros - functions from proper target module
+    */
+
+    if(emitTable(out, attrs, table, fls, threads) != 0)
+        return 1;
+
+
+    /*
+        Groups of pins ('$g' section) - after all pins
+    */
+
+    for(int i=0; i<table->groupsNum; ++i)
+    {
+        if(attrs->group == NULL)
+        {
+            message(ERR, "Target module doesn't support groups of pins ('$g' section)\n");
+            return 1;
+        }
+
+        if(attrs->group(out, table, &table->groups[i], fls) != 0)
+            return 1;
+    }
+
+
+
+
+    /*
+        "User guide" - macros usage
+    */
+
+    bufPrintf(out, "\n\n" "/*" "\n\n");
+
+    bufPrintf(out, "Description:\n\n");
+
+    bufPuts(out, getPinMacrosText());
+
+    if(table->groupsNum > 0)
+        bufPuts(out, getGroupMacrosText());
+
+    bufPrintf(out, "*/");
+    bufPrintf(out, "\n\n\n\n//------------------------------------------------------------------------//\n\n");
+
+
+
+    /*
+        end of ' extern "C" '
+    */
+
+    bufPrintf(out,  "\n"
+                    "#ifdef __cplusplus\n"
+                    "  }\n"
+                    "#endif\n\n" );
+
+
+
+    /*
+        #endif of Header guard
+    */
+    bufPrintf(out, "#endif    // ");
+    createHeaderGuard(out, outputFileName);
+    bufPutc(out, '\n');
+
+
+    return 0;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int openDocument(GM_DOCUMENT* doc, const char* data, size_t size, const TARGET_FLAGS* fls)
+{
+    doc->data = data;
+    doc->size = size;
+    doc->flags = *fls;
+    doc->targetsNum = 0;
+    doc->pinsNum = -1;
+    doc->threads = 1;
+
+    tableInit(&doc->table);
+    bufInit(&doc->warnings);
+
+    memset(doc->attrs, 0, sizeof(doc->attrs));
+
+
+    /*
+        Searching for all sections - input file is scanned only once,
+        next sections are reached directly via saved offsets
+    */
+
+    indexSections(data, size, &doc->sections);
+
+
+    /*
+        Reading targetname(s)
+    */
+
+    doc->targetsNum = readTargets(&doc->sections, doc->targets);
+
+    if(doc->targetsNum < 0)
+    {
+        doc->targetsNum = 0;
+        return -1;
+    }
+
+
+
+    //initilalizing attrs structures
+    for(int i=0; i<doc->targetsNum; ++i)
+    {
+        if(labels[doc->targets[i]].getData == NULL)
+        {
+            message(FATAL, "%s\n", ERR_MSG_INCOMPLETE_SOURCES);
+            return -1;
+        }
+
+
+        labels[doc->targets[i]].getData(&doc->attrs[i]);
+
+
+        if(doc->attrs[i].validate == NULL || doc->attrs[i].emit == NULL)
+        {
+            message(FATAL, "%s\n", ERR_MSG_INCOMPLETE_SOURCES);
+            return -1;
+        }
+    }
+
+
+    return 0;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int parseDocument(GM_DOCUMENT* doc)
+{
+    GM_LEXER lex;
+
+
+    if(gotoSection(&lex, &doc->sections, 'm') < 0)  //go to '$m' section
+        return -1;
+
+
+    /* Checking for modes */
+
+    for(int i=0; i<doc->targetsNum; ++i)
+    {
+        const char* name = labels[doc->targets[i]].name;
+
+        // compatibility mode
+        if(doc->flags.compatibilityMode == true)
+        {
+            if(doc->attrs[i].presentModes.compatibilityMode == false)
+                message(NOTE, "%s module doesn't support compatibility mode\n", name);
+        }
+
+        // inline functions
+        if(doc->flags.inlineFunc == true)
+        {
+            if(doc->attrs[i].presentModes.inlineFunc == false)
+                message(NOTE, "%s module doesn't support inline functions\n"
+                              "\tIt will generate #defines\n", name);
+        }
+
+        // atomic mode
+        if(doc->flags.atomicMode == true)
+        {
+            if(doc->attrs[i].presentModes.atomicMode == false)
+                message(NOTE, "%s module doesn't support atomic mode\n", name);
+        }
+
+        // read-modify-write mode
+        if(doc->flags.rmwMode == true)
+        {
+            if(doc->attrs[i].presentModes.rmwMode == false)
+                message(NOTE, "%s module doesn't support rmw mode\n", name);
+        }
+
+        // bit-band mode
+        if(doc->flags.bitbandMode == true)
+        {
+            if(doc->attrs[i].presentModes.bitbandMode == false)
+                message(NOTE, "%s module doesn't support bit-band mode\n", name);
+        }
+    }
+
+
+    // warnings about pins are recorded - compiled .gm file prints them again (see importIR())
+    bufClear(&doc->warnings);
+    messageRecord(&doc->warnings);
+
+    // all pins are read at once (for all targets) - target modules check only port & pin
+    doc->pinsNum = parsePinTable(&lex, &doc->table, doc->attrs, doc->targetsNum, &doc->flags);
+
+
+    // names used many times & pins with many names (all targets)
+    if(doc->pinsNum >= 0)
+    {
+        const char* targetNames[HOW_MANY_TARGETS];
+
+        for(int i=0; i<doc->targetsNum; ++i)
+            targetNames[i] = labels[doc->targets[i]].name;
+
+        if(tableCheck(&doc->table, targetNames) != 0)
+            doc->pinsNum = -1;
+    }
+
+    messageRecord(NULL);
+
+    // groups of pins - they need names of pins
+    if(doc->pinsNum >= 0 && parseDocumentGroups(doc) < 0)
+        doc->pinsNum = -1;
+
+    return doc->pinsNum;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int parseDocumentGroups(GM_DOCUMENT* doc)
+{
+    GM_LEXER lex;
+
+
+    doc->table.groupsNum = 0;
+
+    // section is optional
+    if(doc->sections.offset['g'] < 0)
+        return 0;
+
+    if(gotoSection(&lex, &doc->sections, 'g') < 0)
+        return -1;
+
+    return parseGroups(&lex, &doc->table);
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+void documentHash(const GM_DOCUMENT* doc, int target, const char* outputFileName, char* hash)
+{
+    unsigned long long h = GM_HASH_INIT;
+
+    const char* targetName = labels[doc->targets[target]].name;
+
+    const char modes[] = {
+        doc->flags.compatibilityMode ? 'c' : '-',
+        doc->flags.inlineFunc ? 'I' : '-',
+        doc->flags.atomicMode ? 'a' : '-',
+        doc->flags.rmwMode ? 'r' : '-',
+        doc->flags.bitbandMode ? 'b' : '-'
+    };
+
+
+    h = hashData(h, doc->data, doc->size);
+
+    // '\0' separates fields
+    h = hashData(h, VERSION, sizeof(VERSION));
+    h = hashData(h, modes, sizeof(modes));
+    h = hashData(h, targetName, strlen(targetName) + 1);
+
+    // output name only as it's written in file (header guard) - i. e. the same header
+    // in other directory with the same guard has the same hash (shared cache - '--cache')
+    {
+        GM_BUF guard;
+
+        bufInit(&guard);
+        createHeaderGuard(&guard, outputFileName);
+        bufPutc(&guard, '\0');
+
+        if(guard.error)
+            h = hashData(h, outputFileName, strlen(outputFileName) + 1);
+        else
+            h = hashData(h, guard.data, guard.size);
+
+        bufFree(&guard);
+    }
+
+    // template of target (built-in or '--template') - every change of macros gives new hash
+    h = hashData(h, &doc->attrs[target].templateHash, sizeof(doc->attrs[target].templateHash));
+
+    snprintf(hash, GM_HASH_LENGTH, "%016llx", h);
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int emitHeader(GM_DOCUMENT* doc, int target, const char* outputFileName, GM_BUF* out)
+{
+    char hash[GM_HASH_LENGTH];
+
+
+    if(doc->pinsNum < 0 || target < 0 || target >= doc->targetsNum)
+        return -1;
+
+    documentHash(doc, target, outputFileName, hash);
+
+    tableSelectTarget(&doc->table, target);
+
+    if(createHeader(out, outputFileName, hash, &doc->sections, &doc->attrs[target], &doc->table, &doc->flags, doc->threads) != 0)
+        return -1;
+
+    return 0;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+void closeDocument(GM_DOCUMENT* doc)
+{
+    tableFree(&doc->table);
+    bufFree(&doc->warnings);
+
+    doc->targetsNum = 0;
+    doc->pinsNum = -1;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+void createSkeleton(GM_BUF* out, TARGETS target, const TARGET_FLAGS* fls)
+{
+    TARGET_ATTRIBUTES attrs = {0};
+
+    labels[target].getData(&attrs);
+
+
+    bufPrintf(out, "File auto-generated by m-gen v%s program. \n"
+    			"	(see: https://github.com/Leopardus4/m-gen ) \n"
+         		"Please write some macro prototypes and use m-gen to create C header file from it.\n"
+         		"\n", VERSION);
+
+
+    /*
+    All sections in input file starts at sequence '$x'
+    where 'x' is reserved letter for definite section
+    */
+
+    /*
+    Printing target name in format:
+
+        $t
+        TARGET
+
+    */
+    bufPrintf(out, "$t" "\n");
+    bufPrintf(out, "%s\n\n", labels[target].name);
+
+    /*
+    Printing comment about file in format:
+
+        $c
+        Example
+        long
+        comment
+
+    */
+    bufPrintf(out, "$c" "\n");
+    bufPrintf(out, "Write here your comment\n"
+         "    about whole file\n\n");
+
+
+    /*
+    Creating macros section and 'other' section.
+    This fragment calls proper function (via pointer from TARGET_ATTRIBUTES structure).
+
+    Called function must write following sections:
+
+    (example for AVR)
+
+        $m
+        Mode PORT PIN Name Comment
+
+        i   B   4   SDATA1 Exemplary comment...
+
+        $o
+        Some info how to use this sheet
+        Explanation of $m
+          - MCU-dependent data (port, pin) should be written by called function
+          - other - mode, name, comment - written below
+
+    */
+
+    attrs.init(out, fls);
+
+
+    /*
+    additional informations about *.gm file (at the end of '$o' section)
+    */
+
+    //mode of pin
+    bufPrintf(out,
+        "\n"
+        "   MODE: type of GPIO. \n");
+
+    bufPuts(out, getPinModesText());
+
+
+    //Name, comment
+    bufPrintf(out,
+        "                                                                   \n"
+        "   Name:                                                           \n"
+        "   Symbolic name for pin (i.e. function in project) without spaces \n"
+        "                                                                   \n"
+        "   Comment:                                                        \n"
+        "   Few words about pin function in project                         \n"
+        "   ( only one line - do not use 'Enter' )                          \n"
+        "                                                                   \n"
+        );
+
+
+
+    bufPrintf(out,
+        "                                                                   \n"
+        "Write some macros and use 'm-gen filename' command                 \n"
+        "   to create C header file with '#define' macros.                  \n"
+        "Use 'm-gen --help' for more info.                                  \n"
+        "                                                                   \n"
+        "-------------------------------------------------------------------\n"
+        "                                                                   \n"
+        "Do not use single 'dollar' character ($$) in this file             \n"
+        "   ( if it's necessary, use two $$ ).                              \n"
+        "Do not use '*/' sequence in comments                               \n"
+        "   (comments will be automaticcaly placed in /* ... */ )           \n"
+        "Do not edit '$$t' section.                                         \n"
+        "                                                                   \n"
+        );
+}
@@ -0,0 +1,131 @@
+#ifndef GM_DOCUMENT_H
+#define GM_DOCUMENT_H
+
+/*
+File:       gm-document.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Core of m-gen - conversion of .gm file (in memory) to .h file(s) (in memory).
+Used by libmgen API (libmgen.h) and m-gen program.
+
+Needs: m-gen.h, gm-utils.h (GM_SECTIONS) and gm-output.h
+*/
+
+
+
+/*
+One .gm file - sections, targets and (after parseDocument()) all pins
+*/
+typedef struct{
+
+    const char* data;   // not owned - must be valid until closeDocument()
+    size_t size;
+
+    GM_SECTIONS sections;
+
+    // targets from '$t' section (in order from file)
+    TARGETS targets[HOW_MANY_TARGETS];
+    TARGET_ATTRIBUTES attrs[HOW_MANY_TARGETS];
+    int targetsNum;
+
+    TARGET_FLAGS flags;
+
+    GM_TABLE table;
+    int pinsNum;        // -1 before parseDocument()
+
+    int threads;        // for emitHeader() - see emitTable(); 1 by default
+
+    // warnings printed by parseDocument() (each one terminated by '\0') - kept in compiled .gm file
+    GM_BUF warnings;
+
+} GM_DOCUMENT;
+
+
+
+/*
+Array of all supported targets (HOW_MANY_TARGETS elements)
+    - index is TARGETS value.
+*/
+const TARGET_LABEL* getTargetLabels(void);
+
+
+/*
+Indexes sections and reads targets from '$t' section
+    (pins are not read yet - see parseDocument()).
+Returns 0 if success
+    or -1 in case of error (message is printed, document must be closed anyway).
+*/
+int openDocument(GM_DOCUMENT* doc, const char* data, size_t size, const TARGET_FLAGS* fls);
+
+
+/*
+Reads all pins ('$m' section) for all targets.
+Returns number of pins
+    or -1 in case of error (message is printed).
+*/
+int parseDocument(GM_DOCUMENT* doc);
+
+
+/*
+Reads groups of pins ('$g' section - optional) after pins are read
+    (it's called by parseDocument(); pins loaded from compiled .gm file need it too).
+Returns number of groups
+    or -1 in case of error (message is printed).
+*/
+int parseDocumentGroups(GM_DOCUMENT* doc);
+
+
+/*
+Hash (GM_HASH_LENGTH chars: hex + '\0') of everything what affects content of one output file:
+    whole input file, version of m-gen, flags, target and header guard (from output file name
+    - only what is written in file, so outputs with the same content have the same hash).
+Pins don't have to be parsed.
+*/
+void documentHash(const GM_DOCUMENT* doc, int target, const char* outputFileName, char* hash);
+
+
+/*
+Creates whole content of .h file for one target (index in doc->targets) in 'out'.
+outputFileName - used for header guard.
+Returns 0 or -1 in case of error.
+*/
+int emitHeader(GM_DOCUMENT* doc, int target, const char* outputFileName, GM_BUF* out);
+
+
+void closeDocument(GM_DOCUMENT* doc);
+
+
+
+/*
+Creates content of new (empty) .gm file for given target.
+*/
+void createSkeleton(GM_BUF* out, TARGETS target, const TARGET_FLAGS* fls);
+
+
+
+#endif // GM_DOCUMENT_H
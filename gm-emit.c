@@ -0,0 +1,196 @@
+/*
+File:       gm-emit.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#define _POSIX_C_SOURCE 200809L     // pthreads
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), free()
+
+#include "m-gen.h"
+#include "gm-output.h"
+#include "gm-emit.h"
+
+
+#if defined __unix__ || defined __APPLE__
+  #include <pthread.h>
+  #include <unistd.h> //sysconf()
+
+  #define GM_HAVE_THREADS
+#endif
+
+
+
+
+/* one part of table - emitted by one thread */
+typedef struct{
+
+    const TARGET_ATTRIBUTES* attrs;
+    const TARGET_FLAGS* fls;
+
+    GM_TABLE part;      // the same table, but only some pins
+    GM_BUF out;
+
+    int retval;
+
+} GM_EMIT_PART;
+
+
+
+
+/*---------------------------------------------------*/
+
+static void* emitPart(void* arg)
+{
+    GM_EMIT_PART* p = arg;
+
+    p->retval = p->attrs->emit(&p->out, &p->part, p->fls);
+
+    if(p->out.error)
+        p->retval = -1;
+
+    return NULL;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int emitTable(GM_BUF* out, const TARGET_ATTRIBUTES* attrs, const GM_TABLE* table, const TARGET_FLAGS* fls, int threads)
+{
+    GM_EMIT_PART* parts;
+
+    int retval = 0;
+
+
+    // emit() needs whole table
+    if(attrs->begin == NULL)
+        return attrs->emit(out, table, fls);
+
+    if(attrs->begin(out, fls) != 0)
+        return -1;
+
+
+#ifdef GM_HAVE_THREADS
+    if(threads <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        threads = (cpus > 0) ? (int) cpus : 1;
+    }
+
+    if(threads > table->count / GM_EMIT_PART_PINS)
+        threads = table->count / GM_EMIT_PART_PINS;
+#else
+    threads = 1;
+#endif
+
+    if(threads <= 1)
+        return attrs->emit(out, table, fls);
+
+
+    parts = malloc(threads * sizeof(GM_EMIT_PART));
+
+    if(parts == NULL)
+        return attrs->emit(out, table, fls);
+
+    for(int i=0; i<threads; ++i)
+    {
+        parts[i].attrs = attrs;
+        parts[i].fls = fls;
+        parts[i].part = *table;
+
+        // index refers to whole table - lookups are not allowed in parts (see gm-table.h)
+        parts[i].part.nameSlots = NULL;
+        parts[i].part.pinSlots = NULL;
+        parts[i].part.pinNext = NULL;
+        parts[i].part.isPart = true;
+
+        bufInit(&parts[i].out);
+    }
+
+
+    /*
+        Rounds - in each of them every thread emits one part of table,
+        then all buffers are written to output (in order of pins) and reused.
+        So memory doesn't depend on size of table.
+    */
+    for(int first = 0; first < table->count && retval == 0; first += threads * GM_EMIT_PART_PINS)
+    {
+        int partsNum = 0;
+
+        for(int i=0; i<threads && first + i * GM_EMIT_PART_PINS < table->count; ++i)
+        {
+            int start = first + i * GM_EMIT_PART_PINS;
+
+            parts[i].part.pins = table->pins + start;
+            parts[i].part.count = (table->count - start < GM_EMIT_PART_PINS) ? table->count - start : GM_EMIT_PART_PINS;
+
+            bufClear(&parts[i].out);
+
+            ++partsNum;
+        }
+
+
+#ifdef GM_HAVE_THREADS
+        {
+            pthread_t ids[partsNum];
+            bool started[partsNum];
+
+            // first part in this thread
+            for(int i=1; i<partsNum; ++i)
+                started[i] = (pthread_create(&ids[i], NULL, &emitPart, &parts[i]) == 0);
+
+            emitPart(&parts[0]);
+
+            for(int i=1; i<partsNum; ++i)
+            {
+                if(started[i])
+                    pthread_join(ids[i], NULL);
+                else
+                    emitPart(&parts[i]);
+            }
+        }
+#endif // GM_HAVE_THREADS
+
+
+        for(int i=0; i<partsNum && retval == 0; ++i)
+        {
+            if(parts[i].retval != 0)
+                retval = -1;
+            else
+                bufWrite(out, parts[i].out.data, parts[i].out.size);
+        }
+    }
+
+
+    for(int i=0; i<threads; ++i)
+        bufFree(&parts[i].out);
+
+    free(parts);
+
+    return (retval == 0 && out->error == 0) ? 0 : -1;
+}
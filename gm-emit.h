@@ -0,0 +1,61 @@
+#ifndef GM_EMIT_H
+#define GM_EMIT_H
+
+/*
+File:       gm-emit.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Macros of all pins for one target - emitted by one or many threads.
+
+Needs: m-gen.h
+*/
+
+
+/* number of pins emitted by one thread at once */
+#define GM_EMIT_PART_PINS   (1024)
+
+
+/*
+Writes macros for all pins from table using target module:
+    attrs->begin() (if it's set) and attrs->emit().
+
+If target module has begin() function (so each pin is independent)
+    and table is big, pins are divided into parts (GM_EMIT_PART_PINS each)
+    which are emitted at once by 'threads' threads into separate buffers.
+    Buffers are written to 'out' in order of pins - output is always the same
+    as from one thread.
+threads - 1: everything is done by calling thread,
+    0: number of CPUs.
+
+Returns 0 or -1 in case of error.
+*/
+int emitTable(GM_BUF* out, const TARGET_ATTRIBUTES* attrs, const GM_TABLE* table, const TARGET_FLAGS* fls, int threads);
+
+
+
+#endif // GM_EMIT_H
@@ -0,0 +1,227 @@
+/*
+File:       gm-input.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#define _POSIX_C_SOURCE 200809L     // open(), fstat(), mmap()
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), realloc()
+#include <string.h> //strchr(), strcmp()
+#include <fcntl.h>  //open()
+#include <errno.h>
+
+#if defined __unix__ || defined __APPLE__
+  #include <unistd.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+
+  #define GM_HAVE_MMAP
+#else
+  #include <io.h>
+#endif
+
+#include "gm-input.h"
+
+
+/* size of first buffer for not mapped files (doubled if too small) */
+#define GM_READ_CHUNK   (64 * 1024)
+
+
+/*---------------------------------------------------*/
+
+// reading whole file from descriptor into allocated buffer
+static int readWhole(GM_INPUT* in, int fd)
+{
+    size_t capacity = GM_READ_CHUNK;
+    size_t size = 0;
+
+    char* buf = malloc(capacity);
+
+    if(buf == NULL)
+        return -1;
+
+
+    while(1)
+    {
+        long n;
+
+        if(size == capacity)
+        {
+            char* newBuf = realloc(buf, capacity * 2);
+
+            if(newBuf == NULL)
+            {
+                free(buf);
+                errno = ENOMEM;
+                return -1;
+            }
+
+            buf = newBuf;
+            capacity *= 2;
+        }
+
+        n = read(fd, buf + size, capacity - size);
+
+        if(n == 0)
+            break;
+
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            free(buf);
+            return -1;
+        }
+
+        size += n;
+    }
+
+    in->data = buf;
+    in->size = size;
+    in->mapped = 0;
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+int openInput(GM_INPUT* in, const char* filename)
+{
+    int fd;
+    int retval;
+
+    in->data = NULL;
+    in->size = 0;
+    in->mapped = 0;
+
+
+    // standard input - read once, from beginning to end (pipes can't be mapped or rewound)
+    if(strcmp(filename, "-") == 0)
+        return readWhole(in, 0);
+
+
+    fd = open(filename, O_RDONLY);
+
+    if(fd < 0)
+        return -1;
+
+
+#ifdef GM_HAVE_MMAP
+    {
+        struct stat st;
+
+        // only regular, non-empty files can be mapped
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        {
+            void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if(map != MAP_FAILED)
+            {
+                // file is read once, from beginning to end
+                posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+
+                in->data = map;
+                in->size = st.st_size;
+                in->mapped = 1;
+
+                close(fd);
+                return 0;
+            }
+        }
+    }
+#endif // GM_HAVE_MMAP
+
+
+    retval = readWhole(in, fd);
+
+    close(fd);
+
+    return retval;
+}
+
+
+
+/*---------------------------------------------------*/
+
+void closeInput(GM_INPUT* in)
+{
+#ifdef GM_HAVE_MMAP
+    if(in->mapped)
+        munmap((void*) in->data, in->size);
+    else
+#endif // GM_HAVE_MMAP
+        free((void*) in->data);
+
+    in->data = NULL;
+    in->size = 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+char* getProgramPath(const char* argv0)
+{
+    char* path;
+
+#ifdef __linux__
+    {
+        size_t size = 256;
+
+        // readlink() doesn't give length of path - buffer grows until whole path fits
+        while( (path = malloc(size)) != NULL )
+        {
+            long len = readlink("/proc/self/exe", path, size);
+
+            if(len > 0 && (size_t) len < size)
+            {
+                path[len] = 0;
+                return path;
+            }
+
+            free(path);
+
+            if(len <= 0)
+                break;
+
+            size *= 2;
+        }
+    }
+#endif
+
+    // relative or absolute path is usable, but bare name was found via PATH
+    if(argv0 == NULL || (strchr(argv0, '/') == NULL && strchr(argv0, '\\') == NULL) )
+        return NULL;
+
+    path = malloc(strlen(argv0) + 1);
+
+    if(path != NULL)
+        strcpy(path, argv0);
+
+    return path;
+}
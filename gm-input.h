@@ -0,0 +1,78 @@
+#ifndef GM_INPUT_H
+#define GM_INPUT_H
+
+/*
+File:       gm-input.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Whole input file (.gm) in memory.
+
+If it's possible, file is mapped (mmap()) - in other case
+    (i. e. pipes, empty files, systems without mmap)
+    it's read into allocated buffer.
+
+Data is NOT terminated by '\0' - always use 'size'.
+*/
+typedef struct{
+
+    const char* data;
+    size_t size;
+
+    int mapped;     // 1 - data from mmap(), 0 - from malloc()
+
+} GM_INPUT;
+
+
+
+/*
+Opens given file and loads it into 'in'.
+filename "-" - standard input (read until end of file).
+Returns 0 if success
+    or -1 in case of error (errno is set - use perror() ).
+*/
+int openInput(GM_INPUT* in, const char* filename);
+
+
+/*
+Releases memory used by 'in'.
+*/
+void closeInput(GM_INPUT* in);
+
+
+
+/*
+Finds path of running m-gen executable (for dependency files).
+argv0 - argv[0] from main()
+Returns new string (free() it)
+    or NULL if path is unknown (i. e. program was found via PATH on system without /proc).
+*/
+char* getProgramPath(const char* argv0);
+
+
+
+#endif // GM_INPUT_H
@@ -0,0 +1,458 @@
+/*
+File:       gm-ir.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#include <stdio.h>
+#include <string.h> //memcpy(), memcmp(), strlen()
+#include <ctype.h>  //isspace()
+
+#include "m-gen.h"
+#include "gm-common.h"
+#include "gm-output.h"
+#include "gm-table.h"
+#include "gm-utils.h"
+#include "gm-document.h"
+#include "gm-template.h"
+#include "gm-ir.h"
+
+
+
+
+/*---------------------------------------------------*/
+
+uint64_t irSourceHash(const GM_DOCUMENT* doc)
+{
+    unsigned long long h = GM_HASH_INIT;
+
+    h = hashData(h, doc->data, doc->size);
+    h = hashData(h, VERSION, sizeof(VERSION));
+
+    // templates of targets (built-in or '--template') - they check PORT & PIN
+    for(int i=0; i<doc->targetsNum; ++i)
+        h = hashData(h, &doc->attrs[i].templateHash, sizeof(doc->attrs[i].templateHash));
+
+    return h;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int exportIR(const GM_DOCUMENT* doc, GM_BUF* out)
+{
+    const GM_TABLE* table = &doc->table;
+    const TARGET_LABEL* labels = getTargetLabels();
+
+    GM_IR_HEADER header;
+
+    size_t stringsSize = 0;
+    uint32_t offset = 0;    // next string
+
+
+    if(doc->pinsNum < 0 || doc->warnings.error)
+        return -1;
+
+
+    // all strings - they are written at the end of file
+    for(int t=0; t<doc->targetsNum; ++t)
+        stringsSize += strlen(labels[doc->targets[t]].name) + 1;
+
+    for(int i=0; i<table->count; ++i)
+        stringsSize += table->pins[i].name.len + 1 + table->pins[i].comment.len + 1;
+
+    stringsSize += doc->warnings.size;
+
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GM_IR_MAGIC, sizeof(GM_IR_MAGIC));
+
+    header.version = GM_IR_VERSION;
+    header.headerSize = sizeof(GM_IR_HEADER);
+    header.sourceHash = irSourceHash(doc);
+
+    header.targetsNum = doc->targetsNum;
+    header.pinsNum = table->count;
+
+    header.targetsOffset = sizeof(GM_IR_HEADER);
+    header.pinsOffset = header.targetsOffset + doc->targetsNum * sizeof(GM_IR_TARGET);
+    header.locationsOffset = header.pinsOffset + table->count * sizeof(GM_IR_PIN);
+    header.stringsOffset = header.locationsOffset + doc->targetsNum * table->count * sizeof(GM_IR_LOCATION);
+
+    if(stringsSize > UINT32_MAX - header.stringsOffset)
+    {
+        message(ERR, "Table of pins is too big for compiled file\n");
+        return -1;
+    }
+
+    header.stringsSize = stringsSize;
+    header.warnings = stringsSize - doc->warnings.size;
+    header.warningsSize = doc->warnings.size;
+    header.fileSize = header.stringsOffset + stringsSize;
+
+    bufWrite(out, (const char*) &header, sizeof(header));
+
+
+    // targets
+    for(int t=0; t<doc->targetsNum; ++t)
+    {
+        GM_IR_TARGET target = { .name = offset };
+
+        bufWrite(out, (const char*) &target, sizeof(target));
+
+        offset += strlen(labels[doc->targets[t]].name) + 1;
+    }
+
+
+    // pins
+    for(int i=0; i<table->count; ++i)
+    {
+        const GM_PIN* p = &table->targetPins[0][i];
+        GM_IR_PIN pin;
+
+        memset(&pin, 0, sizeof(pin));
+
+        pin.name = offset;
+        pin.nameLen = p->name.len;
+        offset += p->name.len + 1;
+
+        pin.comment = offset;
+        pin.commentLen = p->comment.len;
+        offset += p->comment.len + 1;
+
+        pin.line = p->line;
+        pin.mode = p->mode;
+
+        bufWrite(out, (const char*) &pin, sizeof(pin));
+    }
+
+
+    // PORT & PIN - for each target
+    for(int t=0; t<doc->targetsNum; ++t)
+    {
+        for(int i=0; i<table->count; ++i)
+        {
+            GM_IR_LOCATION location = {
+                .port = table->targetPins[t][i].port,
+                .pin = table->targetPins[t][i].pin
+            };
+
+            bufWrite(out, (const char*) &location, sizeof(location));
+        }
+    }
+
+
+    // strings - in the same order as offsets above
+    for(int t=0; t<doc->targetsNum; ++t)
+        bufWrite(out, labels[doc->targets[t]].name, strlen(labels[doc->targets[t]].name) + 1);
+
+    for(int i=0; i<table->count; ++i)
+    {
+        bufPutStr(out, table->pins[i].name);
+        bufPutc(out, '\0');
+
+        bufPutStr(out, table->pins[i].comment);
+        bufPutc(out, '\0');
+    }
+
+    if(doc->warnings.size > 0)
+        bufWrite(out, doc->warnings.data, doc->warnings.size);
+
+
+    return out->error ? -1 : 0;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+/* checks if array (offset, number of elements) is inside of file */
+static int irArrayIsValid(size_t fileSize, uint32_t offset, uint32_t num, size_t elementSize)
+{
+    return offset <= fileSize
+        && offset % 4 == 0
+        && num <= (fileSize - offset) / elementSize;
+}
+
+
+/* checks if string (offset in strings[], length) is inside of strings[] and terminated by '\0' */
+static int irStringIsValid(const char* strings, uint32_t stringsSize, uint32_t offset, uint32_t len)
+{
+    return offset < stringsSize
+        && len < stringsSize - offset
+        && strings[offset + len] == '\0';
+}
+
+
+
+int importIR(GM_DOCUMENT* doc, const char* data, size_t size)
+{
+    const TARGET_LABEL* labels = getTargetLabels();
+
+    GM_TABLE* table = &doc->table;
+    GM_IR_HEADER header;
+
+    const char* strings;
+    char* stringsCopy;
+
+
+    if(doc->pinsNum >= 0 || size < sizeof(header))
+        return -1;
+
+    // data doesn't have to be aligned - all structures are copied
+    memcpy(&header, data, sizeof(header));
+
+
+    if(memcmp(header.magic, GM_IR_MAGIC, sizeof(GM_IR_MAGIC)) != 0
+        || header.version != GM_IR_VERSION
+        || header.headerSize != sizeof(GM_IR_HEADER)
+        || header.fileSize != size
+        || header.sourceHash != irSourceHash(doc)
+        || header.targetsNum != (uint32_t) doc->targetsNum
+        || header.pinsNum > INT32_MAX)
+        return -1;
+
+    if( ! irArrayIsValid(size, header.targetsOffset, header.targetsNum, sizeof(GM_IR_TARGET))
+        || ! irArrayIsValid(size, header.pinsOffset, header.pinsNum, sizeof(GM_IR_PIN))
+        || ! irArrayIsValid(size, header.locationsOffset, header.pinsNum, header.targetsNum * sizeof(GM_IR_LOCATION))
+        || ! irArrayIsValid(size, header.stringsOffset, header.stringsSize, 1) )
+        return -1;
+
+    if(header.warnings > header.stringsSize || header.warningsSize > header.stringsSize - header.warnings
+        || (header.warningsSize > 0 && data[header.stringsOffset + header.warnings + header.warningsSize - 1] != '\0'))
+        return -1;
+
+    strings = data + header.stringsOffset;
+
+
+    // targets must be the same as in '$t' section
+    for(int t=0; t<doc->targetsNum; ++t)
+    {
+        GM_IR_TARGET target;
+
+        memcpy(&target, data + header.targetsOffset + t * sizeof(target), sizeof(target));
+
+        if( ! irStringIsValid(strings, header.stringsSize, target.name, strlen(labels[doc->targets[t]].name))
+            || strcmp(strings + target.name, labels[doc->targets[t]].name) != 0)
+            return -1;
+    }
+
+
+    /*
+        Names and comments are copied at once - pins point into this copy
+    */
+
+    stringsCopy = arenaAlloc(&table->arena, header.stringsSize);
+
+    table->targetsNum = doc->targetsNum;
+
+    if(stringsCopy == NULL || tableReserve(table, header.pinsNum + 1) != 0)
+        goto error;
+
+    memcpy(stringsCopy, strings, header.stringsSize);
+
+
+    for(uint32_t i=0; i<header.pinsNum; ++i)
+    {
+        GM_IR_PIN irPin;
+        GM_PIN pin;
+
+        memcpy(&irPin, data + header.pinsOffset + i * sizeof(irPin), sizeof(irPin));
+
+        if( ! irStringIsValid(strings, header.stringsSize, irPin.name, irPin.nameLen)
+            || ! irStringIsValid(strings, header.stringsSize, irPin.comment, irPin.commentLen)
+            || irPin.mode == '\0'
+            || strchr(GM_PIN_MODES, irPin.mode) == NULL)
+            goto error;
+
+        pin.mode = irPin.mode;
+        pin.line = irPin.line;
+
+        pin.name.str = stringsCopy + irPin.name;
+        pin.name.len = irPin.nameLen;
+
+        pin.comment.str = stringsCopy + irPin.comment;
+        pin.comment.len = irPin.commentLen;
+
+
+        for(int t=0; t<doc->targetsNum; ++t)
+        {
+            GM_IR_LOCATION location;
+
+            memcpy(&location, data + header.locationsOffset + (t * header.pinsNum + i) * sizeof(location), sizeof(location));
+
+            pin.port = location.port;
+            pin.pin = location.pin;
+
+            table->targetPins[t][i] = pin;
+        }
+    }
+
+
+    table->count = header.pinsNum;
+
+    tableSelectTarget(table, 0);
+
+    if(tableIndexNames(table) != 0)
+        goto error;
+
+    // groups of pins aren't compiled - '$g' section is short
+    if(parseDocumentGroups(doc) < 0)
+        goto error;
+
+    doc->pinsNum = header.pinsNum;
+
+
+    // the same warnings as if .gm file was parsed
+    bufClear(&doc->warnings);
+    bufWrite(&doc->warnings, strings + header.warnings, header.warningsSize);
+
+    for(uint32_t pos = 0; pos < header.warningsSize; pos += strlen(strings + header.warnings + pos) + 1)
+        message(WARN, "%s", strings + header.warnings + pos);
+
+    return doc->pinsNum;
+
+
+    error:
+
+    tableFree(table);
+
+    return -1;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int exportJson(const GM_DOCUMENT* doc, GM_BUF* out)
+{
+    const GM_TABLE* table = &doc->table;
+    const TARGET_LABEL* labels = getTargetLabels();
+
+    char hash[GM_HASH_LENGTH];
+
+
+    if(doc->pinsNum < 0)
+        return -1;
+
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) irSourceHash(doc));
+
+
+    bufPrintf(out, "{\n"
+                   "    \"m-gen\": \"%s\",\n"
+                   "    \"hash\": \"%s\",\n"
+                   "    \"targets\": [", VERSION, hash);
+
+    for(int t=0; t<doc->targetsNum; ++t)
+        bufPrintf(out, "%s\"%s\"", (t > 0) ? ", " : " ", labels[doc->targets[t]].name);
+
+    bufPrintf(out, " ],\n"
+                   "    \"pins\": [\n");
+
+
+    /*
+        { "name": "LED", "mode": "o", "line": 12, "comment": "Red LED",
+            "avr": { "port": "B", "pin": 2 }, "lpc17xx": { "port": 0, "pin": 4 } }
+    */
+    for(int i=0; i<table->count; ++i)
+    {
+        const GM_PIN* p = &table->targetPins[0][i];
+        GM_STR comment = p->comment;
+
+        // without whitespaces and '\n' around comment
+        while(comment.len > 0 && isspace( (unsigned char) comment.str[0]))
+        {
+            ++comment.str;
+            --comment.len;
+        }
+
+        while(comment.len > 0 && isspace( (unsigned char) comment.str[comment.len - 1]))
+            --comment.len;
+
+
+        bufPrintf(out, "        { \"name\": ");
+        bufPutJsonStr(out, p->name);
+        bufPrintf(out, ", \"mode\": \"%c\", \"line\": %d, \"comment\": ", p->mode, p->line);
+        bufPutJsonStr(out, comment);
+        bufPrintf(out, ",\n          ");
+
+        for(int t=0; t<doc->targetsNum; ++t)
+        {
+            const GM_PIN* tp = &table->targetPins[t][i];
+
+            bufPrintf(out, "%s\"%s\": { \"port\": ", (t > 0) ? ", " : "", labels[doc->targets[t]].name);
+
+            // AVR ports are letters
+            if(doc->targets[t] == AVR)
+                bufPrintf(out, "\"%c\"", tp->port);
+            else
+                bufPrintf(out, "%d", tp->port);
+
+            bufPrintf(out, ", \"pin\": %d }", tp->pin);
+        }
+
+        bufPrintf(out, " }%s\n", (i + 1 < table->count) ? "," : "");
+    }
+
+
+    bufPrintf(out, "    ]");
+
+
+    /*
+        only if there is '$g' section:
+        "groups": [ { "name": "leds", "line": 20, "pins": [ "LED0", "LED1" ] } ]
+    */
+    if(table->groupsNum > 0)
+    {
+        bufPrintf(out, ",\n"
+                       "    \"groups\": [\n");
+
+        for(int i=0; i<table->groupsNum; ++i)
+        {
+            const GM_GROUP* g = &table->groups[i];
+
+            bufPrintf(out, "        { \"name\": ");
+            bufPutJsonStr(out, g->name);
+            bufPrintf(out, ", \"line\": %d, \"pins\": [", g->line);
+
+            for(int p=0; p<g->count; ++p)
+            {
+                bufPrintf(out, "%s", (p > 0) ? ", " : " ");
+                bufPutJsonStr(out, table->targetPins[0][g->pins[p]].name);
+            }
+
+            bufPrintf(out, " ] }%s\n", (i + 1 < table->groupsNum) ? "," : "");
+        }
+
+        bufPrintf(out, "    ]");
+    }
+
+    bufPrintf(out, "\n"
+                   "}\n");
+
+    return out->error ? -1 : 0;
+}
@@ -0,0 +1,153 @@
+#ifndef GM_IR_H
+#define GM_IR_H
+
+/*
+File:       gm-ir.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Compiled .gm file - parsed pin table in binary form (IR),
+    which can be loaded (or mapped into memory) without parsing .gm file again.
+Also JSON dump of the same data - for other tools (pinout checkers, documentation, ...).
+
+Needs: m-gen.h, gm-document.h
+
+
+Binary file (.gmc) - all numbers in byte order of machine which created it
+    (file from machine with other byte order has wrong 'version', so it's rejected).
+All offsets are from beginning of file, every array is 4-byte aligned:
+
+    GM_IR_HEADER
+    GM_IR_TARGET        targets[targetsNum]
+    GM_IR_PIN           pins[pinsNum]
+    GM_IR_LOCATION      locations[targetsNum][pinsNum]    - PORT & PIN of each pin for each target
+    char                strings[stringsSize]              - names & comments, each terminated by '\0',
+                                                            and warnings of parsing (see importIR())
+
+File is valid only for .gm file with the same 'sourceHash'
+    (whole .gm file, version of m-gen and user's templates - see irSourceHash()).
+*/
+
+#include <stdint.h>
+
+
+#define GM_IR_MAGIC     "MGEN-IR"   /* + '\0' - 8 bytes */
+#define GM_IR_VERSION   (2)         /* changed if format of file is changed */
+
+
+typedef struct{
+
+    char magic[8];          // GM_IR_MAGIC
+    uint32_t version;       // GM_IR_VERSION
+    uint32_t headerSize;    // sizeof(GM_IR_HEADER)
+
+    uint64_t sourceHash;
+
+    uint32_t targetsNum;
+    uint32_t pinsNum;
+
+    uint32_t targetsOffset;
+    uint32_t pinsOffset;
+    uint32_t locationsOffset;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+
+    uint32_t warnings;      // offset in strings[] - warnings printed by parseDocument(), each one terminated by '\0'
+    uint32_t warningsSize;
+
+    uint32_t fileSize;
+
+} GM_IR_HEADER;
+
+
+typedef struct{
+
+    uint32_t name;          // offset in strings[] - i. e. "avr" (the same as in '$t' section)
+
+} GM_IR_TARGET;
+
+
+typedef struct{
+
+    uint32_t name;          // offset in strings[]
+    uint32_t nameLen;
+
+    uint32_t comment;       // offset in strings[] - rest of line from .gm file (with whitespaces and '\n')
+    uint32_t commentLen;
+
+    uint32_t line;          // line number in .gm file
+
+    char mode;              // 'i', 'o', ... - see printPinModes()
+    char reserved[3];
+
+} GM_IR_PIN;
+
+
+typedef struct{
+
+    int16_t port;           // the same as GM_PIN.port & pin (i. e. 'B' & 3 for AVR, 2 & 4 for LPC)
+    int16_t pin;
+
+} GM_IR_LOCATION;
+
+
+
+/*
+Hash of .gm file and m-gen version - parsed pins depend only on them
+    (target modules check PORT & PIN without flags),
+    and of user's templates of its targets ('--template'), if they are loaded.
+*/
+uint64_t irSourceHash(const GM_DOCUMENT* doc);
+
+
+/*
+Writes parsed document (after parseDocument()) in binary form to 'out'.
+Returns 0 or -1 in case of error.
+*/
+int exportIR(const GM_DOCUMENT* doc, GM_BUF* out);
+
+
+/*
+Loads pins from binary form instead of parseDocument()
+    - document must be opened (openDocument()) from the same .gm file.
+Warnings of parsing (i. e. special pins, the same port & pin for many names) are printed again.
+data - content of .gmc file (it isn't needed after return).
+Returns number of pins
+    or -1 if data is not valid for this document (nothing is printed, document is not changed).
+*/
+int importIR(GM_DOCUMENT* doc, const char* data, size_t size);
+
+
+/*
+Writes parsed document (after parseDocument() or importIR()) as JSON to 'out'.
+Returns 0 or -1 in case of error.
+*/
+int exportJson(const GM_DOCUMENT* doc, GM_BUF* out);
+
+
+
+#endif // GM_IR_H
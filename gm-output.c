@@ -0,0 +1,668 @@
+/*
+File:       gm-output.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#define _POSIX_C_SOURCE 200809L     // open(), getpid()
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), realloc()
+#include <string.h> //memcpy(), strlen()
+#include <stdarg.h>
+#include <errno.h>
+#include <ctype.h>  //isxdigit()
+
+#if defined __unix__ || defined __APPLE__
+  #include <unistd.h>
+  #include <fcntl.h>
+
+  #define GM_HAVE_POSIX_IO
+#else
+  #include <io.h>     // access()
+
+  #define F_OK  0
+#endif
+
+#include "m-gen.h"
+#include "gm-output.h"
+
+
+/* first allocation - enough for typical header */
+#define GM_BUF_FIRST_SIZE   (16 * 1024)
+
+/* buffer with flush function is flushed when it has at least this size */
+#define GM_BUF_FLUSH_SIZE   (64 * 1024)
+
+
+/*---------------------------------------------------*/
+
+void bufInit(GM_BUF* buf)
+{
+    buf->data = NULL;
+    buf->size = 0;
+    buf->capacity = 0;
+    buf->error = 0;
+
+    buf->flush = NULL;
+    buf->flushCtx = NULL;
+}
+
+
+
+void bufFree(GM_BUF* buf)
+{
+    free(buf->data);
+    bufInit(buf);
+}
+
+
+
+void bufSetFlush(GM_BUF* buf, int (*flush)(const char* data, size_t size, void* ctx), void* ctx)
+{
+    buf->flush = flush;
+    buf->flushCtx = ctx;
+}
+
+
+
+int bufFlush(GM_BUF* buf)
+{
+    if(buf->error == 0  &&  buf->flush != NULL  &&  buf->size > 0)
+    {
+        if(buf->flush(buf->data, buf->size, buf->flushCtx) != 0)
+            buf->error = 2;
+
+        buf->size = 0;
+    }
+
+    return buf->error ? -1 : 0;
+}
+
+
+
+void bufClear(GM_BUF* buf)
+{
+    buf->size = 0;
+    buf->error = 0;
+}
+
+
+
+/*
+Reserves place for 'size' next bytes.
+Returns pointer to first free byte or NULL
+*/
+static char* bufReserve(GM_BUF* buf, size_t size)
+{
+    if(buf->error)
+        return NULL;
+
+    // buffer with flush function never grows much more than GM_BUF_FLUSH_SIZE
+    if(buf->flush != NULL  &&  buf->size + size > GM_BUF_FLUSH_SIZE  &&  bufFlush(buf) != 0)
+        return NULL;
+
+    if(buf->size + size > buf->capacity)
+    {
+        size_t capacity = buf->capacity ? buf->capacity : GM_BUF_FIRST_SIZE;
+        char* data;
+
+        while(capacity < buf->size + size)
+            capacity *= 2;
+
+        data = realloc(buf->data, capacity);
+
+        if(data == NULL)
+        {
+            buf->error = 1;
+            return NULL;
+        }
+
+        buf->data = data;
+        buf->capacity = capacity;
+    }
+
+    return buf->data + buf->size;
+}
+
+
+
+/*---------------------------------------------------*/
+
+void bufWrite(GM_BUF* buf, const char* data, size_t size)
+{
+    char* p = bufReserve(buf, size);
+
+    if(p == NULL)
+        return;
+
+    memcpy(p, data, size);
+    buf->size += size;
+}
+
+
+
+void bufPutc(GM_BUF* buf, char c)
+{
+    char* p = bufReserve(buf, 1);
+
+    if(p == NULL)
+        return;
+
+    *p = c;
+    ++buf->size;
+}
+
+
+
+void bufPuts(GM_BUF* buf, const char* str)
+{
+    bufWrite(buf, str, strlen(str));
+}
+
+
+
+void bufPutStr(GM_BUF* buf, GM_STR str)
+{
+    bufWrite(buf, str.str, str.len);
+}
+
+
+
+/* number - digits are created from the end */
+static void bufPutNumber(GM_BUF* buf, unsigned int value, int negative, unsigned int base)
+{
+    char digits[16];
+    int i = sizeof(digits);
+
+    do{
+        digits[--i] = "0123456789abcdef"[value % base];
+        value /= base;
+    } while(value != 0);
+
+    if(negative)
+        digits[--i] = '-';
+
+    bufWrite(buf, &digits[i], sizeof(digits) - i);
+}
+
+
+
+void bufPutInt(GM_BUF* buf, int value)
+{
+    if(value < 0)
+        bufPutNumber(buf, 0u - (unsigned int) value, 1, 10);
+    else
+        bufPutNumber(buf, (unsigned int) value, 0, 10);
+}
+
+
+
+/*---------------------------------------------------*/
+
+void bufPutJsonStr(GM_BUF* out, GM_STR str)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    bufPutc(out, '"');
+
+    for(int i=0; i<str.len; ++i)
+    {
+        unsigned char c = str.str[i];
+
+        if(c == '"' || c == '\\')
+        {
+            bufPutc(out, '\\');
+            bufPutc(out, c);
+        }
+
+        else if(c < 0x20)
+        {
+            bufPuts(out, "\\u00");
+            bufPutc(out, hex[c >> 4]);
+            bufPutc(out, hex[c & 0x0f]);
+        }
+
+        else
+            bufPutc(out, c);
+    }
+
+    bufPutc(out, '"');
+}
+
+
+
+/*---------------------------------------------------*/
+
+void bufPrintf(GM_BUF* buf, const char* format, ...)
+{
+    va_list args;
+    const char* p = format;
+
+    va_start(args, format);
+
+
+    while(*p)
+    {
+        // copying text between conversions at once
+        const char* percent = strchr(p, '%');
+
+        if(percent == NULL)
+        {
+            bufPuts(buf, p);
+            break;
+        }
+
+        bufWrite(buf, p, percent - p);
+
+        p = percent + 1;
+
+        switch(*p)
+        {
+            case 's':
+                bufPuts(buf, va_arg(args, const char*));
+                break;
+
+            case '.':   // only "%.*s"
+            {
+                int len = va_arg(args, int);
+                const char* str = va_arg(args, const char*);
+
+                bufWrite(buf, str, len);
+                p += 2;
+                break;
+            }
+
+            case 'c':
+                bufPutc(buf, (char) va_arg(args, int));
+                break;
+
+            case 'd':
+                bufPutInt(buf, va_arg(args, int));
+                break;
+
+            case 'u':
+                bufPutNumber(buf, va_arg(args, unsigned int), 0, 10);
+                break;
+
+            case 'x':
+                bufPutNumber(buf, va_arg(args, unsigned int), 0, 16);
+                break;
+
+            case '%':
+                bufPutc(buf, '%');
+                break;
+
+            default:    // unsupported - should never happen
+                bufPutc(buf, '%');
+                continue;
+        }
+
+        ++p;
+    }
+
+
+    va_end(args);
+}
+
+
+
+/*---------------------------------------------------*/
+
+int outputOpen(GM_OUTPUT* out, const char* filename)
+{
+    out->filename = filename;
+    out->fp = NULL;
+    out->error = 0;
+    out->written = 0;
+
+    /*
+    Temporary file - in the same directory as 'filename'
+    (rename() cannot move file between filesystems),
+    name is unique for each output file & process: "name.m_gen.PID.N"
+    (N - next free number, if the same file is written by many threads)
+    */
+    out->tempName = malloc(strlen(filename) + 48);
+
+    if(out->tempName == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+
+#ifdef GM_HAVE_POSIX_IO
+    {
+        unsigned int counter = 0;
+        int fd;
+
+        do{
+            sprintf(out->tempName, "%s.m_gen.%ld.%u", filename, (long) getpid(), counter++);
+
+            // O_EXCL - file is never shared with other process
+            fd = open(out->tempName, O_WRONLY | O_CREAT | O_EXCL, 0666);
+
+        } while(fd < 0 && errno == EEXIST);
+
+
+        if(fd >= 0  &&  (out->fp = fdopen(fd, "wb")) == NULL)
+        {
+            close(fd);
+            remove(out->tempName);
+        }
+    }
+#else
+    sprintf(out->tempName, "%s.m_gen.tmp", filename);
+
+    out->fp = fopen(out->tempName, "wb");
+#endif // GM_HAVE_POSIX_IO
+
+
+    if(out->fp == NULL)
+    {
+        free(out->tempName);
+        out->tempName = NULL;
+        return -1;
+    }
+
+    // data is always written in big parts - without copying into FILE buffer
+    setvbuf(out->fp, NULL, _IONBF, 0);
+
+    return 0;
+}
+
+
+
+int outputOpenLink(GM_OUTPUT* out, const char* filename, const char* source)
+{
+#ifdef GM_HAVE_POSIX_IO
+    unsigned int counter = 0;
+    int ret;
+
+    out->filename = filename;
+    out->fp = NULL;
+    out->error = 0;
+    out->written = 0;
+
+    out->tempName = malloc(strlen(filename) + 48);
+
+    if(out->tempName == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    // the same names as in outputOpen()
+    do{
+        sprintf(out->tempName, "%s.m_gen.%ld.%u", filename, (long) getpid(), counter++);
+
+        ret = link(source, out->tempName);
+
+    } while(ret != 0 && errno == EEXIST);
+
+
+    if(ret != 0)
+    {
+        int err = errno;
+
+        free(out->tempName);
+        out->tempName = NULL;
+        errno = err;
+
+        return -1;
+    }
+
+    return 0;
+#else
+    (void) out;
+    (void) filename;
+    (void) source;
+
+    errno = ENOSYS;
+    return -1;
+#endif // GM_HAVE_POSIX_IO
+}
+
+
+
+int outputWrite(const char* data, size_t size, void* output)
+{
+    GM_OUTPUT* out = output;
+
+    if(out->error == 0  &&  fwrite(data, 1, size, out->fp) != size)
+        out->error = errno ? errno : EIO;
+
+    out->written += size;
+
+    return out->error ? -1 : 0;
+}
+
+
+
+/* compares two open files */
+static int streamsAreEqual(FILE* a, FILE* b)
+{
+    char chunkA[4096];
+    char chunkB[4096];
+    size_t len;
+
+    do{
+        len = fread(chunkA, 1, sizeof(chunkA), a);
+
+        if(fread(chunkB, 1, sizeof(chunkB), b) != len || memcmp(chunkA, chunkB, len) != 0)
+            return 0;
+
+    } while(len == sizeof(chunkA));
+
+    return 1;
+}
+
+
+
+int outputIsEqual(GM_OUTPUT* out)
+{
+    FILE* written;
+    FILE* old;
+    int equal = 0;
+
+    if(out->error || fflush(out->fp) != 0)
+        return 0;
+
+    written = fopen(out->tempName, "rb");
+    old = fopen(out->filename, "rb");
+
+    if(written != NULL && old != NULL)
+        equal = streamsAreEqual(written, old);
+
+    if(written != NULL)
+        fclose(written);
+
+    if(old != NULL)
+        fclose(old);
+
+    return equal;
+}
+
+
+
+int outputCommit(GM_OUTPUT* out, const char* backupName)
+{
+    int retval = 0;
+
+    // (no stream - hard link)
+    if(out->fp != NULL && fclose(out->fp) != 0 && out->error == 0)
+        out->error = errno;
+
+    out->fp = NULL;
+
+
+    if(out->error)
+    {
+        errno = out->error;
+        retval = -1;
+    }
+
+    else
+    {
+        if(backupName != NULL && access(out->filename, F_OK) == 0)
+        {
+#ifndef GM_HAVE_POSIX_IO
+            remove(backupName);     // rename() on Windows doesn't replace files
+#endif
+            rename(out->filename, backupName);
+        }
+
+#ifndef GM_HAVE_POSIX_IO
+        remove(out->filename);   // rename() on Windows doesn't replace files
+#endif
+
+        if(rename(out->tempName, out->filename) != 0)
+            retval = -1;
+    }
+
+    if(retval != 0)
+    {
+        int err = errno;
+
+        remove(out->tempName);
+        errno = err;
+    }
+
+    free(out->tempName);
+    out->tempName = NULL;
+
+    return retval;
+}
+
+
+
+void outputAbort(GM_OUTPUT* out)
+{
+    if(out->fp != NULL)
+        fclose(out->fp);
+
+    if(out->tempName != NULL)
+        remove(out->tempName);
+
+    free(out->tempName);
+
+    out->fp = NULL;
+    out->tempName = NULL;
+}
+
+
+
+/*---------------------------------------------------*/
+
+int writeOutput(const GM_BUF* buf, const char* filename, const char* backupName)
+{
+    GM_OUTPUT out;
+
+    if(buf->error)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    if(outputOpen(&out, filename) != 0)
+        return -1;
+
+    // normally only one write() call
+    outputWrite(buf->data, buf->size, &out);
+
+    return outputCommit(&out, backupName);
+}
+
+
+
+/*---------------------------------------------------*/
+
+int readOutputHash(const char* filename, char* hash, size_t size)
+{
+    // preface is always at the beginning of file
+    char head[2048];
+    size_t len;
+    const char* p;
+    size_t i;
+
+    FILE* fp = fopen(filename, "rb");
+
+    if(fp == NULL)
+        return -1;
+
+    len = fread(head, 1, sizeof(head) - 1, fp);
+    fclose(fp);
+
+    head[len] = 0;
+
+
+    p = strstr(head, GM_HASH_TAG);
+
+    if(p == NULL)
+        return -1;
+
+    p += sizeof(GM_HASH_TAG) - 1;
+
+    for(i=0; i + 1 < size && isxdigit( (unsigned char) p[i]); ++i)
+        hash[i] = p[i];
+
+    hash[i] = 0;
+
+    return (i > 0) ? 0 : -1;
+}
+
+
+
+/*---------------------------------------------------*/
+
+int fileIsEqual(const GM_BUF* buf, const char* filename)
+{
+    char chunk[4096];
+    size_t pos = 0;
+    size_t len;
+    int equal = 1;
+
+    FILE* fp = fopen(filename, "rb");
+
+    if(fp == NULL || buf->error)
+    {
+        if(fp != NULL)
+            fclose(fp);
+
+        return 0;
+    }
+
+
+    while( equal && (len = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+    {
+        if(pos + len > buf->size || memcmp(chunk, buf->data + pos, len) != 0)
+            equal = 0;
+
+        pos += len;
+    }
+
+    fclose(fp);
+
+
+    return equal && pos == buf->size;
+}
@@ -0,0 +1,154 @@
+#ifndef GM_OUTPUT_H
+#define GM_OUTPUT_H
+
+/*
+File:       gm-output.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Output buffer functions - see GM_BUF in m-gen.h
+
+Buffer grows automatically. If memory allocation fails,
+    buf->error is set and next writes are ignored.
+*/
+
+void bufInit(GM_BUF* buf);
+
+void bufFree(GM_BUF* buf);
+
+// makes buffer empty (allocated memory is reused)
+void bufClear(GM_BUF* buf);
+
+
+void bufWrite(GM_BUF* buf, const char* data, size_t size);
+
+void bufPutc(GM_BUF* buf, char c);
+
+void bufPuts(GM_BUF* buf, const char* str);
+
+void bufPutStr(GM_BUF* buf, GM_STR str);
+
+void bufPutInt(GM_BUF* buf, int value);
+
+// string as JSON value - in quotes, with escaped characters
+void bufPutJsonStr(GM_BUF* buf, GM_STR str);
+
+
+/*
+Sets function which gets content of buffer every time when it's full (and buffer is cleared)
+    - so whole output doesn't have to be in memory. It's called also by bufFlush().
+flush() returns 0 or -1 in case of error (next writes to buffer are ignored).
+*/
+void bufSetFlush(GM_BUF* buf, int (*flush)(const char* data, size_t size, void* ctx), void* ctx);
+
+// gives rest of data to flush function; returns 0 or -1 in case of any error
+int bufFlush(GM_BUF* buf);
+
+
+/*
+Simplified and fast printf() to buffer.
+Supported conversions:
+    %s  %.*s  %c  %d  %u  %x  %%
+(without width / flags - m-gen doesn't need them)
+*/
+#ifdef __GNUC__
+__attribute__((format(printf, 2, 3)))
+#endif
+void bufPrintf(GM_BUF* buf, const char* format, ...);
+
+
+
+/*
+Writes whole buffer to file 'filename':
+    - data is written by one write() to temporary file in the same directory,
+    - old file (if exist) is renamed to 'backupName' (if not NULL),
+    - temporary file is renamed to 'filename'.
+So 'filename' is always complete - old or new one.
+Returns 0 if success
+    or -1 in case of error (errno is set).
+*/
+int writeOutput(const GM_BUF* buf, const char* filename, const char* backupName);
+
+
+
+/*
+Output file written in parts - the same way as writeOutput():
+    outputOpen()    - creates temporary file in the same directory as 'filename',
+    outputWrite()   - appends data to it (it can be used as flush function of GM_BUF),
+    outputOpenLink() - instead of outputOpen(): temporary file is a hard link to existing file 'source'
+                      (nothing is written - POSIX only, it fails i. e. between filesystems),
+    outputCommit()  - renames it to 'filename' (old file is renamed to 'backupName', if not NULL),
+    outputAbort()   - removes temporary file (i. e. in case of error).
+outputIsEqual() returns 1 if data written so far is the same as in existing 'filename', or 0.
+Other functions return 0 if success
+    or -1 in case of error (errno is set).
+*/
+typedef struct{
+
+    const char* filename;
+    char* tempName;
+
+    FILE* fp;
+    int error;      // errno of first failed write
+
+    size_t written; // number of bytes given to outputWrite()
+
+} GM_OUTPUT;
+
+
+int outputOpen(GM_OUTPUT* out, const char* filename);
+
+int outputOpenLink(GM_OUTPUT* out, const char* filename, const char* source);
+
+int outputWrite(const char* data, size_t size, void* output);
+
+int outputIsEqual(GM_OUTPUT* out);
+
+int outputCommit(GM_OUTPUT* out, const char* backupName);
+
+void outputAbort(GM_OUTPUT* out);
+
+
+/*
+Reads hash (written after GM_HASH_TAG in preface) from existing output file
+    - only beginning of file is read.
+hash - buffer for 'size' chars.
+Returns 0 if hash is found
+    or -1 if not (file doesn't exist or it wasn't created by m-gen v1.3+).
+*/
+int readOutputHash(const char* filename, char* hash, size_t size);
+
+
+/*
+Returns 1 if file 'filename' exists and has exactly the same content as buffer
+    or 0 if not.
+*/
+int fileIsEqual(const GM_BUF* buf, const char* filename);
+
+
+
+#endif // GM_OUTPUT_H
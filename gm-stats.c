@@ -0,0 +1,385 @@
+/*
+File:       gm-stats.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#define _POSIX_C_SOURCE 200809L     // pthreads, clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), realloc(), free()
+#include <string.h>
+#include <time.h>
+
+#include "m-gen.h"
+#include "gm-utils.h"
+#include "gm-output.h"
+#include "gm-stats.h"
+
+
+#if defined __unix__ || defined __APPLE__
+  #include <pthread.h>
+
+  #define GM_HAVE_THREADS
+#endif
+
+
+/* max. number of threads shown separately in trace (next ones are shown as the last one) */
+#define GM_STATS_THREADS    (256)
+
+
+
+/* one phase */
+typedef struct{
+
+    char* name;
+    char* arg;      // NULL if not given
+
+    double start;   // [us]
+    double duration;
+
+    int thread;     // 1, 2, ...
+
+} GM_SPAN;
+
+
+
+/* static variables */
+
+static bool enabled = false;
+static bool printSummary = false;
+static const char* traceName = NULL;
+
+static GM_SPAN* spans = NULL;
+static int spansNum = 0;
+static int spansCapacity = 0;
+
+static size_t bytesReadSum = 0;
+static size_t bytesWrittenSum = 0;
+static long long pinsSum = 0;
+
+static int cacheHits = 0;
+static int cacheMisses = 0;
+
+
+#ifdef GM_HAVE_THREADS
+static pthread_mutex_t statsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// threads known so far - index + 1 is number of thread in trace
+static pthread_t threads[GM_STATS_THREADS];
+static int threadsNum = 0;
+#endif
+
+
+
+
+/*---------------------------------------------------*/
+
+static void lock(void)
+{
+#ifdef GM_HAVE_THREADS
+    pthread_mutex_lock(&statsMutex);
+#endif
+}
+
+
+static void unlock(void)
+{
+#ifdef GM_HAVE_THREADS
+    pthread_mutex_unlock(&statsMutex);
+#endif
+}
+
+
+/* number of calling thread (1, 2, ...) - called with locked mutex */
+static int threadNumber(void)
+{
+#ifdef GM_HAVE_THREADS
+    pthread_t self = pthread_self();
+
+    for(int i=0; i<threadsNum; ++i)
+    {
+        if(pthread_equal(threads[i], self))
+            return i + 1;
+    }
+
+    if(threadsNum < GM_STATS_THREADS)
+        threads[threadsNum++] = self;
+
+    return threadsNum;
+#else
+    return 1;
+#endif
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+double statsNow(void)
+{
+    static double origin = -1;
+    double now;
+
+#if defined CLOCK_MONOTONIC
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    now = ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+#else
+    now = clock() * (1e6 / CLOCKS_PER_SEC);
+#endif
+
+    // first call - from main(), before any other thread is started
+    if(origin < 0)
+        origin = now;
+
+    return now - origin;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+void statsEnable(bool print, const char* traceFile)
+{
+    printSummary = print;
+    traceName = traceFile;
+
+    enabled = (print || traceFile != NULL);
+}
+
+
+
+bool statsEnabled(void)
+{
+    return enabled;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+void statsSpan(const char* name, const char* arg, double start)
+{
+    double end;
+
+    if(enabled == false)
+        return;
+
+    end = statsNow();
+
+    lock();
+
+    if(spansNum == spansCapacity)
+    {
+        int capacity = spansCapacity ? 2 * spansCapacity : 64;
+        GM_SPAN* p = realloc(spans, capacity * sizeof(GM_SPAN));
+
+        if(p == NULL)
+        {
+            unlock();
+            return;     // statistics only - conversion is not stopped
+        }
+
+        spans = p;
+        spansCapacity = capacity;
+    }
+
+    spans[spansNum].name = duplicateString(name);
+    spans[spansNum].arg = (arg != NULL) ? duplicateString(arg) : NULL;
+    spans[spansNum].start = start;
+    spans[spansNum].duration = end - start;
+    spans[spansNum].thread = threadNumber();
+
+    if(spans[spansNum].name != NULL)
+        ++spansNum;
+
+    unlock();
+}
+
+
+
+void statsCount(size_t bytesRead, size_t bytesWritten, int pins)
+{
+    if(enabled == false)
+        return;
+
+    lock();
+
+    bytesReadSum += bytesRead;
+    bytesWrittenSum += bytesWritten;
+
+    if(pins > 0)
+        pinsSum += pins;
+
+    unlock();
+}
+
+
+
+
+void statsCache(int hits, int misses)
+{
+    if(enabled == false)
+        return;
+
+    lock();
+
+    cacheHits += hits;
+    cacheMisses += misses;
+
+    unlock();
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+/* Summary - sum of time for each phase (in order of first span) */
+static void printStats(double total)
+{
+    bool printed[spansNum + 1];
+
+    memset(printed, 0, sizeof(printed));
+
+
+    fprintf(stderr, "\nStatistics:\n");
+    fprintf(stderr, "    %-16s %8s %14s\n", "phase", "count", "time [ms]");
+
+    for(int i=0; i<spansNum; ++i)
+    {
+        int count = 0;
+        double time = 0;
+
+        if(printed[i])
+            continue;
+
+        for(int j=i; j<spansNum; ++j)
+        {
+            if(printed[j] == false && strcmp(spans[j].name, spans[i].name) == 0)
+            {
+                printed[j] = true;
+                time += spans[j].duration;
+                ++count;
+            }
+        }
+
+        fprintf(stderr, "    %-16s %8d %14.3f\n", spans[i].name, count, time / 1e3);
+    }
+
+    fprintf(stderr, "    %-16s %8s %14.3f\n", "total (wall)", "", total / 1e3);
+
+    fprintf(stderr, "\n    read:    %12zu bytes\n", bytesReadSum);
+    fprintf(stderr, "    written: %12zu bytes\n", bytesWrittenSum);
+    fprintf(stderr, "    pins:    %12lld  (%.0f pins/s)\n", pinsSum,
+                        (total > 0) ? pinsSum / (total / 1e6) : 0.0);
+
+    if(cacheHits + cacheMisses > 0)
+        fprintf(stderr, "    cache:   %12d hits, %d misses\n", cacheHits, cacheMisses);
+}
+
+
+
+/* Chrome trace format (JSON) - "X" (complete) events */
+static int writeTrace(const char* filename)
+{
+    GM_BUF out;
+    char number[64];
+
+
+    bufInit(&out);
+
+    bufPuts(&out, "{\"traceEvents\":[\n");
+    bufPuts(&out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"m-gen\"}}");
+
+    for(int i=0; i<spansNum; ++i)
+    {
+        const GM_SPAN* s = &spans[i];
+
+        bufPuts(&out, ",\n{\"name\":");
+        bufPutJsonStr(&out, (GM_STR){s->name, (int) strlen(s->name)});
+
+        snprintf(number, sizeof(number), "%.3f,\"dur\":%.3f", s->start, s->duration);
+
+        bufPrintf(&out, ",\"cat\":\"m-gen\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%s", s->thread, number);
+
+        if(s->arg != NULL)
+        {
+            bufPuts(&out, ",\"args\":{\"file\":");
+            bufPutJsonStr(&out, (GM_STR){s->arg, (int) strlen(s->arg)});
+            bufPutc(&out, '}');
+        }
+
+        bufPutc(&out, '}');
+    }
+
+    bufPuts(&out, "\n],\n\"displayTimeUnit\":\"ms\"}\n");
+
+
+    if(writeOutput(&out, filename, NULL) != 0)
+    {
+        perror(filename);
+        bufFree(&out);
+        return -1;
+    }
+
+    bufFree(&out);
+
+    return 0;
+}
+
+
+
+int statsFinish(void)
+{
+    int retval = 0;
+
+    if(enabled == false)
+        return 0;
+
+    if(printSummary)
+        printStats(statsNow());
+
+    if(traceName != NULL)
+        retval = writeTrace(traceName);
+
+
+    for(int i=0; i<spansNum; ++i)
+    {
+        free(spans[i].name);
+        free(spans[i].arg);
+    }
+
+    free(spans);
+
+    spans = NULL;
+    spansNum = spansCapacity = 0;
+
+    return retval;
+}
@@ -0,0 +1,82 @@
+#ifndef GM_STATS_H
+#define GM_STATS_H
+
+/*
+File:       gm-stats.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Statistics of conversion ('--stats') and Chrome trace file ('--trace=file.json'):
+    time of every phase (span), bytes read & written, number of pins, hits & misses of cache.
+All functions can be called by many threads (batch mode).
+
+Needs: stdbool.h, stddef.h
+*/
+
+
+/*
+Current time in microseconds - since first call of this function (in main()).
+Always works - also when statistics are disabled.
+*/
+double statsNow(void);
+
+
+/*
+Enables statistics:
+    print - summary is printed to stderr by statsFinish(),
+    traceFile - name of trace file (NULL if not needed).
+*/
+void statsEnable(bool print, const char* traceFile);
+
+/* true if '--stats' or '--trace' is given - otherwise start of spans isn't measured (see statsNow()) */
+bool statsEnabled(void);
+
+
+/*
+Adds span of phase 'name' - from 'start' (see statsNow()) till now.
+arg - i. e. name of file, shown in trace (can be NULL). Strings are copied.
+It does nothing if statistics are disabled.
+*/
+void statsSpan(const char* name, const char* arg, double start);
+
+
+/* Adds bytes read, bytes written and converted pins */
+void statsCount(size_t bytesRead, size_t bytesWritten, int pins);
+
+/* Adds hits & misses of headers cache ('--cache dir') */
+void statsCache(int hits, int misses);
+
+
+/*
+Prints summary and writes trace file (if enabled).
+Returns 0 or -1 if trace file cannot be written (message is printed).
+*/
+int statsFinish(void);
+
+
+
+#endif // GM_STATS_H
@@ -0,0 +1,803 @@
+/*
+File:       gm-table.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), free()
+#include <assert.h>
+#include <string.h> //memcpy(), memchr(), strchr()
+#include <ctype.h>  //tolower()
+#include <limits.h> //INT_MAX
+
+#include "m-gen.h"
+#include "gm-common.h"
+#include "gm-output.h"
+#include "gm-table.h"
+
+
+/* minimal size of one arena chunk */
+#define GM_ARENA_CHUNK_SIZE     (64 * 1024)
+
+
+
+/*---------------------------------------------------*/
+
+void arenaInit(GM_ARENA* arena)
+{
+    arena->head = NULL;
+}
+
+
+
+void* arenaAlloc(GM_ARENA* arena, size_t size)
+{
+    GM_ARENA_CHUNK* chunk = arena->head;
+
+    // alignment as pointer
+    size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+
+
+    if(chunk == NULL || chunk->used + size > chunk->size)
+    {
+        size_t chunkSize = (size > GM_ARENA_CHUNK_SIZE) ? size : GM_ARENA_CHUNK_SIZE;
+
+        chunk = malloc(sizeof(GM_ARENA_CHUNK) + chunkSize);
+
+        if(chunk == NULL)
+            return NULL;
+
+        chunk->size = chunkSize;
+        chunk->used = 0;
+
+        chunk->next = arena->head;
+        arena->head = chunk;
+    }
+
+    chunk->used += size;
+
+    return chunk->data + chunk->used - size;
+}
+
+
+
+GM_STR arenaStrdup(GM_ARENA* arena, GM_STR str)
+{
+    GM_STR copy = {NULL, 0};
+
+    char* p = arenaAlloc(arena, str.len + 1);
+
+    if(p == NULL)
+        return copy;
+
+    memcpy(p, str.str, str.len);
+    p[str.len] = '\0';
+
+    copy.str = p;
+    copy.len = str.len;
+
+    return copy;
+}
+
+
+
+void arenaFree(GM_ARENA* arena)
+{
+    while(arena->head != NULL)
+    {
+        GM_ARENA_CHUNK* next = arena->head->next;
+
+        free(arena->head);
+        arena->head = next;
+    }
+}
+
+
+
+/*---------------------------------------------------*/
+
+void tableInit(GM_TABLE* table)
+{
+    table->pins = NULL;
+    table->count = 0;
+    table->capacity = 0;
+
+    for(int i=0; i<HOW_MANY_TARGETS; ++i)
+        table->targetPins[i] = NULL;
+
+    table->targetsNum = 0;
+
+    table->nameSlots = NULL;
+    table->nameSlotsNum = 0;
+    table->namesNum = 0;
+
+    table->pinSlots = NULL;
+    table->pinNext = NULL;
+    table->pinSlotsNum = 0;
+
+    table->isPart = false;
+
+    table->groups = NULL;
+    table->groupsNum = 0;
+    table->groupsCapacity = 0;
+
+    arenaInit(&table->arena);
+}
+
+
+
+void tableFree(GM_TABLE* table)
+{
+    for(int i=0; i<HOW_MANY_TARGETS; ++i)
+        free(table->targetPins[i]);
+
+    free(table->nameSlots);
+
+    free(table->pinSlots);
+    free(table->pinNext);
+
+    free(table->groups);
+
+    arenaFree(&table->arena);
+
+    tableInit(table);
+}
+
+
+
+int tableReserve(GM_TABLE* table, int pinsNum)
+{
+    int capacity = (table->capacity > 0) ? table->capacity : 64;
+
+    if(pinsNum <= table->capacity)
+        return 0;
+
+    while(capacity < pinsNum)
+    {
+        if(capacity > INT_MAX / 2)
+            return -1;
+
+        capacity *= 2;
+    }
+
+
+    for(int i=0; i<table->targetsNum; ++i)
+    {
+        GM_PIN* pins = realloc(table->targetPins[i], capacity * sizeof(GM_PIN));
+
+        if(pins == NULL)
+            return -1;
+
+        table->targetPins[i] = pins;
+    }
+
+    table->capacity = capacity;
+    table->pins = table->targetPins[0];
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* FNV-1a hash */
+static unsigned int hashStr(GM_STR str)
+{
+    unsigned int hash = 2166136261u;
+
+    for(int i=0; i<str.len; ++i)
+    {
+        hash ^= (unsigned char) str.str[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+
+
+/*
+Makes hash table of names 2x bigger - all names are inserted again.
+Returns 0 or -1 if there is no memory.
+*/
+static int growNameSlots(GM_TABLE* table)
+{
+    unsigned int slotsNum = (table->nameSlotsNum > 0) ? 2 * table->nameSlotsNum : 128;
+    unsigned int mask = slotsNum - 1;
+
+    int* slots = malloc(slotsNum * sizeof(int));
+
+    if(slots == NULL)
+        return -1;
+
+    for(unsigned int i=0; i<slotsNum; ++i)
+        slots[i] = -1;
+
+
+    for(unsigned int i=0; i<table->nameSlotsNum; ++i)
+    {
+        int pinIndex = table->nameSlots[i];
+        unsigned int j;
+
+        if(pinIndex < 0)
+            continue;
+
+        j = hashStr(table->pins[pinIndex].name) & mask;
+
+        while(slots[j] >= 0)
+            j = (j + 1) & mask;
+
+        slots[j] = pinIndex;
+    }
+
+
+    free(table->nameSlots);
+
+    table->nameSlots = slots;
+    table->nameSlotsNum = slotsNum;
+
+    return 0;
+}
+
+
+
+/*
+Slot of given name in hash table of names - with index of pin which has this name
+    or empty (-1) if there is no such name (open addressing - table is at most half full).
+*/
+static unsigned int nameSlot(const GM_TABLE* table, GM_STR name)
+{
+    unsigned int mask = table->nameSlotsNum - 1;
+    unsigned int i = hashStr(name) & mask;
+
+    while(table->nameSlots[i] >= 0)
+    {
+        GM_STR other = table->pins[table->nameSlots[i]].name;
+
+        if(other.len == name.len && memcmp(other.str, name.str, name.len) == 0)
+            break;
+
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+
+
+/*
+Returns interned copy of name - if the same name already exists in table,
+    its string is used, in other case name is copied into arena.
+pinIndex - index of pin which will use this name.
+*/
+static GM_STR internName(GM_TABLE* table, GM_STR name, int pinIndex)
+{
+    unsigned int i;
+
+
+    if(2 * (table->namesNum + 1) > table->nameSlotsNum  &&  growNameSlots(table) != 0)
+    {
+        GM_STR none = {NULL, 0};
+        return none;
+    }
+
+    i = nameSlot(table, name);
+
+    if(table->nameSlots[i] >= 0)
+        return table->pins[table->nameSlots[i]].name;
+
+    table->nameSlots[i] = pinIndex;
+    ++table->namesNum;
+
+    return arenaStrdup(&table->arena, name);
+}
+
+
+
+int tableIndexNames(GM_TABLE* table)
+{
+    free(table->nameSlots);
+
+    table->nameSlots = NULL;
+    table->nameSlotsNum = 0;
+    table->namesNum = 0;
+
+    for(int i=0; i<table->count; ++i)
+    {
+        unsigned int slot;
+
+        if(2 * (table->namesNum + 1) > table->nameSlotsNum  &&  growNameSlots(table) != 0)
+            return -1;
+
+        slot = nameSlot(table, table->pins[i].name);
+
+        if(table->nameSlots[slot] < 0)
+        {
+            table->nameSlots[slot] = i;
+            ++table->namesNum;
+        }
+    }
+
+    return 0;
+}
+
+
+
+int tableFindName(const GM_TABLE* table, GM_STR name)
+{
+    assert( ! table->isPart);
+
+    if(table->nameSlots == NULL)
+        return -1;
+
+    return table->nameSlots[nameSlot(table, name)];
+}
+
+
+
+/*---------------------------------------------------*/
+
+int parsePinTable(GM_LEXER* lex, GM_TABLE* table, const TARGET_ATTRIBUTES atrs[], int targetsNum, const TARGET_FLAGS* fls)
+{
+    GM_ROW row;
+
+    int retval;
+
+    int column = -1;    // PORT & PIN columns being validated - for error messages
+
+
+    /*
+    Arrays of pins grow with table (see tableReserve()) and only spans of rows are read
+        - so there are no limits of names, comments or number of pins,
+        and memory doesn't depend on length of lines or on other sections.
+    */
+    table->targetsNum = targetsNum;
+
+    if(tableReserve(table, 1) != 0)
+    {
+        message(ERR, "Out of memory\n");
+        return -1;
+    }
+
+
+
+    // one 'Enter' , and
+    // first line - heading - unwanted
+    lexSkipLine(lex);
+    lexSkipLine(lex);
+
+
+    // one line - one pin
+    while( (retval = lexReadRow(lex, &row, targetsNum)) != 0 )
+    {
+        GM_PIN* pin;
+
+        if(retval < 0)
+        {
+            message(ERR, "Input file cannot be correctly read\n");
+            goto error;
+        }
+
+        if(tableReserve(table, table->count + 1) != 0)
+        {
+            message(ERR, "Out of memory\n");
+            goto error;
+        }
+
+        pin = &table->pins[table->count];
+
+
+        pin->mode = tolower( (unsigned char) row.mode.str[0]);
+        pin->line = row.line;
+        pin->comment = row.comment;
+
+        if(strchr(GM_PIN_MODES, pin->mode) == NULL)
+        {
+            message(ERR, "Unknown mode: %.*s\n", GM_STR_ARG(row.mode));
+            goto error;
+        }
+
+
+        pin->name = internName(table, row.name, table->count);
+
+        if(pin->name.str == NULL)
+        {
+            message(ERR, "Out of memory\n");
+            goto error;
+        }
+
+
+        // port & pin - target-dependent (first target and next ones - the same name, comment, ...)
+        for(column=0; column<targetsNum; ++column)
+        {
+            GM_PIN* targetPin = &table->targetPins[column][table->count];
+
+            if(column > 0)
+                *targetPin = *pin;
+
+            if(atrs[column].validate(targetPin, row.port[column], row.pin[column], fls) != 0)
+                goto error;
+        }
+
+        column = -1;
+
+        ++table->count;
+    }
+
+
+    return table->count;
+
+
+    error:
+
+    if(targetsNum > 1 && column >= 0)
+        message(MSG, "\t(line: %d, PORT & PIN columns nr %d )\n", lex->tokenLine, column + 1);
+    else
+        message(MSG, "\t(line: %d )\n", lex->tokenLine);
+
+    return -1;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* index of group with given name or -1 (groups are few - linear search) */
+static int findGroup(const GM_TABLE* table, GM_STR name)
+{
+    for(int i=0; i<table->groupsNum; ++i)
+    {
+        const GM_STR n = table->groups[i].name;
+
+        if(n.len == name.len && memcmp(n.str, name.str, name.len) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+
+
+int parseGroups(GM_LEXER* lex, GM_TABLE* table)
+{
+    GM_STR word;
+    int len;
+
+
+    // one 'Enter' , and
+    // first line - heading - unwanted
+    lexSkipLine(lex);
+    lexSkipLine(lex);
+
+    len = lexReadWord(lex, &word);
+
+
+    // one line - one group: name and names of pins (till the end of line)
+    while(len > 0 && word.str[0] != '$')
+    {
+        GM_GROUP group = { .name = word, .line = lex->tokenLine };
+
+        if(findGroup(table, word) >= 0 || tableFindName(table, word) >= 0)
+        {
+            message(ERR, "Name %.*s is already used\n", GM_STR_ARG(word));
+            goto error;
+        }
+
+        while( (len = lexReadWord(lex, &word)) > 0 && lex->tokenLine == group.line && word.str[0] != '$')
+        {
+            int index = tableFindName(table, word);
+
+            if(index < 0)
+            {
+                message(ERR, "Unknown pin %.*s in group %.*s\n", GM_STR_ARG(word), GM_STR_ARG(group.name));
+                goto error;
+            }
+
+            for(int i=0; i<group.count; ++i)
+            {
+                if(group.pins[i] == index)
+                {
+                    message(ERR, "Pin %.*s is given twice in group %.*s\n", GM_STR_ARG(word), GM_STR_ARG(group.name));
+                    goto error;
+                }
+            }
+
+            if(group.count >= GM_GROUP_PINS)
+            {
+                message(ERR, "Too many pins in group %.*s (max. %d)\n", GM_STR_ARG(group.name), GM_GROUP_PINS);
+                goto error;
+            }
+
+            group.pins[group.count++] = index;
+        }
+
+        if(group.count == 0)
+        {
+            message(ERR, "Group %.*s has no pins\n", GM_STR_ARG(group.name));
+            message(MSG, "\t(line: %d )\n", group.line);
+            return -1;
+        }
+
+
+        if(table->groupsNum >= table->groupsCapacity)
+        {
+            int capacity = (table->groupsCapacity > 0) ? table->groupsCapacity * 2 : 8;
+            GM_GROUP* groups = realloc(table->groups, capacity * sizeof(GM_GROUP));
+
+            if(groups == NULL)
+            {
+                message(ERR, "Out of memory\n");
+                return -1;
+            }
+
+            table->groups = groups;
+            table->groupsCapacity = capacity;
+        }
+
+        table->groups[table->groupsNum++] = group;
+    }
+
+
+    return table->groupsNum;
+
+
+    error:
+
+    message(MSG, "\t(line: %d )\n", lex->tokenLine);
+
+    return -1;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* hash of port & pin (integer mixing) */
+static unsigned int hashPin(int port, int pin)
+{
+    unsigned int hash = ((unsigned int) (unsigned short) port << 16) | (unsigned short) pin;
+
+    hash ^= hash >> 15;
+    hash *= 2246822519u;
+    hash ^= hash >> 13;
+
+    return hash;
+}
+
+
+/*
+Slot of given port & pin in hash table of selected target - with index of first pin
+    with this port & pin, or empty (-1).
+*/
+static unsigned int pinSlot(const GM_TABLE* table, int port, int pin)
+{
+    unsigned int mask = table->pinSlotsNum - 1;
+    unsigned int i = hashPin(port, pin) & mask;
+
+    while(table->pinSlots[i] >= 0)
+    {
+        const GM_PIN* other = &table->pins[table->pinSlots[i]];
+
+        if(other->port == port && other->pin == pin)
+            break;
+
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+
+/*
+Index of ports & pins for selected target - built again for each target.
+If there is no memory, index is not available (tableFindPin() returns -1).
+*/
+static void indexPins(GM_TABLE* table)
+{
+    unsigned int slotsNum = 16;
+
+    free(table->pinSlots);
+    free(table->pinNext);
+
+    table->pinSlotsNum = 0;
+
+    while(slotsNum < 2 * (unsigned int) table->count)
+        slotsNum *= 2;
+
+    table->pinSlots = malloc(slotsNum * sizeof(int));
+    table->pinNext = malloc((table->count + 1) * sizeof(int));
+
+    if(table->pinSlots == NULL || table->pinNext == NULL)
+    {
+        free(table->pinSlots);
+        free(table->pinNext);
+
+        table->pinSlots = NULL;
+        table->pinNext = NULL;
+        return;
+    }
+
+    table->pinSlotsNum = slotsNum;
+
+    for(unsigned int i=0; i<slotsNum; ++i)
+        table->pinSlots[i] = -1;
+
+
+    // from last pin - so lists of pins with the same port & pin are in order from file
+    for(int i = table->count - 1; i >= 0; --i)
+    {
+        unsigned int slot = pinSlot(table, table->pins[i].port, table->pins[i].pin);
+
+        table->pinNext[i] = table->pinSlots[slot];
+        table->pinSlots[slot] = i;
+    }
+}
+
+
+
+void tableSelectTarget(GM_TABLE* table, int target)
+{
+    table->pins = table->targetPins[target];
+
+    indexPins(table);
+}
+
+
+
+int tableFindPin(const GM_TABLE* table, int port, int pin)
+{
+    assert( ! table->isPart);
+
+    if(table->pinSlots == NULL)
+        return -1;
+
+    return table->pinSlots[pinSlot(table, port, pin)];
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+/* "NAME (line: 5), OTHER (line: 9)" - for messages */
+static void bufPutPinList(GM_BUF* out, const GM_TABLE* table, int first, const int next[])
+{
+    bufClear(out);
+
+    for(int i = first; i >= 0; i = next[i])
+    {
+        bufPrintf(out, "%s%s (line: %d)", (i != first) ? ", " : "", table->pins[i].name.str, table->pins[i].line);
+    }
+
+    bufPutc(out, '\0');
+}
+
+
+
+int tableCheck(GM_TABLE* table, const char* const targetNames[])
+{
+    int* sameName;      // for each pin: next pin with the same name or -1
+    int* lastName;      // for first pin with given name: last pin with this name
+
+    GM_BUF list;
+
+    int retval = 0;
+
+
+    sameName = malloc((table->count + 1) * sizeof(int));
+    lastName = malloc((table->count + 1) * sizeof(int));
+
+    bufInit(&list);
+
+    if(sameName == NULL || lastName == NULL)
+    {
+        message(ERR, "Out of memory\n");
+        retval = -1;
+        goto end;
+    }
+
+
+
+    /*
+        Names - each name can be used only once (one macro for each name)
+    */
+
+    if(table->count > 0 && table->nameSlots == NULL && tableIndexNames(table) != 0)
+    {
+        message(ERR, "Out of memory\n");
+        retval = -1;
+        goto end;
+    }
+
+    for(int i=0; i<table->count; ++i)
+    {
+        int first = tableFindName(table, table->pins[i].name);
+
+        sameName[i] = -1;
+        lastName[i] = i;
+
+        if(first >= 0 && first != i)
+        {
+            sameName[lastName[first]] = i;
+            lastName[first] = i;
+        }
+    }
+
+    for(int i=0; i<table->count; ++i)
+    {
+        // first pin of name used many times
+        if(sameName[i] >= 0 && tableFindName(table, table->pins[i].name) == i)
+        {
+            bufPutPinList(&list, table, i, sameName);
+
+            message(ERR, "Name %s is used more than once: %s\n", table->pins[i].name.str,
+                    list.error ? "" : list.data);
+
+            retval = -1;
+        }
+    }
+
+
+
+    /*
+        Ports & pins - many names of the same pin are allowed (i. e. aliases),
+        but usually it's a mistake
+    */
+
+    for(int t=0; t<table->targetsNum; ++t)
+    {
+        tableSelectTarget(table, t);
+
+        if(table->count > 0 && table->pinSlots == NULL)
+        {
+            message(ERR, "Out of memory\n");
+            retval = -1;
+            break;
+        }
+
+        for(int i=0; i<table->count; ++i)
+        {
+            if(table->pinNext[i] >= 0 && tableFindPin(table, table->pins[i].port, table->pins[i].pin) == i)
+            {
+                bufPutPinList(&list, table, i, table->pinNext);
+
+                message(WARN, "%s: the same port & pin for many names: %s\n", targetNames[t],
+                        list.error ? "" : list.data);
+            }
+        }
+    }
+
+    tableSelectTarget(table, 0);
+
+
+    end:
+
+    free(sameName);
+    free(lastName);
+
+    bufFree(&list);
+
+    return retval;
+}
@@ -0,0 +1,132 @@
+#ifndef GM_TABLE_H
+#define GM_TABLE_H
+
+/*
+File:       gm-table.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/* all supported modes of pin - see printPinModes() */
+#define GM_PIN_MODES    "iodlhb"
+
+
+
+/*
+Arena functions - see GM_ARENA in m-gen.h
+*/
+
+void arenaInit(GM_ARENA* arena);
+
+// returns pointer to 'size' bytes (aligned as pointer) or NULL
+void* arenaAlloc(GM_ARENA* arena, size_t size);
+
+// copies string into arena (and adds '\0')
+GM_STR arenaStrdup(GM_ARENA* arena, GM_STR str);
+
+// frees all memory from arena
+void arenaFree(GM_ARENA* arena);
+
+
+
+/*
+Pin table functions - see GM_TABLE in m-gen.h
+*/
+
+void tableInit(GM_TABLE* table);
+
+void tableFree(GM_TABLE* table);
+
+
+/*
+Makes arrays of pins (for table->targetsNum targets) big enough for 'pinsNum' pins
+    - they grow 2x at once, so adding pins one by one is fast.
+Returns 0 or -1 if there is no memory.
+*/
+int tableReserve(GM_TABLE* table, int pinsNum);
+
+
+/*
+Reads whole '$m' section (lexer should be set after "$m")
+    and converts it into table of pins.
+atrs - array of targets (targetsNum) - one PORT & PIN columns pair for each.
+Port and pin columns are checked & converted by target module (atrs[i].validate).
+First target is selected (see tableSelectTarget()).
+Returns number of pins
+    or -1 in case of error (message is printed - with line number).
+*/
+int parsePinTable(GM_LEXER* lex, GM_TABLE* table, const TARGET_ATTRIBUTES atrs[], int targetsNum, const TARGET_FLAGS* fls);
+
+
+/*
+Reads whole '$g' section (lexer should be set after "$g") - groups of pins:
+    Name PIN_NAME PIN_NAME ...      (one group in one line, up to GM_GROUP_PINS pins)
+Pins must be read before (names are indexed - see tableFindName()).
+Returns number of groups
+    or -1 in case of error (message is printed - with line number).
+*/
+int parseGroups(GM_LEXER* lex, GM_TABLE* table);
+
+
+/*
+Sets table->pins to pins of given target (index in atrs[] from parsePinTable())
+    and builds index of its ports & pins (see tableFindPin()).
+*/
+void tableSelectTarget(GM_TABLE* table, int target);
+
+
+
+/*
+Hash index of table - lookups in constant time (i. e. for emit() functions of targets):
+    tableFindName() - index of pin with given name or -1,
+    tableFindPin()  - index of first pin of selected target with given port & pin or -1.
+Index is only for whole table, in calling thread - parts of table emitted by many threads
+    (see gm-emit.h) must not use it: emit() of such target depends only on given pin (asserted).
+*/
+int tableFindName(const GM_TABLE* table, GM_STR name);
+
+int tableFindPin(const GM_TABLE* table, int port, int pin);
+
+
+/*
+Builds index of names again (i. e. after loading pins from compiled .gm file).
+Returns 0 or -1 if there is no memory.
+*/
+int tableIndexNames(GM_TABLE* table);
+
+
+/*
+Checks whole table (all targets) - every collision is reported with line numbers:
+    names used by many pins - error,
+    port & pin used by many names - warning.
+targetNames - names of targets (for messages).
+First target is selected at the end.
+Returns 0 or -1 in case of error.
+*/
+int tableCheck(GM_TABLE* table, const char* const targetNames[]);
+
+
+
+#endif // GM_TABLE_H
@@ -0,0 +1,2420 @@
+/*
+File:       gm-template.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+#define _POSIX_C_SOURCE 200809L     // pthreads
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), realloc(), free()
+#include <string.h>
+#include <ctype.h>
+#include <stddef.h> //offsetof()
+
+#include "m-gen.h"
+#include "gm-common.h"
+#include "gm-output.h"
+#include "gm-table.h"
+#include "gm-template.h"
+
+
+#if defined __unix__ || defined __APPLE__
+  #include <pthread.h>
+
+  #define GM_HAVE_THREADS
+#endif
+
+
+
+/* limits of one template */
+#define GM_TPL_VARS         (64)    // variables ('int' and 'text')
+#define GM_TPL_STACK        (32)    // stack of expression
+#define GM_TPL_NESTING      (16)    // nested '?if'
+#define GM_TPL_PREFIX       (16)    // prefix of PORT / PIN
+
+#define GM_TPL_MODES        ((int) sizeof(GM_PIN_MODES) - 1)
+
+/* max. number of built-in templates */
+#define GM_TPL_BUILTINS     (HOW_MANY_TARGETS)
+
+
+
+/* instructions of bytecode */
+typedef enum{
+
+    OP_TEXT,        // a - offset in strings, b - length
+    OP_NAME,
+    OP_COMMENT,
+    OP_PORT,
+    OP_PIN,
+    OP_LINE,
+    OP_INT,         // a - variable, b - 1: hexadecimal ('${hex:x}')
+    OP_VAR,         // a - variable (text - the last matching definition is run)
+    OP_IF,          // flag, neg - if condition is false, jump to a
+    OP_JUMP,        // a - next instruction
+
+    // groups of pins
+    OP_PINS,        // names of pins of group
+    OP_COUNT,       // number of pins of group
+    OP_MASK,        // bits of actual port (in '?port' loop) or of value of group
+    OP_TO_PORT,     // value of group -> bits of port; a - variable (b = -1) or offset in strings, b - length
+    OP_TO_LANE,     // as above, but the lowest bit of port used by group is bit 0 (byte / half-word registers)
+    OP_FROM_PORT,   // bits of port (all ports outside of loop) -> value of group; a, b - as above
+    OP_PORTS        // '?port' loop - instructions till a are run for every port of group
+
+} GM_TPL_OPCODE;
+
+
+typedef struct{
+
+    unsigned char code;
+    signed char flag;
+    bool neg;
+
+    int a;
+    int b;
+
+} GM_TPL_OP;
+
+
+/* expression of 'int' variable - reverse polish notation */
+typedef enum{
+
+    EX_NUM,         // value
+    EX_PORT,
+    EX_PIN,
+    EX_VAR,         // value - variable
+    EX_NEG,
+    EX_ADD,
+    EX_SUB,
+    EX_MUL,
+    EX_DIV,
+    EX_MOD
+
+} GM_TPL_EXCODE;
+
+
+typedef struct{
+
+    unsigned char code;
+    int value;
+
+} GM_TPL_EXPR;
+
+
+/* variable - 'int' or 'text' */
+typedef struct{
+
+    int nameOffset;     // in strings
+    int nameLength;
+
+    bool isInt;
+
+    int last;           // last definition or -1
+
+} GM_TPL_VAR;
+
+
+/* one definition of variable - the last matching one is used */
+typedef struct{
+
+    int prev;           // previous definition of the same variable or -1
+
+    signed char flag;   // -1 - always
+    bool neg;
+
+    bool at;            // only for pin: port & pin ('at' line)
+    short port;
+    short pin;
+
+    int first;          // instructions (text) or expression (int)
+    int end;
+
+} GM_TPL_DEF;
+
+
+/* 'check' line */
+typedef struct{
+
+    bool anyPort;
+    bool anyPin;
+    short port;
+    short pin;
+
+    char modes[GM_TPL_MODES + 1];   // "" - all modes
+
+    int level;          // WARN or ERR
+
+    int first;          // instructions of message
+    int end;
+
+} GM_TPL_CHECK;
+
+
+/* 'port' / 'pin' line */
+typedef struct{
+
+    bool defined;
+    bool letter;        // letter (i. e. 'B') or number
+
+    int min;
+    int max;
+
+    char prefix[GM_TPL_PREFIX];     // optional, '?' - any character
+    int prefixLength;
+
+} GM_TPL_FIELD;
+
+
+/* range of instructions */
+typedef struct{
+
+    bool defined;
+
+    int first;
+    int end;
+
+} GM_TPL_BLOCK;
+
+
+
+struct GM_TEMPLATE_S{
+
+    char name[TARGET_NAME_LENGTH];
+    char description[DESCRIPTION_LENGTH];
+    TARGET_FLAGS modes;
+
+    GM_TPL_FIELD port;
+    GM_TPL_FIELD pin;
+
+    GM_TPL_BLOCK init;
+    GM_TPL_BLOCK help;
+    GM_TPL_BLOCK begin;
+    GM_TPL_BLOCK after;
+    GM_TPL_BLOCK mode[GM_TPL_MODES];
+    GM_TPL_BLOCK group;
+
+    int portBits;       // bits in port register ('portbits' line - needed by 'group' block)
+
+    GM_BUF strings;     // texts & names of variables
+
+    GM_TPL_OP* ops;
+    int opsNum;
+    int opsCapacity;
+
+    GM_TPL_EXPR* exprs;
+    int exprsNum;
+    int exprsCapacity;
+
+    GM_TPL_VAR vars[GM_TPL_VARS];
+    int varsNum;
+
+    GM_TPL_DEF* defs;
+    int defsNum;
+    int defsCapacity;
+
+    GM_TPL_CHECK* checks;
+    int checksNum;
+    int checksCapacity;
+
+    unsigned long long hash;    // of source
+
+    struct GM_TEMPLATE_S* next; // list of user's templates
+
+};
+
+
+
+/* flags which can be used in templates ('supports', '?if', 'text ... if') */
+static const struct{
+
+    const char* name;
+    size_t offset;
+
+} tplFlags[] = {
+
+    { "compat", offsetof(TARGET_FLAGS, compatibilityMode) },
+    { "inline", offsetof(TARGET_FLAGS, inlineFunc) },
+    { "atomic", offsetof(TARGET_FLAGS, atomicMode) },
+    { "rmw", offsetof(TARGET_FLAGS, rmwMode) },
+    { "bitband", offsetof(TARGET_FLAGS, bitbandMode) }
+};
+
+#define GM_TPL_FLAGS    ((int) (sizeof(tplFlags) / sizeof(tplFlags[0])))
+
+
+/* flags of group of pins ('group' block) - numbered after tplFlags[] */
+static const char* const tplGroupFlags[] = {
+
+    "full",     // group has every pin of actual port ('?port' loop)
+    "first",    // the first port of group ('?port' loop)
+    "wide",     // group has more than 16 pins (value doesn't fit in 16-bit int)
+    "byte",     // group has every pin of one aligned byte of actual port - and no other ('?port' loop)
+    "half",     // the same for aligned 16 bits of actual port
+    "upper"     // pins of group are in upper half of actual port ('?port' loop)
+};
+
+enum{ GM_TPL_FULL = GM_TPL_FLAGS, GM_TPL_FIRST, GM_TPL_WIDE, GM_TPL_BYTE, GM_TPL_HALF, GM_TPL_UPPER, GM_TPL_ALL_FLAGS };
+
+
+
+/* state of compiler */
+typedef struct{
+
+    GM_TEMPLATE* tpl;
+
+    const char* sourceName;
+
+    const char* pos;
+    const char* end;
+    int line;
+
+    int merge;          // first instruction which can be joined with next text (not a target of jump)
+
+    int depth;          // of expression stack
+    int maxDepth;
+
+} GM_TPL_COMPILER;
+
+
+/* one port of group of pins */
+typedef struct{
+
+    GM_PIN pin;         // port, the first pin of group in this port, name & line of group
+
+    unsigned long long mask;    // bits of port used by group
+    bool full;                  // all bits of port
+    int lowest;                 // the lowest bit of port used by group
+
+    // pins of group in this port: bit of value of group & bit of port
+    signed char groupBit[GM_GROUP_PINS];
+    signed char portBit[GM_GROUP_PINS];
+    int count;
+
+} GM_TPL_PORT;
+
+
+/* group of pins ('$g' section) during conversion */
+typedef struct{
+
+    const GM_TABLE* table;
+    const GM_GROUP* group;
+
+    GM_TPL_PORT ports[GM_GROUP_PINS];   // in order of the first pins
+    int portsNum;
+
+} GM_TPL_GROUP;
+
+
+/* state of conversion of one pin */
+typedef struct{
+
+    const GM_TEMPLATE* tpl;
+    const TARGET_FLAGS* fls;    // NULL - all flags are cleared
+    const GM_PIN* pin;          // NULL - outside of pin (begin, help, ...)
+
+    const GM_TPL_GROUP* group;  // NULL - outside of 'group' block
+    const GM_TPL_PORT* port;    // NULL - outside of '?port' loop
+
+    int vals[GM_TPL_VARS];      // 'int' variables
+
+} GM_TPL_CONTEXT;
+
+
+
+/* static variables */
+
+static GM_TEMPLATE* overrides = NULL;   // user's templates (the newest one first)
+
+static struct{
+
+    const char* builtin;        // text compiled into m-gen - also a key
+    GM_TEMPLATE* tpl;
+    bool failed;
+
+} builtins[GM_TPL_BUILTINS];
+
+
+#ifdef GM_HAVE_THREADS
+static pthread_mutex_t templateMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+
+
+/*---------------------------------------------------*/
+
+static void lock(void)
+{
+#ifdef GM_HAVE_THREADS
+    pthread_mutex_lock(&templateMutex);
+#endif
+}
+
+
+static void unlock(void)
+{
+#ifdef GM_HAVE_THREADS
+    pthread_mutex_unlock(&templateMutex);
+#endif
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* makes place for one more element of array; returns 0 or -1 */
+static int reserve(void** array, int* capacity, int count, size_t elemSize)
+{
+    if(count < *capacity)
+        return 0;
+
+    int newCapacity = (*capacity > 0) ? (*capacity * 2) : 32;
+    void* p = realloc(*array, newCapacity * elemSize);
+
+    if(p == NULL)
+        return -1;
+
+    *array = p;
+    *capacity = newCapacity;
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+/*  compiler                                         */
+/*---------------------------------------------------*/
+
+/* prints error with line of template; always returns -1 */
+static int fail(GM_TPL_COMPILER* c, const char* what, GM_STR arg)
+{
+    message(ERR, "%s (line: %d ): %s%.*s\n", c->sourceName, c->line, what, GM_STR_ARG(arg));
+
+    return -1;
+}
+
+static const GM_STR noArg = { "", 0 };
+
+
+
+/*---------------------------------------------------*/
+
+/* reads next line (without '\n' and '\r'); returns 0 at the end of template */
+static int nextLine(GM_TPL_COMPILER* c, GM_STR* line)
+{
+    const char* eol;
+
+    if(c->pos >= c->end)
+        return 0;
+
+    eol = memchr(c->pos, '\n', c->end - c->pos);
+
+    if(eol == NULL)
+        eol = c->end;
+
+    line->str = c->pos;
+    line->len = eol - c->pos;
+
+    if(line->len > 0 && line->str[line->len - 1] == '\r')
+        --line->len;
+
+    c->pos = (eol < c->end) ? eol + 1 : eol;
+    ++c->line;
+
+    return 1;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+Reads one word (or "quoted string" - with quotes) from *str.
+Returns 0 if there is nothing more, -1 if string is not closed
+*/
+static int nextToken(GM_STR* str, GM_STR* token)
+{
+    int i = 0;
+
+    while(str->len > 0 && isspace((unsigned char) str->str[0]))
+    {
+        ++str->str;
+        --str->len;
+    }
+
+    if(str->len == 0)
+        return 0;
+
+
+    if(str->str[0] == '"')
+    {
+        for(i=1; i<str->len && str->str[i] != '"'; ++i)
+        {
+            if(str->str[i] == '\\')
+                ++i;
+        }
+
+        if(i >= str->len)
+            return -1;
+
+        ++i;
+    }
+
+    else
+    {
+        while(i < str->len && ! isspace((unsigned char) str->str[i]))
+            ++i;
+    }
+
+
+    token->str = str->str;
+    token->len = i;
+
+    str->str += i;
+    str->len -= i;
+
+    return 1;
+}
+
+
+
+/*---------------------------------------------------*/
+
+static GM_STR trim(GM_STR str)
+{
+    while(str.len > 0 && isspace((unsigned char) str.str[0]))
+    {
+        ++str.str;
+        --str.len;
+    }
+
+    while(str.len > 0 && isspace((unsigned char) str.str[str.len - 1]))
+        --str.len;
+
+    return str;
+}
+
+
+
+/*---------------------------------------------------*/
+
+static int findFlag(GM_STR name)
+{
+    for(int i=0; i<GM_TPL_FLAGS; ++i)
+    {
+        if(strIsEqual(name, tplFlags[i].name))
+            return i;
+    }
+
+    for(int i=GM_TPL_FLAGS; i<GM_TPL_ALL_FLAGS; ++i)
+    {
+        if(strIsEqual(name, tplGroupFlags[i - GM_TPL_FLAGS]))
+            return i;
+    }
+
+    return -1;
+}
+
+
+/* port has only all bits of one aligned byte / half-word (bits: 8 / 16) */
+static bool isLane(const GM_TPL_PORT* port, int bits)
+{
+    return port->lowest % bits == 0 && port->mask == ((1ull << bits) - 1) << port->lowest;
+}
+
+
+static bool flagIsSet(const GM_TPL_CONTEXT* ctx, int flag)
+{
+    switch(flag)
+    {
+        case GM_TPL_FULL:   return ctx->port != NULL && ctx->port->full;
+        case GM_TPL_FIRST:  return ctx->port != NULL && ctx->port == &ctx->group->ports[0];
+        case GM_TPL_WIDE:   return ctx->group != NULL && ctx->group->group->count > 16;
+        case GM_TPL_BYTE:   return ctx->port != NULL && isLane(ctx->port, 8);
+        case GM_TPL_HALF:   return ctx->port != NULL && isLane(ctx->port, 16);
+        case GM_TPL_UPPER:  return ctx->port != NULL && ctx->port->lowest >= ctx->tpl->portBits / 2;
+    }
+
+    if(ctx->fls == NULL)
+        return false;
+
+    return *(const bool*) ((const char*) ctx->fls + tplFlags[flag].offset);
+}
+
+
+
+/*---------------------------------------------------*/
+
+static GM_STR varName(const GM_TEMPLATE* tpl, int var)
+{
+    GM_STR name = { tpl->strings.data + tpl->vars[var].nameOffset, tpl->vars[var].nameLength };
+
+    return name;
+}
+
+
+/* index of variable or -1 */
+static int findVar(const GM_TEMPLATE* tpl, GM_STR name)
+{
+    for(int i=0; i<tpl->varsNum; ++i)
+    {
+        GM_STR n = varName(tpl, i);
+
+        if(n.len == name.len && memcmp(n.str, name.str, name.len) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+
+
+/*---------------------------------------------------*/
+
+static int addOp(GM_TPL_COMPILER* c, GM_TPL_OPCODE code, int a, int b)
+{
+    GM_TEMPLATE* tpl = c->tpl;
+
+    if(reserve((void**) &tpl->ops, &tpl->opsCapacity, tpl->opsNum, sizeof(GM_TPL_OP)) != 0)
+        return fail(c, "Out of memory", noArg);
+
+    tpl->ops[tpl->opsNum] = (GM_TPL_OP) { .code = code, .flag = -1, .a = a, .b = b };
+
+    return tpl->opsNum++;
+}
+
+
+/* constant text - joined with previous one if possible */
+static int addText(GM_TPL_COMPILER* c, const char* text, int len)
+{
+    GM_TEMPLATE* tpl = c->tpl;
+    GM_TPL_OP* last = (tpl->opsNum > c->merge) ? &tpl->ops[tpl->opsNum - 1] : NULL;
+
+    if(len == 0)
+        return 0;
+
+    if(last != NULL && last->code == OP_TEXT && (size_t) (last->a + last->b) == tpl->strings.size)
+    {
+        bufWrite(&tpl->strings, text, len);
+        last->b += len;
+
+        return 0;
+    }
+
+    int offset = tpl->strings.size;
+
+    bufWrite(&tpl->strings, text, len);
+
+    return (addOp(c, OP_TEXT, offset, len) < 0) ? -1 : 0;
+}
+
+
+/* next instruction is a target of jump */
+static int label(GM_TPL_COMPILER* c)
+{
+    c->merge = c->tpl->opsNum;
+
+    return c->merge;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* ${toPort:X} / ${toLane:X} / ${fromPort:X} - X is a variable or text (i. e. name of parameter of macro) */
+static int compileConversion(GM_TPL_COMPILER* c, GM_TPL_OPCODE code, GM_STR x, int maxVar)
+{
+    int var = findVar(c->tpl, x);
+    int offset;
+
+    if(var >= 0 && var < maxVar)
+        return addOp(c, code, var, -1);
+
+    for(int i=0; i<x.len; ++i)
+    {
+        if( ! isalnum((unsigned char) x.str[i]) && x.str[i] != '_')
+            return fail(c, "Name of variable or parameter expected: ", x);
+    }
+
+    if(x.len == 0)
+        return fail(c, "Name of variable or parameter expected", noArg);
+
+    offset = c->tpl->strings.size;
+    bufWrite(&c->tpl->strings, x.str, x.len);
+
+    return addOp(c, code, offset, x.len);
+}
+
+
+/*
+Compiles text with placeholders: ${name}, ${comment}, ${port}, ${pin}, ${line}, ${variable}
+    and for groups of pins: ${pins}, ${count}, ${mask}, ${toPort:X}, ${toLane:X}, ${fromPort:X}
+Only variables with index lower than maxVar can be used.
+*/
+static int compileText(GM_TPL_COMPILER* c, const char* text, int len, int maxVar)
+{
+    int start = 0;
+
+    for(int i=0; i<len; ++i)
+    {
+        GM_STR name;
+        const char* close;
+        int var;
+
+        if(text[i] != '$' || i+1 >= len || text[i+1] != '{')
+            continue;
+
+        close = memchr(text + i, '}', len - i);
+
+        if(close == NULL)
+            return fail(c, "'}' expected", noArg);
+
+        if(addText(c, text + start, i - start) != 0)
+            return -1;
+
+        name.str = text + i + 2;
+        name.len = close - name.str;
+
+        if(strIsEqual(name, "name"))
+            var = addOp(c, OP_NAME, 0, 0);
+        else if(strIsEqual(name, "comment"))
+            var = addOp(c, OP_COMMENT, 0, 0);
+        else if(strIsEqual(name, "port"))
+            var = addOp(c, OP_PORT, 0, 0);
+        else if(strIsEqual(name, "pin"))
+            var = addOp(c, OP_PIN, 0, 0);
+        else if(strIsEqual(name, "line"))
+            var = addOp(c, OP_LINE, 0, 0);
+        else if(strIsEqual(name, "pins"))
+            var = addOp(c, OP_PINS, 0, 0);
+        else if(strIsEqual(name, "count"))
+            var = addOp(c, OP_COUNT, 0, 0);
+        else if(strIsEqual(name, "mask"))
+            var = addOp(c, OP_MASK, 0, 0);
+
+        else if(name.len > 7 && memcmp(name.str, "toPort:", 7) == 0)
+        {
+            GM_STR x = { name.str + 7, name.len - 7 };
+            var = compileConversion(c, OP_TO_PORT, x, maxVar);
+        }
+        else if(name.len > 7 && memcmp(name.str, "toLane:", 7) == 0)
+        {
+            GM_STR x = { name.str + 7, name.len - 7 };
+            var = compileConversion(c, OP_TO_LANE, x, maxVar);
+        }
+        else if(name.len > 9 && memcmp(name.str, "fromPort:", 9) == 0)
+        {
+            GM_STR x = { name.str + 9, name.len - 9 };
+            var = compileConversion(c, OP_FROM_PORT, x, maxVar);
+        }
+
+        // 'int' variable as hexadecimal number (i. e. address)
+        else if(name.len > 4 && memcmp(name.str, "hex:", 4) == 0)
+        {
+            GM_STR x = { name.str + 4, name.len - 4 };
+
+            var = findVar(c->tpl, x);
+
+            if(var < 0 || var >= maxVar || ! c->tpl->vars[var].isInt)
+                return fail(c, "Unknown 'int' variable: ", x);
+
+            var = addOp(c, OP_INT, var, 1);
+        }
+
+        else
+        {
+            var = findVar(c->tpl, name);
+
+            if(var < 0 || var >= maxVar)
+                return fail(c, "Unknown variable: ", name);
+
+            var = addOp(c, c->tpl->vars[var].isInt ? OP_INT : OP_VAR, var, 0);
+        }
+
+        if(var < 0)
+            return -1;
+
+        i = close - text;
+        start = i + 1;
+    }
+
+    return addText(c, text + start, len - start);
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* compiles "quoted string" (with escape sequences: \n \t \\ \") */
+static int compileQuoted(GM_TPL_COMPILER* c, GM_STR quoted, int maxVar)
+{
+    char* text;
+    int len = 0;
+    int retval;
+
+
+    if(quoted.len < 2 || quoted.str[0] != '"')
+        return fail(c, "\"Quoted text\" expected: ", quoted);
+
+    text = malloc(quoted.len);
+
+    if(text == NULL)
+        return fail(c, "Out of memory", noArg);
+
+
+    for(int i=1; i<quoted.len-1; ++i)
+    {
+        char ch = quoted.str[i];
+
+        if(ch == '\\')
+        {
+            ch = quoted.str[++i];
+
+            if(ch == 'n')
+                ch = '\n';
+            else if(ch == 't')
+                ch = '\t';
+        }
+
+        text[len++] = ch;
+    }
+
+    retval = compileText(c, text, len, maxVar);
+
+    free(text);
+
+    return retval;
+}
+
+
+
+/*---------------------------------------------------*/
+
+static int addExpr(GM_TPL_COMPILER* c, GM_TPL_EXCODE code, int value, int stackChange)
+{
+    GM_TEMPLATE* tpl = c->tpl;
+
+    if(reserve((void**) &tpl->exprs, &tpl->exprsCapacity, tpl->exprsNum, sizeof(GM_TPL_EXPR)) != 0)
+        return fail(c, "Out of memory", noArg);
+
+    tpl->exprs[tpl->exprsNum++] = (GM_TPL_EXPR) { .code = code, .value = value };
+
+    c->depth += stackChange;
+
+    if(c->depth > c->maxDepth)
+        c->maxDepth = c->depth;
+
+    return 0;
+}
+
+
+static void skipSpaces(GM_STR* s)
+{
+    while(s->len > 0 && isspace((unsigned char) s->str[0]))
+    {
+        ++s->str;
+        --s->len;
+    }
+}
+
+
+static int compileSum(GM_TPL_COMPILER* c, GM_STR* s, int maxVar);
+
+
+/* 0x... - up to 0x7fffffff (i. e. addresses of registers) */
+static int strToHex(GM_STR str, int* value)
+{
+    unsigned long val = 0;
+
+    if(str.len < 3 || str.str[0] != '0' || (str.str[1] != 'x' && str.str[1] != 'X'))
+        return -1;
+
+    for(int i=2; i<str.len; ++i)
+    {
+        int ch = tolower((unsigned char) str.str[i]);
+
+        if( ! isxdigit(ch) || val > 0x7ffffff)
+            return -1;
+
+        val = val*16 + (isdigit(ch) ? ch - '0' : ch - 'a' + 10);
+    }
+
+    *value = (int) val;
+
+    return 0;
+}
+
+
+/* number, port, pin, variable, -x, (x) */
+static int compileUnary(GM_TPL_COMPILER* c, GM_STR* s, int maxVar)
+{
+    GM_STR word = { s->str, 0 };
+
+    skipSpaces(s);
+
+    if(s->len == 0)
+        return fail(c, "Value expected", noArg);
+
+
+    if(s->str[0] == '-')
+    {
+        ++s->str;
+        --s->len;
+
+        if(compileUnary(c, s, maxVar) != 0)
+            return -1;
+
+        return addExpr(c, EX_NEG, 0, 0);
+    }
+
+
+    if(s->str[0] == '(')
+    {
+        ++s->str;
+        --s->len;
+
+        if(compileSum(c, s, maxVar) != 0)
+            return -1;
+
+        skipSpaces(s);
+
+        if(s->len == 0 || s->str[0] != ')')
+            return fail(c, "')' expected", noArg);
+
+        ++s->str;
+        --s->len;
+
+        return 0;
+    }
+
+
+    word.str = s->str;
+
+    while(word.len < s->len && (isalnum((unsigned char) s->str[word.len]) || s->str[word.len] == '_'))
+        ++word.len;
+
+    s->str += word.len;
+    s->len -= word.len;
+
+    if(word.len == 0)
+        return fail(c, "Value expected: ", *s);
+
+
+    if(isdigit((unsigned char) word.str[0]))
+    {
+        int value;
+
+        if(strToHex(word, &value) != 0 && strToInt(word, &value) != 0)
+            return fail(c, "Bad number: ", word);
+
+        return addExpr(c, EX_NUM, value, 1);
+    }
+
+    if(strIsEqual(word, "port"))
+        return addExpr(c, EX_PORT, 0, 1);
+
+    if(strIsEqual(word, "pin"))
+        return addExpr(c, EX_PIN, 0, 1);
+
+
+    int var = findVar(c->tpl, word);
+
+    if(var < 0 || var >= maxVar || ! c->tpl->vars[var].isInt)
+        return fail(c, "Unknown 'int' variable: ", word);
+
+    return addExpr(c, EX_VAR, var, 1);
+}
+
+
+/* x * y, x / y, x % y */
+static int compileProduct(GM_TPL_COMPILER* c, GM_STR* s, int maxVar)
+{
+    if(compileUnary(c, s, maxVar) != 0)
+        return -1;
+
+    for(;;)
+    {
+        GM_TPL_EXCODE code;
+
+        skipSpaces(s);
+
+        if(s->len == 0)
+            return 0;
+
+        if(s->str[0] == '*')
+            code = EX_MUL;
+        else if(s->str[0] == '/')
+            code = EX_DIV;
+        else if(s->str[0] == '%')
+            code = EX_MOD;
+        else
+            return 0;
+
+        ++s->str;
+        --s->len;
+
+        if(compileUnary(c, s, maxVar) != 0 || addExpr(c, code, 0, -1) != 0)
+            return -1;
+    }
+}
+
+
+/* x + y, x - y */
+static int compileSum(GM_TPL_COMPILER* c, GM_STR* s, int maxVar)
+{
+    if(compileProduct(c, s, maxVar) != 0)
+        return -1;
+
+    for(;;)
+    {
+        GM_TPL_EXCODE code;
+
+        skipSpaces(s);
+
+        if(s->len == 0)
+            return 0;
+
+        if(s->str[0] == '+')
+            code = EX_ADD;
+        else if(s->str[0] == '-')
+            code = EX_SUB;
+        else
+            return 0;
+
+        ++s->str;
+        --s->len;
+
+        if(compileProduct(c, s, maxVar) != 0 || addExpr(c, code, 0, -1) != 0)
+            return -1;
+    }
+}
+
+
+/* whole expression - sets def->first & def->end */
+static int compileExpr(GM_TPL_COMPILER* c, GM_STR s, int maxVar, GM_TPL_DEF* def)
+{
+    def->first = c->tpl->exprsNum;
+
+    c->depth = 0;
+    c->maxDepth = 0;
+
+    if(compileSum(c, &s, maxVar) != 0)
+        return -1;
+
+    skipSpaces(&s);
+
+    if(s.len > 0)
+        return fail(c, "Unexpected: ", s);
+
+    if(c->maxDepth > GM_TPL_STACK)
+        return fail(c, "Expression is too complicated", noArg);
+
+    def->end = c->tpl->exprsNum;
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* port / pin from template ('at' & 'check' lines) - letter or number, without prefix */
+static int compileLocation(GM_TPL_COMPILER* c, const GM_TPL_FIELD* field, GM_STR token, bool* any, short* value)
+{
+    int v;
+
+    *any = strIsEqual(token, "*");
+
+    if(*any)
+        return 0;
+
+    if(field->letter)
+    {
+        if(token.len != 1 || ! isalpha((unsigned char) token.str[0]))
+            return fail(c, "Letter expected: ", token);
+
+        *value = toupper((unsigned char) token.str[0]);
+        return 0;
+    }
+
+    if(strToInt(token, &v) != 0 || v < field->min || v > field->max)
+        return fail(c, "Bad number: ", token);
+
+    *value = v;
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* new definition of variable (creates variable if needed); returns index of definition or -1 */
+static int addDef(GM_TPL_COMPILER* c, GM_STR name, bool isInt, bool mustExist)
+{
+    GM_TEMPLATE* tpl = c->tpl;
+    int var = findVar(tpl, name);
+
+
+    if(var < 0)
+    {
+        if(mustExist)
+            return fail(c, "Unknown variable: ", name);
+
+        if(strIsEqual(name, "name") || strIsEqual(name, "comment") || strIsEqual(name, "port")
+           || strIsEqual(name, "pin") || strIsEqual(name, "line") || strIsEqual(name, "pins")
+           || strIsEqual(name, "count") || strIsEqual(name, "mask") || ! isalpha((unsigned char) name.str[0]))
+            return fail(c, "Bad name of variable: ", name);
+
+        if(tpl->varsNum >= GM_TPL_VARS)
+            return fail(c, "Too many variables", noArg);
+
+        var = tpl->varsNum++;
+
+        tpl->vars[var].nameOffset = tpl->strings.size;
+        tpl->vars[var].nameLength = name.len;
+        tpl->vars[var].isInt = isInt;
+        tpl->vars[var].last = -1;
+
+        bufWrite(&tpl->strings, name.str, name.len);
+    }
+
+    else if(tpl->vars[var].isInt != isInt)
+        return fail(c, "Variable has other type: ", name);
+
+
+    if(reserve((void**) &tpl->defs, &tpl->defsCapacity, tpl->defsNum, sizeof(GM_TPL_DEF)) != 0)
+        return fail(c, "Out of memory", noArg);
+
+    tpl->defs[tpl->defsNum] = (GM_TPL_DEF) { .prev = tpl->vars[var].last, .flag = -1 };
+    tpl->vars[var].last = tpl->defsNum;
+
+    return tpl->defsNum++;
+}
+
+
+/* variable of definition (it's the last definition of this variable) */
+static int defVar(const GM_TEMPLATE* tpl, int def)
+{
+    for(int i=0; i<tpl->varsNum; ++i)
+    {
+        if(tpl->vars[i].last == def)
+            return i;
+    }
+
+    return -1;
+}
+
+
+/* value of variable: expression or "text" */
+static int compileDefValue(GM_TPL_COMPILER* c, int def, GM_STR value)
+{
+    GM_TEMPLATE* tpl = c->tpl;
+    int var = defVar(tpl, def);
+
+
+    // only variables defined earlier - no recursion
+    if(tpl->vars[var].isInt)
+        return compileExpr(c, value, var, &tpl->defs[def]);
+
+
+    label(c);
+    tpl->defs[def].first = tpl->opsNum;
+
+    if(compileQuoted(c, value, var) != 0)
+        return -1;
+
+    tpl->defs[def].end = tpl->opsNum;
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+    int NAME = EXPRESSION
+    text NAME [if [!]FLAG] = "text"
+*/
+static int compileVar(GM_TPL_COMPILER* c, GM_STR rest, bool isInt)
+{
+    GM_STR name, token;
+    int def;
+    int flag = -1;
+    bool neg = false;
+
+
+    if(nextToken(&rest, &name) <= 0)
+        return fail(c, "Name of variable expected", noArg);
+
+    if(nextToken(&rest, &token) <= 0)
+        return fail(c, "'=' expected", noArg);
+
+
+    if( ! isInt && strIsEqual(token, "if"))
+    {
+        if(nextToken(&rest, &token) <= 0)
+            return fail(c, "Flag expected", noArg);
+
+        neg = (token.str[0] == '!');
+
+        if(neg)
+        {
+            ++token.str;
+            --token.len;
+        }
+
+        if( (flag = findFlag(token)) < 0)
+            return fail(c, "Unknown flag: ", token);
+
+        if(nextToken(&rest, &token) <= 0)
+            return fail(c, "'=' expected", noArg);
+    }
+
+    if( ! strIsEqual(token, "="))
+        return fail(c, "'=' expected: ", token);
+
+
+    if( (def = addDef(c, name, isInt, false)) < 0)
+        return -1;
+
+    c->tpl->defs[def].flag = flag;
+    c->tpl->defs[def].neg = neg;
+
+
+    if(isInt)
+        return compileDefValue(c, def, rest);
+
+    if(nextToken(&rest, &token) <= 0)
+        return fail(c, "\"Quoted text\" expected", noArg);
+
+    if(compileDefValue(c, def, token) != 0)
+        return -1;
+
+    if(nextToken(&rest, &token) != 0)
+        return fail(c, "Unexpected: ", token);
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+    at PORT PIN  NAME = VALUE  [NAME = VALUE ...]
+*/
+static int compileAt(GM_TPL_COMPILER* c, GM_STR rest)
+{
+    GM_TEMPLATE* tpl = c->tpl;
+    GM_STR portStr, pinStr, name, token, value;
+    short port, pin;
+    bool any;
+    int retval;
+
+
+    if( ! tpl->port.defined || ! tpl->pin.defined)
+        return fail(c, "'port' and 'pin' must be given before 'at'", noArg);
+
+    if(nextToken(&rest, &portStr) <= 0 || nextToken(&rest, &pinStr) <= 0)
+        return fail(c, "PORT and PIN expected", noArg);
+
+    if(compileLocation(c, &tpl->port, portStr, &any, &port) != 0)
+        return -1;
+
+    if(any)
+        return fail(c, "'*' can't be used in 'at' line", noArg);
+
+    if(compileLocation(c, &tpl->pin, pinStr, &any, &pin) != 0)
+        return -1;
+
+    if(any)
+        return fail(c, "'*' can't be used in 'at' line", noArg);
+
+
+    while( (retval = nextToken(&rest, &name)) > 0)
+    {
+        int var, def;
+
+        if(nextToken(&rest, &token) <= 0 || ! strIsEqual(token, "="))
+            return fail(c, "'=' expected", noArg);
+
+        if(nextToken(&rest, &value) <= 0)
+            return fail(c, "Value expected", noArg);
+
+        if( (var = findVar(tpl, name)) < 0)
+            return fail(c, "Unknown variable: ", name);
+
+        if( (def = addDef(c, name, tpl->vars[var].isInt, true)) < 0)
+            return -1;
+
+        tpl->defs[def].at = true;
+        tpl->defs[def].port = port;
+        tpl->defs[def].pin = pin;
+
+        if(compileDefValue(c, def, value) != 0)
+            return -1;
+    }
+
+    if(retval < 0)
+        return fail(c, "'\"' expected", noArg);
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+    check PORT PIN MODES warn|error "message"
+*/
+static int compileCheck(GM_TPL_COMPILER* c, GM_STR rest)
+{
+    GM_TEMPLATE* tpl = c->tpl;
+    GM_STR portStr, pinStr, modes, level, msg;
+    GM_TPL_CHECK check = {0};
+
+
+    if( ! tpl->port.defined || ! tpl->pin.defined)
+        return fail(c, "'port' and 'pin' must be given before 'check'", noArg);
+
+    if(nextToken(&rest, &portStr) <= 0 || nextToken(&rest, &pinStr) <= 0
+       || nextToken(&rest, &modes) <= 0 || nextToken(&rest, &level) <= 0 || nextToken(&rest, &msg) <= 0)
+        return fail(c, "Expected: check PORT PIN MODES warn|error \"message\"", noArg);
+
+    if(compileLocation(c, &tpl->port, portStr, &check.anyPort, &check.port) != 0
+       || compileLocation(c, &tpl->pin, pinStr, &check.anyPin, &check.pin) != 0)
+        return -1;
+
+
+    if( ! strIsEqual(modes, "*"))
+    {
+        if(modes.len > GM_TPL_MODES)
+            return fail(c, "Bad modes: ", modes);
+
+        for(int i=0; i<modes.len; ++i)
+        {
+            if(strchr(GM_PIN_MODES, modes.str[i]) == NULL)
+                return fail(c, "Unknown mode: ", modes);
+
+            check.modes[i] = modes.str[i];
+        }
+    }
+
+    if(strIsEqual(level, "warn"))
+        check.level = WARN;
+    else if(strIsEqual(level, "error"))
+        check.level = ERR;
+    else
+        return fail(c, "'warn' or 'error' expected: ", level);
+
+
+    label(c);
+    check.first = tpl->opsNum;
+
+    if(compileQuoted(c, msg, tpl->varsNum) != 0)
+        return -1;
+
+    check.end = tpl->opsNum;
+
+
+    if(reserve((void**) &tpl->checks, &tpl->checksCapacity, tpl->checksNum, sizeof(GM_TPL_CHECK)) != 0)
+        return fail(c, "Out of memory", noArg);
+
+    tpl->checks[tpl->checksNum++] = check;
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+    port|pin letter [prefix TEXT]
+    port|pin number MIN MAX [prefix TEXT]
+*/
+static int compileField(GM_TPL_COMPILER* c, GM_STR rest, GM_TPL_FIELD* field)
+{
+    GM_STR token;
+
+
+    if(field->defined)
+        return fail(c, "PORT / PIN is already defined", noArg);
+
+    if(nextToken(&rest, &token) <= 0)
+        return fail(c, "'letter' or 'number' expected", noArg);
+
+    field->defined = true;
+    field->letter = strIsEqual(token, "letter");
+
+
+    if( ! field->letter)
+    {
+        GM_STR min, max;
+
+        if( ! strIsEqual(token, "number"))
+            return fail(c, "'letter' or 'number' expected: ", token);
+
+        if(nextToken(&rest, &min) <= 0 || strToInt(min, &field->min) != 0
+           || nextToken(&rest, &max) <= 0 || strToInt(max, &field->max) != 0 || field->max < field->min)
+            return fail(c, "Range expected: number MIN MAX", noArg);
+
+        if(field->min < -32768 || field->max > 32767)
+            return fail(c, "Range is too big", noArg);
+    }
+
+
+    if(nextToken(&rest, &token) > 0)
+    {
+        if( ! strIsEqual(token, "prefix") || nextToken(&rest, &token) <= 0)
+            return fail(c, "Expected: prefix TEXT", noArg);
+
+        if(token.len >= GM_TPL_PREFIX)
+            return fail(c, "Prefix is too long: ", token);
+
+        memcpy(field->prefix, token.str, token.len);
+        field->prefixLength = token.len;
+
+        if(nextToken(&rest, &token) != 0)
+            return fail(c, "Unexpected: ", token);
+    }
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+Block of text - every line till line 'end' (with '\n').
+Lines '?if [!]flag', '?else' and '?endif' are conditions.
+In 'group' block lines between '?port' and '?endport' are repeated for every port of group.
+'$' at the end of line is removed (it only shows whitespaces before it).
+*/
+static int compileBlock(GM_TPL_COMPILER* c, GM_TPL_BLOCK* block, GM_STR head)
+{
+    GM_TEMPLATE* tpl = c->tpl;
+    GM_STR line;
+
+    int jumps[GM_TPL_NESTING];  // '?if' / '?else' waiting for target
+    int nesting = 0;
+
+    int loop = -1;              // '?port' waiting for '?endport'
+    int loopNesting = 0;        // '?if' opened before '?port'
+
+
+    if(block->defined)
+        return fail(c, "Block is already defined: ", head);
+
+    block->defined = true;
+    block->first = label(c);
+
+
+    while(nextLine(c, &line))
+    {
+        if(strIsEqual(line, "end"))
+        {
+            if(loop >= 0)
+                return fail(c, "'?endport' expected", noArg);
+
+            if(nesting > 0)
+                return fail(c, "'?endif' expected", noArg);
+
+            block->end = tpl->opsNum;
+            return 0;
+        }
+
+
+        if(line.len > 3 && memcmp(line.str, "?if", 3) == 0 && isspace((unsigned char) line.str[3]))
+        {
+            GM_STR rest = { line.str + 3, line.len - 3 };
+            GM_STR flag;
+            int op;
+
+            if(nesting >= GM_TPL_NESTING)
+                return fail(c, "Too many nested '?if'", noArg);
+
+            if(nextToken(&rest, &flag) <= 0)
+                return fail(c, "Flag expected", noArg);
+
+            if( (op = addOp(c, OP_IF, 0, 0)) < 0)
+                return -1;
+
+            tpl->ops[op].neg = (flag.str[0] == '!');
+
+            if(tpl->ops[op].neg)
+            {
+                ++flag.str;
+                --flag.len;
+            }
+
+            if( (tpl->ops[op].flag = findFlag(flag)) < 0)
+                return fail(c, "Unknown flag: ", flag);
+
+            jumps[nesting++] = op;
+            label(c);
+        }
+
+        else if(strIsEqual(trim(line), "?port"))
+        {
+            if(block != &tpl->group)
+                return fail(c, "'?port' can be used only in 'group' block", noArg);
+
+            if(loop >= 0)
+                return fail(c, "Nested '?port'", noArg);
+
+            if( (loop = addOp(c, OP_PORTS, 0, 0)) < 0)
+                return -1;
+
+            loopNesting = nesting;
+            label(c);
+        }
+
+        else if(strIsEqual(trim(line), "?endport"))
+        {
+            if(loop < 0)
+                return fail(c, "'?endport' without '?port'", noArg);
+
+            if(nesting > loopNesting)
+                return fail(c, "'?endif' expected", noArg);
+
+            tpl->ops[loop].a = label(c);
+            loop = -1;
+        }
+
+        else if(strIsEqual(trim(line), "?else"))
+        {
+            int op;
+
+            if(nesting == 0 || (loop >= 0 && nesting == loopNesting))
+                return fail(c, "'?else' without '?if'", noArg);
+
+            if( (op = addOp(c, OP_JUMP, 0, 0)) < 0)
+                return -1;
+
+            tpl->ops[jumps[nesting - 1]].a = label(c);
+            jumps[nesting - 1] = op;
+        }
+
+        else if(strIsEqual(trim(line), "?endif"))
+        {
+            if(nesting == 0 || (loop >= 0 && nesting == loopNesting))
+                return fail(c, "'?endif' without '?if'", noArg);
+
+            tpl->ops[jumps[--nesting]].a = label(c);
+        }
+
+        else
+        {
+            if(line.len > 0 && line.str[line.len - 1] == '$')
+                --line.len;
+
+            if(compileText(c, line.str, line.len, tpl->varsNum) != 0 || addText(c, "\n", 1) != 0)
+                return -1;
+        }
+    }
+
+    return fail(c, "'end' expected", noArg);
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* one line outside of blocks */
+static int compileLine(GM_TPL_COMPILER* c, GM_STR line)
+{
+    GM_TEMPLATE* tpl = c->tpl;
+    GM_STR rest = line;
+    GM_STR word, token;
+
+
+    if(nextToken(&rest, &word) <= 0 || word.str[0] == '#')
+        return 0;
+
+
+    if(strIsEqual(word, "target"))
+    {
+        if(nextToken(&rest, &token) <= 0 || token.len >= TARGET_NAME_LENGTH)
+            return fail(c, "Name of target expected", noArg);
+
+        memcpy(tpl->name, token.str, token.len);
+        tpl->name[token.len] = '\0';
+        return 0;
+    }
+
+    if(strIsEqual(word, "description"))
+    {
+        rest = trim(rest);
+
+        if(rest.len >= DESCRIPTION_LENGTH)
+            return fail(c, "Description is too long", noArg);
+
+        memcpy(tpl->description, rest.str, rest.len);
+        tpl->description[rest.len] = '\0';
+        return 0;
+    }
+
+    if(strIsEqual(word, "supports"))
+    {
+        while(nextToken(&rest, &token) > 0)
+        {
+            int flag = findFlag(token);
+
+            if(flag < 0 || flag >= GM_TPL_FLAGS)
+                return fail(c, "Unknown flag: ", token);
+
+            *(bool*) ((char*) &tpl->modes + tplFlags[flag].offset) = true;
+        }
+        return 0;
+    }
+
+
+    if(strIsEqual(word, "port"))
+        return compileField(c, rest, &tpl->port);
+
+    if(strIsEqual(word, "pin"))
+        return compileField(c, rest, &tpl->pin);
+
+    if(strIsEqual(word, "int"))
+        return compileVar(c, rest, true);
+
+    if(strIsEqual(word, "text"))
+        return compileVar(c, rest, false);
+
+    if(strIsEqual(word, "at"))
+        return compileAt(c, rest);
+
+    if(strIsEqual(word, "check"))
+        return compileCheck(c, rest);
+
+    if(strIsEqual(word, "portbits"))
+    {
+        if(nextToken(&rest, &token) <= 0 || strToInt(token, &tpl->portBits) != 0
+           || tpl->portBits < 1 || tpl->portBits > GM_GROUP_PINS)
+            return fail(c, "Number of bits expected (1 - 32)", noArg);
+
+        return 0;
+    }
+
+
+    // blocks
+    if(strIsEqual(word, "init"))
+        return compileBlock(c, &tpl->init, word);
+
+    if(strIsEqual(word, "help"))
+        return compileBlock(c, &tpl->help, word);
+
+    if(strIsEqual(word, "begin"))
+        return compileBlock(c, &tpl->begin, word);
+
+    if(strIsEqual(word, "after"))
+        return compileBlock(c, &tpl->after, word);
+
+    if(strIsEqual(word, "group"))
+        return compileBlock(c, &tpl->group, word);
+
+    if(strIsEqual(word, "mode"))
+    {
+        const char* mode;
+
+        if(nextToken(&rest, &token) <= 0 || token.len != 1 || (mode = strchr(GM_PIN_MODES, token.str[0])) == NULL)
+            return fail(c, "Mode expected (one of: " GM_PIN_MODES ")", noArg);
+
+        return compileBlock(c, &tpl->mode[mode - GM_PIN_MODES], line);
+    }
+
+
+    return fail(c, "Unknown directive: ", word);
+}
+
+
+
+/*---------------------------------------------------*/
+
+GM_TEMPLATE* templateCompile(const char* text, size_t size, const char* sourceName)
+{
+    GM_TPL_COMPILER c = {0};
+    GM_STR line;
+
+
+    c.tpl = calloc(1, sizeof(GM_TEMPLATE));
+
+    if(c.tpl == NULL)
+    {
+        message(ERR, "Out of memory\n");
+        return NULL;
+    }
+
+    bufInit(&c.tpl->strings);
+
+    c.sourceName = sourceName;
+    c.pos = text;
+    c.end = text + size;
+
+    c.tpl->hash = hashData(GM_HASH_INIT, text, size);
+
+
+    while(nextLine(&c, &line))
+    {
+        if(compileLine(&c, line) != 0)
+            goto error;
+    }
+
+
+    if(c.tpl->name[0] == '\0')
+    {
+        fail(&c, "'target' is not given", noArg);
+        goto error;
+    }
+
+    if( ! c.tpl->port.defined || ! c.tpl->pin.defined)
+    {
+        fail(&c, "'port' and 'pin' are not given", noArg);
+        goto error;
+    }
+
+    for(int i=0; i<GM_TPL_MODES; ++i)
+    {
+        if( ! c.tpl->mode[i].defined)
+        {
+            GM_STR mode = { GM_PIN_MODES + i, 1 };
+
+            fail(&c, "Block is not given: mode ", mode);
+            goto error;
+        }
+    }
+
+    if(c.tpl->group.defined && c.tpl->portBits == 0)
+    {
+        fail(&c, "'portbits' is not given (needed by 'group' block)", noArg);
+        goto error;
+    }
+
+    if(c.tpl->strings.error)
+    {
+        fail(&c, "Out of memory", noArg);
+        goto error;
+    }
+
+
+    return c.tpl;
+
+
+    error:
+
+    templateFree(c.tpl);
+
+    return NULL;
+}
+
+
+
+/*---------------------------------------------------*/
+
+void templateFree(GM_TEMPLATE* tpl)
+{
+    if(tpl == NULL)
+        return;
+
+    bufFree(&tpl->strings);
+
+    free(tpl->ops);
+    free(tpl->exprs);
+    free(tpl->defs);
+    free(tpl->checks);
+
+    free(tpl);
+}
+
+
+
+const char* templateName(const GM_TEMPLATE* tpl)
+{
+    return tpl->name;
+}
+
+
+
+/*---------------------------------------------------*/
+/*  built-in & user's templates                      */
+/*---------------------------------------------------*/
+
+const GM_TEMPLATE* templateGet(const char* name, const char* builtin, size_t size)
+{
+    const GM_TEMPLATE* tpl = NULL;
+
+
+    lock();
+
+    for(GM_TEMPLATE* t = overrides; t != NULL && tpl == NULL; t = t->next)
+    {
+        if(strcmp(t->name, name) == 0)
+            tpl = t;
+    }
+
+
+    for(int i=0; i<GM_TPL_BUILTINS && tpl == NULL; ++i)
+    {
+        if(builtins[i].builtin != NULL && builtins[i].builtin != builtin)
+            continue;
+
+        if(builtins[i].builtin == NULL)
+        {
+            builtins[i].builtin = builtin;
+            builtins[i].tpl = templateCompile(builtin, size, name);
+            builtins[i].failed = (builtins[i].tpl == NULL);
+        }
+
+        if(builtins[i].failed)
+            break;
+
+        tpl = builtins[i].tpl;
+    }
+
+    unlock();
+
+
+    return tpl;
+}
+
+
+
+/*---------------------------------------------------*/
+
+void templateOverride(GM_TEMPLATE* tpl)
+{
+    lock();
+
+    tpl->next = overrides;
+    overrides = tpl;
+
+    unlock();
+}
+
+
+
+/*---------------------------------------------------*/
+/*  interpreter                                      */
+/*---------------------------------------------------*/
+
+/* the last definition of variable which matches flags & pin, or -1 */
+static int findDef(const GM_TPL_CONTEXT* ctx, int var)
+{
+    const GM_TEMPLATE* tpl = ctx->tpl;
+
+    for(int d = tpl->vars[var].last; d >= 0; d = tpl->defs[d].prev)
+    {
+        const GM_TPL_DEF* def = &tpl->defs[d];
+
+        if(def->flag >= 0 && flagIsSet(ctx, def->flag) == def->neg)
+            continue;
+
+        if(def->at && (ctx->pin == NULL || def->port != ctx->pin->port || def->pin != ctx->pin->pin))
+            continue;
+
+        return d;
+    }
+
+    return -1;
+}
+
+
+
+/*---------------------------------------------------*/
+
+static int evalExpr(const GM_TPL_CONTEXT* ctx, const GM_TPL_DEF* def)
+{
+    int stack[GM_TPL_STACK];
+    int top = 0;
+
+    for(int i=def->first; i<def->end; ++i)
+    {
+        const GM_TPL_EXPR* e = &ctx->tpl->exprs[i];
+        int b = (top > 0) ? stack[top - 1] : 0;
+
+        switch(e->code)
+        {
+            case EX_NUM:    stack[top++] = e->value;                            break;
+            case EX_PORT:   stack[top++] = ctx->pin ? ctx->pin->port : 0;       break;
+            case EX_PIN:    stack[top++] = ctx->pin ? ctx->pin->pin : 0;        break;
+            case EX_VAR:    stack[top++] = ctx->vals[e->value];                 break;
+            case EX_NEG:    stack[top - 1] = -b;                                break;
+            case EX_ADD:    stack[top - 2] += b;  --top;                        break;
+            case EX_SUB:    stack[top - 2] -= b;  --top;                        break;
+            case EX_MUL:    stack[top - 2] *= b;  --top;                        break;
+            case EX_DIV:    stack[top - 2] = b ? stack[top - 2] / b : 0;  --top; break;
+            case EX_MOD:    stack[top - 2] = b ? stack[top - 2] % b : 0;  --top; break;
+        }
+    }
+
+    return (top > 0) ? stack[0] : 0;
+}
+
+
+/* values of all 'int' variables for pin */
+static void evalInts(GM_TPL_CONTEXT* ctx)
+{
+    const GM_TEMPLATE* tpl = ctx->tpl;
+
+    for(int i=0; i<tpl->varsNum; ++i)
+    {
+        if(tpl->vars[i].isInt)
+        {
+            int d = findDef(ctx, i);
+
+            ctx->vals[i] = (d >= 0) ? evalExpr(ctx, &tpl->defs[d]) : 0;
+        }
+    }
+}
+
+
+
+/*---------------------------------------------------*/
+
+/* port or pin of actual pin */
+static void putLocation(GM_BUF* out, const GM_TPL_FIELD* field, int value)
+{
+    if(field->letter)
+        bufPutc(out, (char) value);
+    else
+        bufPutInt(out, value);
+}
+
+
+static void run(const GM_TPL_CONTEXT* ctx, GM_BUF* out, int first, int end);
+
+
+/*
+Value of group (bit 0 - the first pin) converted to bits of port (toPort)
+    or bits of port converted to value of group - one shift for every run of pins
+    with the same distance, i. e. (((x) << 2) & 0x3c) | (((x) >> 3) & 0x1)
+lane - bits of port are counted from the lowest bit used by group (toLane)
+x - variable (op->b < 0) or text - in context of port
+*/
+static void putConversion(const GM_TPL_CONTEXT* ctx, GM_BUF* out, const GM_TPL_OP* op, bool toPort, bool lane)
+{
+    const GM_TEMPLATE* tpl = ctx->tpl;
+    const GM_TPL_PORT* port = ctx->port;
+
+    int shifts[GM_GROUP_PINS];          // distance: bit of port - bit of group
+    unsigned int masks[GM_GROUP_PINS];  // bits of port with this distance
+    int terms = 0;
+
+    GM_BUF x;
+
+
+    int base = lane ? port->lowest : 0;
+
+    for(int i=0; i<port->count; ++i)
+    {
+        int shift = port->portBit[i] - base - port->groupBit[i];
+        int t = 0;
+
+        while(t < terms && shifts[t] != shift)
+            ++t;
+
+        if(t == terms)
+        {
+            shifts[terms] = shift;
+            masks[terms++] = 0;
+        }
+
+        masks[t] |= 1u << (port->portBit[i] - base);
+    }
+
+
+    bufInit(&x);
+
+    if(op->b >= 0)
+        bufWrite(&x, tpl->strings.data + op->a, op->b);
+    else if(tpl->vars[op->a].isInt)
+        bufPutInt(&x, ctx->vals[op->a]);
+    else
+    {
+        int d = findDef(ctx, op->a);
+
+        if(d >= 0)
+            run(ctx, &x, tpl->defs[d].first, tpl->defs[d].end);
+    }
+
+    bufPutc(&x, '\0');
+
+
+    if(terms > 1)
+        bufPutc(out, '(');
+
+    for(int t=0; t<terms; ++t)
+    {
+        const char* v = x.error ? "" : x.data;
+
+        if(t > 0)
+            bufPuts(out, " | ");
+
+        if(toPort && shifts[t] > 0)
+            bufPrintf(out, "(((%s) << %d) & 0x%x)", v, shifts[t], masks[t]);
+        else if(toPort && shifts[t] < 0)
+            bufPrintf(out, "(((%s) >> %d) & 0x%x)", v, -shifts[t], masks[t]);
+        else if(toPort)
+            bufPrintf(out, "((%s) & 0x%x)", v, masks[t]);
+        else if(shifts[t] > 0)
+            bufPrintf(out, "(((%s) & 0x%x) >> %d)", v, masks[t], shifts[t]);
+        else if(shifts[t] < 0)
+            bufPrintf(out, "(((%s) & 0x%x) << %d)", v, masks[t], -shifts[t]);
+        else
+            bufPrintf(out, "((%s) & 0x%x)", v, masks[t]);
+    }
+
+    if(terms > 1)
+        bufPutc(out, ')');
+
+    bufFree(&x);
+}
+
+
+/* runs instructions first ... end-1 */
+static void run(const GM_TPL_CONTEXT* ctx, GM_BUF* out, int first, int end)
+{
+    const GM_TEMPLATE* tpl = ctx->tpl;
+    const GM_PIN* pin = ctx->pin;
+
+    for(int i=first; i<end; ++i)
+    {
+        const GM_TPL_OP* op = &tpl->ops[i];
+
+        switch(op->code)
+        {
+            case OP_TEXT:
+                bufWrite(out, tpl->strings.data + op->a, op->b);
+                break;
+
+            case OP_NAME:
+                if(pin != NULL)
+                    bufPutStr(out, pin->name);
+                break;
+
+            case OP_COMMENT:
+                if(pin != NULL)
+                    bufPutStr(out, pin->comment);
+                break;
+
+            case OP_PORT:
+                if(pin != NULL)
+                    putLocation(out, &tpl->port, pin->port);
+                break;
+
+            case OP_PIN:
+                if(pin != NULL)
+                    putLocation(out, &tpl->pin, pin->pin);
+                break;
+
+            case OP_LINE:
+                if(pin != NULL)
+                    bufPutInt(out, pin->line);
+                break;
+
+            case OP_INT:
+                if(op->b)
+                    bufPrintf(out, "0x%x", (unsigned int) ctx->vals[op->a]);
+                else
+                    bufPutInt(out, ctx->vals[op->a]);
+                break;
+
+            case OP_VAR:
+            {
+                int d = findDef(ctx, op->a);
+
+                if(d >= 0)
+                    run(ctx, out, tpl->defs[d].first, tpl->defs[d].end);
+                break;
+            }
+
+            case OP_IF:
+                if(flagIsSet(ctx, op->flag) == op->neg)
+                    i = op->a - 1;
+                break;
+
+            case OP_JUMP:
+                i = op->a - 1;
+                break;
+
+
+            case OP_PINS:
+                for(int p=0; ctx->group != NULL && p<ctx->group->group->count; ++p)
+                {
+                    if(p > 0)
+                        bufPutc(out, ' ');
+
+                    bufPutStr(out, ctx->group->table->pins[ctx->group->group->pins[p]].name);
+                }
+                break;
+
+            case OP_COUNT:
+                if(ctx->group != NULL)
+                    bufPutInt(out, ctx->group->group->count);
+                break;
+
+            case OP_MASK:
+                if(ctx->port != NULL)
+                    bufPrintf(out, "0x%x", (unsigned int) ctx->port->mask);
+                else if(ctx->group != NULL)
+                    bufPrintf(out, "0x%x", (unsigned int) ((1ull << ctx->group->group->count) - 1));
+                break;
+
+            case OP_TO_PORT:
+                if(ctx->port != NULL)
+                    putConversion(ctx, out, op, true, false);
+                break;
+
+            case OP_TO_LANE:
+                if(ctx->port != NULL)
+                    putConversion(ctx, out, op, true, true);
+                break;
+
+            // outside of '?port' loop - all ports: (...) | (...)
+            case OP_FROM_PORT:
+                if(ctx->port != NULL)
+                    putConversion(ctx, out, op, false, false);
+
+                else if(ctx->group != NULL)
+                {
+                    GM_TPL_CONTEXT port = *ctx;
+
+                    for(int p=0; p<ctx->group->portsNum; ++p)
+                    {
+                        if(p > 0)
+                            bufPuts(out, " | ");
+
+                        port.port = &ctx->group->ports[p];
+                        port.pin = &port.port->pin;
+                        evalInts(&port);
+
+                        putConversion(&port, out, op, false, false);
+                    }
+                }
+                break;
+
+            case OP_PORTS:
+                if(ctx->group != NULL)
+                {
+                    GM_TPL_CONTEXT port = *ctx;
+
+                    for(int p=0; p<ctx->group->portsNum; ++p)
+                    {
+                        port.port = &ctx->group->ports[p];
+                        port.pin = &port.port->pin;
+                        evalInts(&port);
+
+                        run(&port, out, i + 1, op->a);
+                    }
+                }
+
+                i = op->a - 1;
+                break;
+        }
+    }
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+Converts PORT / PIN from input file: letter or number, optionally after prefix.
+If value starts with the first character of prefix, whole prefix is needed
+    (i. e. prefix "PORT": "PORTB" and "B" are correct, "PB" is not).
+Returns 0 or -1 if value is not correct
+*/
+static int readLocation(const GM_TPL_FIELD* field, GM_STR str, int* value)
+{
+    if(field->prefixLength > 0 && str.len > 0
+       && toupper((unsigned char) str.str[0]) == toupper((unsigned char) field->prefix[0]))
+    {
+        if(str.len <= field->prefixLength)
+            return -1;
+
+        for(int i=1; i<field->prefixLength; ++i)
+        {
+            if(field->prefix[i] != '?' && toupper((unsigned char) str.str[i]) != toupper((unsigned char) field->prefix[i]))
+                return -1;
+        }
+
+        str.str += field->prefixLength;
+        str.len -= field->prefixLength;
+    }
+
+
+    if(field->letter)
+    {
+        if(str.len != 1 || ! isalpha((unsigned char) str.str[0]))
+            return -1;
+
+        *value = toupper((unsigned char) str.str[0]);
+        return 0;
+    }
+
+    if(strToInt(str, value) != 0 || *value < field->min || *value > field->max)
+        return -1;
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+/*  functions of target module                       */
+/*---------------------------------------------------*/
+
+void templateGetData(const GM_TEMPLATE* tpl, TARGET_ATTRIBUTES* atrs)
+{
+    strncpy(atrs->description, tpl->description, DESCRIPTION_LENGTH);
+
+    atrs->presentModes = tpl->modes;
+    atrs->templateHash = tpl->hash;
+}
+
+
+
+/*---------------------------------------------------*/
+
+void templateInit(const GM_TEMPLATE* tpl, GM_BUF* out, const TARGET_FLAGS* fls)
+{
+    GM_TPL_CONTEXT ctx = { .tpl = tpl, .fls = fls };
+
+    if(tpl->init.defined)
+        run(&ctx, out, tpl->init.first, tpl->init.end);
+}
+
+
+
+/*---------------------------------------------------*/
+
+void templateHelp(const GM_TEMPLATE* tpl)
+{
+    GM_TPL_CONTEXT ctx = { .tpl = tpl };
+    GM_BUF text;
+
+    if( ! tpl->help.defined)
+        return;
+
+    bufInit(&text);
+
+    run(&ctx, &text, tpl->help.first, tpl->help.end);
+
+    fwrite(text.data, 1, text.size, stdout);
+
+    bufFree(&text);
+}
+
+
+
+/*---------------------------------------------------*/
+
+int templateValidate(const GM_TEMPLATE* tpl, GM_PIN* pin, GM_STR port, GM_STR pinNr, const TARGET_FLAGS* fls)
+{
+    GM_TPL_CONTEXT ctx = { .tpl = tpl, .fls = fls, .pin = pin };
+    int _port, _pin;
+
+
+    if(readLocation(&tpl->port, port, &_port) != 0)
+    {
+        message(ERR, "Bad PORT: %.*s\n", GM_STR_ARG(port));
+        return -1;
+    }
+
+    if(readLocation(&tpl->pin, pinNr, &_pin) != 0)
+    {
+        message(ERR, "Bad PIN: %.*s\n", GM_STR_ARG(pinNr));
+        return -1;
+    }
+
+    pin->port = _port;
+    pin->pin = _pin;
+
+
+    // warnings & errors about special pins
+    if(tpl->checksNum > 0)
+        evalInts(&ctx);
+
+    for(int i=0; i<tpl->checksNum; ++i)
+    {
+        const GM_TPL_CHECK* check = &tpl->checks[i];
+        GM_BUF msg;
+
+        if( (! check->anyPort && check->port != pin->port) || (! check->anyPin && check->pin != pin->pin)
+           || (check->modes[0] != '\0' && strchr(check->modes, pin->mode) == NULL) )
+            continue;
+
+        bufInit(&msg);
+
+        run(&ctx, &msg, check->first, check->end);
+        bufPutc(&msg, '\0');
+
+        message(check->level, "%s\n", msg.error ? "Out of memory" : msg.data);
+
+        bufFree(&msg);
+
+        if(check->level == ERR)
+            return -1;
+    }
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+int templateBegin(const GM_TEMPLATE* tpl, GM_BUF* out, const TARGET_FLAGS* fls)
+{
+    GM_TPL_CONTEXT ctx = { .tpl = tpl, .fls = fls };
+
+    if(tpl->begin.defined)
+        run(&ctx, out, tpl->begin.first, tpl->begin.end);
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+int templateEmit(const GM_TEMPLATE* tpl, GM_BUF* out, const GM_TABLE* table, const TARGET_FLAGS* fls)
+{
+    GM_TPL_CONTEXT ctx = { .tpl = tpl, .fls = fls };
+
+
+    for(int i=0; i<table->count; ++i)
+    {
+        const GM_PIN* p = &table->pins[i];
+        const char* mode = strchr(GM_PIN_MODES, p->mode);
+
+        if(p->mode == '\0' || mode == NULL)
+        {
+            message(ERR, "Unknown mode: %c\n", p->mode);
+            return -1;
+        }
+
+        ctx.pin = p;
+        evalInts(&ctx);
+
+        run(&ctx, out, tpl->mode[mode - GM_PIN_MODES].first, tpl->mode[mode - GM_PIN_MODES].end);
+
+        if(tpl->after.defined)
+            run(&ctx, out, tpl->after.first, tpl->after.end);
+    }
+
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+int templateGroup(const GM_TEMPLATE* tpl, GM_BUF* out, const GM_TABLE* table, const GM_GROUP* group, const TARGET_FLAGS* fls)
+{
+    GM_TPL_GROUP g = { .table = table, .group = group };
+    GM_TPL_CONTEXT ctx = { .tpl = tpl, .fls = fls, .group = &g };
+
+    unsigned long long allBits = (1ull << tpl->portBits) - 1;
+
+
+    if( ! tpl->group.defined)
+    {
+        message(ERR, "%s module doesn't support groups of pins (group %.*s)\n", tpl->name, GM_STR_ARG(group->name));
+        message(MSG, "\t(line: %d )\n", group->line);
+        return -1;
+    }
+
+
+    // ports of group - in order of the first pins
+    for(int i=0; i<group->count; ++i)
+    {
+        const GM_PIN* p = &table->pins[group->pins[i]];
+        GM_TPL_PORT* port;
+        int n = 0;
+
+        if(p->pin < 0 || p->pin >= tpl->portBits)
+        {
+            message(ERR, "%s: pin %s cannot be in group %.*s (%d bits of port)\n",
+                    tpl->name, p->name.str, GM_STR_ARG(group->name), tpl->portBits);
+            message(MSG, "\t(line: %d )\n", group->line);
+            return -1;
+        }
+
+        while(n < g.portsNum && g.ports[n].pin.port != p->port)
+            ++n;
+
+        port = &g.ports[n];
+
+        if(n == g.portsNum)
+        {
+            ++g.portsNum;
+
+            memset(port, 0, sizeof(*port));
+
+            port->pin.port = p->port;
+            port->pin.pin = p->pin;
+            port->pin.line = group->line;
+            port->pin.name = group->name;
+            port->pin.comment.str = "";
+            port->lowest = p->pin;
+        }
+
+        if(port->mask & (1ull << p->pin))
+        {
+            message(ERR, "%s: port & pin of %s are used twice in group %.*s\n",
+                    tpl->name, p->name.str, GM_STR_ARG(group->name));
+            message(MSG, "\t(line: %d )\n", group->line);
+            return -1;
+        }
+
+        port->mask |= 1ull << p->pin;
+        port->full = (port->mask == allBits);
+
+        if(p->pin < port->lowest)
+            port->lowest = p->pin;
+
+        port->groupBit[port->count] = i;
+        port->portBit[port->count] = p->pin;
+        ++port->count;
+    }
+
+
+    // outside of '?port' loop - name & line of group, port of the first pin
+    ctx.pin = &g.ports[0].pin;
+    evalInts(&ctx);
+
+    run(&ctx, out, tpl->group.first, tpl->group.end);
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#ifndef GM_TEMPLATE_H
+#define GM_TEMPLATE_H
+
+/*
+File:       gm-template.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Target templates (.gmt files) - target modules described as data, not code.
+
+Template is compiled once into simple bytecode: text fragments, placeholders
+(name, port, pin, variables, ...) and conditional jumps (flags '-c', '-I', '-a', '--rmw', '--bitband').
+Converting one pin only runs its mode block - there is no parsing during conversion.
+Format of templates - see CONTRIBUTING.md
+
+Built-in templates (targets/xxx.gmt) are compiled into m-gen (as targets/xxx_gmt.h)
+    and can be replaced by user's file ('--template file.gmt').
+Compiled templates are never freed (until end of program),
+    so they can be used by many threads.
+
+Needs: m-gen.h
+*/
+
+
+/* compiled template (opaque) */
+typedef struct GM_TEMPLATE_S GM_TEMPLATE;
+
+
+
+/*
+Compiles template from memory ('size' bytes, '\0' is not needed).
+sourceName - only for error messages.
+Returns new template (see templateFree())
+    or NULL in case of error (message is printed).
+*/
+GM_TEMPLATE* templateCompile(const char* text, size_t size, const char* sourceName);
+
+void templateFree(GM_TEMPLATE* tpl);
+
+// name of target (from 'target' line)
+const char* templateName(const GM_TEMPLATE* tpl);
+
+
+/*
+Template of target 'name' for target module:
+    user's template loaded by templateOverride(), or built-in one (compiled at first call).
+Returns NULL if built-in template cannot be compiled (message is printed only once).
+*/
+const GM_TEMPLATE* templateGet(const char* name, const char* builtin, size_t size);
+
+
+/*
+User's template (from templateCompile()) replaces built-in template with the same name
+    for all next calls of templateGet(). Template is owned by this module since now.
+*/
+void templateOverride(GM_TEMPLATE* tpl);
+
+
+
+/*
+Functions of target module (see TARGET_ATTRIBUTES in m-gen.h) done by template.
+templateGetData() sets only description, supported modes and hash of template.
+*/
+void templateGetData(const GM_TEMPLATE* tpl, TARGET_ATTRIBUTES* atrs);
+
+void templateInit(const GM_TEMPLATE* tpl, GM_BUF* out, const TARGET_FLAGS* fls);
+void templateHelp(const GM_TEMPLATE* tpl);
+
+int  templateValidate(const GM_TEMPLATE* tpl, GM_PIN* pin, GM_STR port, GM_STR pinNr, const TARGET_FLAGS* fls);
+int  templateBegin(const GM_TEMPLATE* tpl, GM_BUF* out, const TARGET_FLAGS* fls);
+int  templateEmit(const GM_TEMPLATE* tpl, GM_BUF* out, const GM_TABLE* table, const TARGET_FLAGS* fls);
+int  templateGroup(const GM_TEMPLATE* tpl, GM_BUF* out, const GM_TABLE* table, const GM_GROUP* group, const TARGET_FLAGS* fls);
+
+
+
+/*
+Target module described only by template - the same for every such target (see targets/avr.c):
+
+    static const char avr_template[] =
+    #include "avr_gmt.h"
+    ;
+
+    GM_TEMPLATE_TARGET(avr, avr_template)
+
+defines avr_getData() (declared in targets/avr.h) - other functions of module are static
+    and only give the template (built-in 'text' or user's one) to interpreter.
+*/
+#define GM_TEMPLATE_TARGET(name, text)                                                              \
+                                                                                                    \
+    static const GM_TEMPLATE* name##_getTemplate(void)                                              \
+    {                                                                                               \
+        return templateGet(#name, text, sizeof(text) - 1);                                          \
+    }                                                                                               \
+                                                                                                    \
+    static void name##_init(GM_BUF* out, const TARGET_FLAGS* fls)                                   \
+    {                                                                                               \
+        templateInit(name##_getTemplate(), out, fls);                                               \
+    }                                                                                               \
+                                                                                                    \
+    static int name##_validate(GM_PIN* pin, GM_STR port, GM_STR pinNr, const TARGET_FLAGS* fls)     \
+    {                                                                                               \
+        return templateValidate(name##_getTemplate(), pin, port, pinNr, fls);                       \
+    }                                                                                               \
+                                                                                                    \
+    static int name##_begin(GM_BUF* out, const TARGET_FLAGS* fls)                                   \
+    {                                                                                               \
+        return templateBegin(name##_getTemplate(), out, fls);                                       \
+    }                                                                                               \
+                                                                                                    \
+    static int name##_emit(GM_BUF* out, const GM_TABLE* table, const TARGET_FLAGS* fls)             \
+    {                                                                                               \
+        return templateEmit(name##_getTemplate(), out, table, fls);                                 \
+    }                                                                                               \
+                                                                                                    \
+    static int name##_group(GM_BUF* out, const GM_TABLE* table, const GM_GROUP* group,              \
+                            const TARGET_FLAGS* fls)                                                \
+    {                                                                                               \
+        return templateGroup(name##_getTemplate(), out, table, group, fls);                         \
+    }                                                                                               \
+                                                                                                    \
+    static void name##_help(void)                                                                   \
+    {                                                                                               \
+        templateHelp(name##_getTemplate());                                                         \
+    }                                                                                               \
+                                                                                                    \
+    void name##_getData(TARGET_ATTRIBUTES* atrs)                                                    \
+    {                                                                                               \
+        const GM_TEMPLATE* tpl = name##_getTemplate();                                              \
+                                                                                                    \
+        /* template cannot be compiled - functions are not set (message is printed) */              \
+        if(tpl == NULL)                                                                             \
+            return;                                                                                 \
+                                                                                                    \
+        templateGetData(tpl, atrs);                                                                 \
+                                                                                                    \
+        atrs->help      =  &name##_help;                                                            \
+        atrs->init      =  &name##_init;                                                            \
+        atrs->validate  =  &name##_validate;                                                        \
+        atrs->begin     =  &name##_begin;                                                           \
+        atrs->emit      =  &name##_emit;                                                            \
+        atrs->group     =  &name##_group;                                                           \
+    }
+
+
+
+#endif // GM_TEMPLATE_H
@@ -25,60 +25,55 @@ with m-gen. If not, see
 */
 
 #include <stdio.h>
-#include <string.h> //strcmp(), strrchr()
+#include <stdlib.h> //malloc()
+#include <string.h> //strcmp(), strrchr(), memchr()
 #include <ctype.h>  //toupper()
 
-#include "gm-utils.h"
 #include "m-gen.h"
+#include "gm-utils.h"
+#include "gm-common.h"
+#include "gm-output.h"
 
 
 
 /*---------------------------------------------------*/
 
 /*
-Function copies strFrom to strTo and adds or changes extension
+Function creates copy of 'name' with extension added or changed
     to newExt (in format ".new" - with or without dot).
-size - size of strTo buffer.
-If strTo is too short, name from strFrom will be truncated to fit newExt.
+Returns new string (free() it)
+    or NULL if there is no memory.
 */
 
-void changeExtension(char* strTo, const char* strFrom, size_t size, const char* newExt)
+char* changeExtension(const char* name, const char* newExt)
 {
-    char* extension;
-    int position;
-    const int newExtLenght = strlen(newExt) + 1;
-
-    extension = strrchr(strFrom, '.');
+    const char* extension = strrchr(name, '.');
 
+    size_t position = (extension == NULL) ? strlen(name) : (size_t) (extension - name);
+    size_t newExtLength = strlen(newExt);
 
-    if(extension == NULL)
-    {
-        position = strlen(strFrom);
-
-        if(position <= (size - newExtLenght) )
-            snprintf(strTo, size, "%s%s", strFrom, newExt);
+    char* newName = malloc(position + newExtLength + 1);
 
-        else
-        {
-            snprintf(strTo, size, "%s", strFrom);
 
-            snprintf( &(strTo[size-newExtLenght]), newExtLenght, "%s", newExt);
-        }
+    if(newName != NULL)
+    {
+        memcpy(newName, name, position);
+        memcpy(newName + position, newExt, newExtLength + 1);
     }
 
-    else
-    {
-        snprintf(strTo, size, "%s", strFrom);
+    return newName;
+}
 
-        position = (int) (extension - strFrom);
 
 
-        if(position <= (size - newExtLenght) )
-            snprintf( &(strTo[position]), size - position, "%s", newExt);
+char* duplicateString(const char* str)
+{
+    char* copy = malloc(strlen(str) + 1);
 
-        else
-            snprintf( &(strTo[size-newExtLenght]), newExtLenght, "%s", newExt);
-    }
+    if(copy != NULL)
+        strcpy(copy, str);
+
+    return copy;
 }
 
 
@@ -117,39 +112,90 @@ All lower case will be replaced by upper case,
     digits and upper case will be copied,
     other characters will be replaced by underscore character.
 
-Function will end:
-    if strFrom[i] == '\0'       ---'zero' will be copied
-
-    or if strFrom[size-1] != 0  ---strFrom[size-1] will be ignored
-                                 and strTo[size-1] will get '\0' value.
+Header guard is written to 'out'.
 */
-void createHeaderGuard(char* strTo, const char* strFrom, size_t size)
+void createHeaderGuard(GM_BUF* out, const char* filename)
 {
-    for(int i=0; i<(size-1); ++i)
+    for(; *filename; ++filename)
     {
+        unsigned char c = *filename;
 
-        if(isalnum(strFrom[i]))
-        {
-            if(islower(strFrom[i]))
-                strTo[i] = toupper( (unsigned)strFrom[i] );
+        if(isalnum(c))
+            bufPutc(out, toupper(c));
+
+        else
+            bufPutc(out, '_');
+    }
+}
 
-            else
-                strTo[i] = strFrom[i];
 
-        }
 
-        else if(strFrom[i] == '\0')
+/*---------------------------------------------------*/
+
+/*
+Function scans whole file (in memory) only once
+    and saves positions of all sections (in format $x) in 'sections'.
+Sequence "$$" is an escaped 'dollar' character - it doesn't start any section.
+Returns number of found sections.
+*/
+int indexSections(const char* data, size_t size, GM_SECTIONS* sections)
+{
+    const char* p = data;
+    const char* end = data + size;
+
+    // position of 'p' - for line numbers
+    const char* lineStart = data;
+    int line = 1;
+
+    int found = 0;
+
+
+    sections->data = data;
+    sections->size = size;
+
+    for(int i=0; i<GM_SECTIONS_NUM; ++i)
+        sections->offset[i] = -1;
+
+
+    // memchr() is used to jump to next '$' or '\n'
+    while( (p = memchr(p, '$', end - p)) != NULL )
+    {
+        int c;
+
+        // counting lines from last found '$'
+        const char* nl;
+
+        while( (nl = memchr(lineStart, '\n', p - lineStart)) != NULL )
         {
-            strTo[i] = '\0';
-            return;
+            ++line;
+            lineStart = nl + 1;
         }
 
 
-        else
-            strTo[i] = '_';
+        if(++p >= end)
+            break;
+
+        c = (unsigned char) *p;  //next character - section letter or second '$'
+
+        if(c == '\n' || c >= GM_SECTIONS_NUM)
+            continue;
+
+        ++p;
+
+        if(c == '$')
+            continue;
+
+        // only first occurrence of section is used
+        if(sections->offset[c] < 0)
+        {
+            sections->offset[c] = p - data;
+            sections->line[c] = line;
+            sections->column[c] = (int) (p - lineStart) + 1;
+            ++found;
+        }
     }
 
-    strTo[size-1] = '\0';
+    return found;
 }
 
 
@@ -157,43 +203,39 @@ void createHeaderGuard(char* strTo, const char* strFrom, size_t size)
 /*---------------------------------------------------*/
 
 /*
-Funcion finds given section (sectionLetter) (in format $x)
-    in given file (read permission required),
-    sets position in file to start of this sections (after '$' and sectionLetter)
-    and additionally returns this position
-        or -1 in case of error.
+Funcion sets lexer at start of given section (sectionLetter)
+    (after '$' and sectionLetter), using positions from indexSections().
+Lexer reads data to the end of file.
+Returns 0 if success
+    or -1 in case of error.
 */
-long findSection(FILE* fp, char sectionLetter)
+int gotoSection(GM_LEXER* lex, const GM_SECTIONS* sections, char sectionLetter)
 {
-    char c;
+    unsigned char letter = (unsigned char) sectionLetter;
+    long position;
 
-    if(sectionLetter == '$')
+    if(letter == '$' || letter >= GM_SECTIONS_NUM)
         return -1;
 
-    // goto start of file
-    if( fseek(fp, 0, SEEK_SET) != 0)
-        return -1;
+    position = sections->offset[letter];
 
-    while( (c=getc(fp)) != EOF )
+    if(position < 0)
     {
-        if(c == '$')    //'dollar' - new section sign
-        {
-            c = getc(fp); //next character
-            if(c == sectionLetter)
-                return ftell(fp);
-        }
+        message(ERR, "Cannot find section '$%c' in input file. \n", sectionLetter);
+        return -1;
     }
 
-    message(ERR, "Cannot find section '$%c' in input file. \n", sectionLetter);
-    return -1;
+    lexInit(lex, sections->data + position, sections->data + sections->size,
+            sections->line[letter], sections->column[letter]);
+
+    return 0;
 }
 
 
 /*---------------------------------------------------*/
 
-void printPinModes(FILE* output)
-{
-    fprintf(output,
+/* description of modes - printed by 'm-gen --help' and placed in every new .gm file */
+static const char pinModesText[] =
         "Avaiable modes of GPIO:                                            \n"
         "     digital gpio - i. e. communication with other digital chips   \n"
         "   i   digital Input                                               \n"
@@ -205,8 +247,19 @@ void printPinModes(FILE* output)
         "          (it uses internal pull-up resistor)                      \n"
         "   l   active Low output   -  / for transistors / leds etc.        \n"
         "   h   active High output  - /                                     \n"
-        "                                                                   \n"
-        );
+        "                                                                   \n";
+
+
+
+void printPinModes(FILE* output)
+{
+    fputs(pinModesText, output);
+}
+
+
+const char* getPinModesText(void)
+{
+    return pinModesText;
 }
 
 
@@ -214,9 +267,8 @@ void printPinModes(FILE* output)
 
 
 
-void printPinMacros(FILE* output)
-{
-    fprintf(output,
+/* description of macros - printed by 'm-gen --help' and placed in every .h file */
+static const char pinMacrosText[] =
         "m-gen creates set of macros for each gpio.                 \n"
         "It depends on gpio mode from .gm file.                     \n"
         "                                                           \n"
@@ -261,6 +313,9 @@ void printPinMacros(FILE* output)
         "                           | (high/low)                    \n"
         "   #define abc_setLow()    +                               \n"
         "                                                           \n"
+        "   #define abc_toggle()    - changing state of gpio to the \n"
+        "                             opposite one (high <-> low)   \n"
+        "                                                           \n"
         "       It's required to use setHigh() or setLow() macro    \n"
         "       after dirOut(), because state of gpio is unknown.   \n"
         "                                                           \n"
@@ -283,7 +338,8 @@ void printPinMacros(FILE* output)
         "   #define abc_isLow()     |                               \n"
         "                           |                               \n"
         "   #define abc_setHigh()   |                               \n"
-        "   #define abc_setLow()    +                               \n"
+        "   #define abc_setLow()    |                               \n"
+        "   #define abc_toggle()    +                               \n"
         "                                                           \n"
         "                                                           \n"
         "                                                           \n"
@@ -300,6 +356,9 @@ void printPinMacros(FILE* output)
         "   #define abc_Off()       - changing state of gpio        \n"
         "                             to turn 'Off' actuator        \n"
         "                                                           \n"
+        "   #define abc_toggle()    - turning actuator 'On' if it's \n"
+        "                             'Off' and vice versa          \n"
+        "                                                           \n"
         "                                                           \n"
         "                                                           \n"
         "active low input with internal pull-up resistor (b):       \n"
@@ -314,8 +373,60 @@ void printPinMacros(FILE* output)
         "   #define abc_isInactive()- checking if sensor is inactive\n"
         "                                                           \n"
         "                                                           \n"
-        );
+        ;
 
+
+
+const char* getPinMacrosText(void)
+{
+    return pinMacrosText;
+}
+
+
+
+/* macros of groups of pins - placed in .h file only if there is '$g' section */
+static const char groupMacrosText[] =
+        "Macros for group of pins:  (abc - name of group from '$g'  \n"
+        "   section of .gm file - one line: abc pin0 pin1 pin2 ...) \n"
+        "                                                           \n"
+        "   Bit 0 of mask / value is pin0, bit 1 - pin1, ...        \n"
+        "   (value is the state of gpio: 1 - high, 0 - low,         \n"
+        "    also for active low pins)                              \n"
+        "   Every port register is written only once, so all pins   \n"
+        "   of group in one port change state at the same time.     \n"
+        "                                                           \n"
+        "   #define abc_set(mask)   - changing state of pins from   \n"
+        "                             mask to high                  \n"
+        "                                                           \n"
+        "   #define abc_clear(mask) - changing state of pins from   \n"
+        "                             mask to low                   \n"
+        "                                                           \n"
+        "   #define abc_write(value)- changing state of all pins    \n"
+        "                             of group at once              \n"
+        "                                                           \n"
+        "   #define abc_read()      - reading state of all pins     \n"
+        "                             i. e.:                        \n"
+        "                             if( abc_read() == 0x5 ) {code}\n"
+        "                                                           \n"
+        "       Direction of pins is not changed - use macros       \n"
+        "       of each pin (dirOut(), asOutput(), ...) before.     \n"
+        "                                                           \n"
+        "                                                           \n"
+        ;
+
+
+
+const char* getGroupMacrosText(void)
+{
+    return groupMacrosText;
+}
+
+
+
+void printPinMacros(FILE* output)
+{
+    fputs(pinMacrosText, output);
+    fputs(groupMacrosText, output);
 }
 
 
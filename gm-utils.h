@@ -30,12 +30,19 @@ with m-gen. If not, see
 
 
 /*
-Function copies strFrom to strTo and adds or changes extension
+Function creates copy of 'name' with extension added or changed
     to newExt (in format ".new" - with or without dot).
-size - size of strTo buffer.
-If strTo is too short, name from strFrom will be truncated to fit newExt.
+Returns new string (free() it)
+    or NULL if there is no memory.
 */
-void changeExtension(char* strTo, const char* strFrom, size_t size, const char* newExt);
+char* changeExtension(const char* name, const char* newExt);
+
+
+/*
+Copy of string (as strdup()) - free() it.
+Returns NULL if there is no memory.
+*/
+char* duplicateString(const char* str);
 
 
 /*
@@ -54,24 +61,53 @@ All lower case will be replaced by upper case,
     digits and upper case will be copied,
     other characters will be replaced by underscore character.
 
-Function will end:
-    if strFrom[i] == '\0'       ---'zero' will be copied
+Header guard is written to 'out'.
+*/
+void createHeaderGuard(GM_BUF* out, const char* filename);
+
+
+
+/*
+Positions of all sections in .gm file.
+    offset['x'] - position in data just after '$' and section letter 'x'
+        (first occurrence of section), or -1 if section is not present.
+    line['x'], column['x'] - the same position as line & column numbers
+        (for GM_LEXER)
+*/
+#define GM_SECTIONS_NUM     (128)
+
+typedef struct{
+
+    const char* data;
+    size_t size;
+
+    long offset[GM_SECTIONS_NUM];
+
+    int line[GM_SECTIONS_NUM];
+    int column[GM_SECTIONS_NUM];
+
+} GM_SECTIONS;
 
-    or if strFrom[size-1] != 0  ---strFrom[size-1] will be ignored
-                                 and strTo[size-1] will get '\0' value.
+
+
+/*
+Function scans whole file (in memory) only once
+    and saves positions of all sections (in format $x) in 'sections'.
+Sequence "$$" is an escaped 'dollar' character - it doesn't start any section.
+Returns number of found sections.
 */
-void createHeaderGuard(char* strTo, const char* strFrom, size_t size);
+int indexSections(const char* data, size_t size, GM_SECTIONS* sections);
 
 
 
 /*
-Funcion finds given section (sectionLetter) (in format $x)
-    in given file (read permission required),
-    sets position in file to start of this sections (after '$' and sectionLetter)
-    and additionally returns this position
-        or -1 in case of error.
+Funcion sets lexer at start of given section (sectionLetter)
+    (after '$' and sectionLetter), using positions from indexSections().
+Lexer reads data to the end of file.
+Returns 0 if success
+    or -1 in case of error.
 */
-long findSection(FILE* fp, char sectionLetter);
+int gotoSection(GM_LEXER* lex, const GM_SECTIONS* sections, char sectionLetter);
 
 
 
@@ -81,6 +117,13 @@ Printing informations about macros
 void printPinModes(FILE* output);
 void printPinMacros(FILE* output);
 
+// the same texts as printPinModes() & printPinMacros() print
+const char* getPinModesText(void);
+const char* getPinMacrosText(void);
+
+// description of macros of groups of pins ('$g' section) - also printed by printPinMacros()
+const char* getGroupMacrosText(void);
+
 
 
 #endif // GM_UTILS_H
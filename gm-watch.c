@@ -0,0 +1,639 @@
+/*
+File:       gm-watch.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#define _POSIX_C_SOURCE 200809L     // inotify, poll(), sockets
+#define _XOPEN_SOURCE 700           // realpath()
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), realloc(), realpath()
+#include <string.h> //strlen(), strcmp()
+#include <errno.h>
+
+#include "m-gen.h"
+#include "gm-common.h"
+#include "gm-input.h"
+#include "gm-watch.h"
+
+
+#ifdef __linux__
+  #include <unistd.h>
+  #include <fcntl.h>    //fcntl() - non-blocking clients
+  #include <time.h>     //clock_gettime()
+  #include <signal.h>
+  #include <poll.h>
+  #include <dirent.h>
+  #include <sys/inotify.h>
+  #include <sys/stat.h>   //lstat()
+  #include <sys/socket.h>
+  #include <sys/un.h>
+
+  #define GM_HAVE_INOTIFY
+#endif
+
+
+
+#ifdef GM_HAVE_INOTIFY
+
+
+/* max length of one socket request (path of .gm file) */
+#define GM_REQUEST_LENGTH   4096
+
+/* max number of clients of socket at once (next ones wait in queue of listen()) */
+#define GM_CLIENTS_MAX      8
+
+/* client without whole request after this time [s] is disconnected */
+#define GM_CLIENT_TIMEOUT   5
+
+
+/*
+Connected client of socket - request is read in parts (non-blocking), between them
+    other clients and changed files are served
+*/
+typedef struct{
+
+    int fd;
+    size_t len;
+    time_t start;
+    char request[GM_REQUEST_LENGTH];
+
+} GM_CLIENT;
+
+
+/*
+One converted .gm file - hash of its content after last conversion.
+Parsed document isn't kept: changed file must be parsed again anyway, unchanged one is skipped
+    by this hash (request from socket converts it, but its header is up to date - not written).
+*/
+typedef struct{
+
+    char* path;
+    unsigned long long hash;
+
+} GM_WATCHED;
+
+
+/*
+State of watch mode
+*/
+typedef struct{
+
+    const char* dir;
+    char* realDir;      // 'dir' without links, '.', '..' - requests from socket must be inside
+
+    GM_WATCHED* files;
+    int filesNum;
+    int filesCapacity;
+
+    GM_GENERATE_FN generate;
+    void* ctx;
+
+} GM_WATCH;
+
+
+
+
+/* set by SIGINT / SIGTERM - watch mode ends and socket is removed */
+static volatile sig_atomic_t stopRequest = 0;
+
+static void stopHandler(int sig)
+{
+    (void) sig;
+    stopRequest = 1;
+}
+
+
+
+/*---------------------------------------------------*/
+
+// 1 if name ends with ".gm"
+static int isGmFile(const char* name)
+{
+    size_t len = strlen(name);
+
+    return len > 3 && strcmp(name + len - 3, ".gm") == 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+static GM_WATCHED* findFile(GM_WATCH* w, const char* path)
+{
+    for(int i=0; i<w->filesNum; ++i)
+    {
+        if(strcmp(w->files[i].path, path) == 0)
+            return &w->files[i];
+    }
+
+
+    if(w->filesNum == w->filesCapacity)
+    {
+        int capacity = (w->filesCapacity == 0) ? 16 : 2 * w->filesCapacity;
+        GM_WATCHED* files = realloc(w->files, capacity * sizeof(GM_WATCHED));
+
+        if(files == NULL)
+            return NULL;
+
+        w->files = files;
+        w->filesCapacity = capacity;
+    }
+
+
+    w->files[w->filesNum].path = malloc(strlen(path) + 1);
+
+    if(w->files[w->filesNum].path == NULL)
+        return NULL;
+
+    strcpy(w->files[w->filesNum].path, path);
+    w->files[w->filesNum].hash = 0;
+
+    return &w->files[w->filesNum++];
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+Converts one .gm file.
+force - 0: file isn't converted if its content is the same as last time
+Returns 0 or -1 in case of error.
+*/
+static int regenerate(GM_WATCH* w, const char* path, int force)
+{
+    GM_INPUT input;
+    GM_WATCHED* file;
+    unsigned long long hash;
+
+
+    if(openInput(&input, path) != 0)
+    {
+        perror(path);
+        return -1;
+    }
+
+    hash = hashData(GM_HASH_INIT, input.data, input.size);
+
+    closeInput(&input);
+
+
+    file = findFile(w, path);
+
+    if(file == NULL)
+    {
+        message(ERR, "Out of memory\n");
+        return -1;
+    }
+
+    if(force == 0 && file->hash == hash)
+        return 0;
+
+
+    if(w->generate(path, w->ctx) != 0)
+    {
+        file->hash = 0;     // converted again next time
+        return -1;
+    }
+
+    file->hash = hash;
+
+    return 0;
+}
+
+
+
+/*---------------------------------------------------*/
+
+// path = dir/name
+static int regenerateInDir(GM_WATCH* w, const char* name, int force)
+{
+    char* path = malloc(strlen(w->dir) + strlen(name) + 2);
+    int retval;
+
+    if(path == NULL)
+    {
+        message(ERR, "Out of memory\n");
+        return -1;
+    }
+
+    sprintf(path, "%s/%s", w->dir, name);
+
+    retval = regenerate(w, path, force);
+
+    free(path);
+
+    return retval;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+Path from socket request - only .gm files in watched directory (or in its subdirectories)
+    are converted, so clients can't read or write other files.
+*/
+static int regenerateRequest(GM_WATCH* w, const char* request)
+{
+    char* path = realpath(request, NULL);
+    size_t dirLen = strlen(w->realDir);
+    int retval = -1;
+
+    // "/" - every absolute path
+    if(dirLen == 1)
+        dirLen = 0;
+
+    if(path == NULL)
+        perror(request);
+
+    else if(!isGmFile(path) || strncmp(path, w->realDir, dirLen) != 0 || path[dirLen] != '/')
+        message(ERR, "%s: Not a .gm file in %s\n", request, w->dir);
+
+    else
+        retval = regenerateInDir(w, path + dirLen + 1, 1);
+
+    free(path);
+
+    return retval;
+}
+
+
+
+/*---------------------------------------------------*/
+
+static int openSocket(const char* socketPath)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    int fd;
+
+
+    if(strlen(socketPath) >= sizeof(addr.sun_path))
+    {
+        message(ERR, "Socket path is too long: %s\n", socketPath);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socketPath);
+
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if(fd < 0)
+    {
+        perror(socketPath);
+        return -1;
+    }
+
+    // old socket from previous run - other files are never removed
+    if(lstat(socketPath, &st) == 0)
+    {
+        if(!S_ISSOCK(st.st_mode))
+        {
+            message(ERR, "%s: Address in use (not a socket)\n", socketPath);
+            close(fd);
+            return -1;
+        }
+
+        unlink(socketPath);
+    }
+
+    if(bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0  ||  listen(fd, 16) != 0)
+    {
+        perror(socketPath);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+
+/*---------------------------------------------------*/
+
+static time_t now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec;
+}
+
+
+
+/*---------------------------------------------------*/
+
+/*
+One request from socket: "path\n" -> "OK\n" / "ERROR\n"
+Reads what is available now (socket of client is non-blocking).
+Returns 1 if request is finished (client can be closed)
+    or 0 if the rest of line is expected.
+*/
+static int serveClient(GM_WATCH* w, GM_CLIENT* c)
+{
+    const char* answer;
+
+
+    // reads to the end of line (or connection)
+    while(c->len < sizeof(c->request) - 1)
+    {
+        long n = read(c->fd, c->request + c->len, sizeof(c->request) - 1 - c->len);
+
+        if(n < 0 && errno == EINTR)
+            continue;
+
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 0;
+
+        if(n <= 0)
+            break;
+
+        c->len += n;
+
+        if(memchr(c->request, '\n', c->len) != NULL)
+            break;
+    }
+
+    c->request[c->len] = 0;
+
+    // without '\r', '\n' at the end
+    c->len = strcspn(c->request, "\r\n");
+    c->request[c->len] = 0;
+
+
+    if(c->len > 0 && regenerateRequest(w, c->request) == 0)
+        answer = "OK\n";
+    else
+        answer = "ERROR\n";
+
+    // client may be gone - without SIGPIPE
+    if(send(c->fd, answer, strlen(answer), MSG_NOSIGNAL) < 0)
+        perror("socket");
+
+    return 1;
+}
+
+
+
+/*---------------------------------------------------*/
+
+int watchDirectory(const char* dir, const char* socketPath, GM_GENERATE_FN generate, void* ctx)
+{
+    GM_WATCH w = {
+        .dir = dir,
+        .realDir = NULL,
+        .files = NULL,
+        .filesNum = 0,
+        .filesCapacity = 0,
+        .generate = generate,
+        .ctx = ctx
+    };
+
+    // inotify, socket, clients
+    struct pollfd fds[2 + GM_CLIENTS_MAX];
+    int fdsNum = 1;
+
+    GM_CLIENT clients[GM_CLIENTS_MAX];
+    int clientsNum = 0;
+
+    int retval = 0;
+
+
+    int inotifyFd;
+
+
+    w.realDir = realpath(dir, NULL);
+
+    if(w.realDir == NULL)
+    {
+        perror(dir);
+        return -1;
+    }
+
+    inotifyFd = inotify_init();
+
+    if(inotifyFd < 0  ||
+        inotify_add_watch(inotifyFd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        perror(dir);
+
+        if(inotifyFd >= 0)
+            close(inotifyFd);
+
+        free(w.realDir);
+
+        return -1;
+    }
+
+    fds[0].fd = inotifyFd;
+    fds[0].events = POLLIN;
+
+
+    if(socketPath != NULL)
+    {
+        fds[1].fd = openSocket(socketPath);
+        fds[1].events = POLLIN;
+
+        if(fds[1].fd < 0)
+        {
+            close(inotifyFd);
+            free(w.realDir);
+            return -1;
+        }
+
+        fdsNum = 2;
+    }
+
+
+
+    // all files at the beginning
+    {
+        DIR* d = opendir(dir);
+        struct dirent* entry;
+
+        if(d == NULL)
+        {
+            perror(dir);
+            retval = -1;
+            goto close_fds;
+        }
+
+        while( (entry = readdir(d)) != NULL )
+        {
+            if(isGmFile(entry->d_name))
+                regenerateInDir(&w, entry->d_name, 0);
+        }
+
+        closedir(d);
+    }
+
+
+    message(MSG, "Watching %s ...\n", dir);
+
+
+    // without SA_RESTART - poll() is interrupted
+    {
+        struct sigaction sa;
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = &stopHandler;
+        sigemptyset(&sa.sa_mask);
+
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+    }
+
+
+    while(stopRequest == 0)
+    {
+        int socketFds = (fdsNum > 1) ? 2 : 1;
+
+        // new clients only if there is free place for them
+        if(fdsNum > 1)
+            fds[1].events = (clientsNum < GM_CLIENTS_MAX) ? POLLIN : 0;
+
+        for(int i=0; i<clientsNum; ++i)
+        {
+            fds[socketFds + i].fd = clients[i].fd;
+            fds[socketFds + i].events = POLLIN;
+            fds[socketFds + i].revents = 0;
+        }
+
+        // with clients - wakes up to check their timeouts
+        if(poll(fds, socketFds + clientsNum, (clientsNum > 0) ? 1000 : -1) < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            perror("poll");
+            retval = -1;
+            break;
+        }
+
+
+        // changed files
+        if(fds[0].revents & POLLIN)
+        {
+            union{
+                struct inotify_event event;
+                char data[64 * (sizeof(struct inotify_event) + 256)];
+            } events;
+
+            long len = read(inotifyFd, &events, sizeof(events));
+
+            for(long pos = 0; pos < len; )
+            {
+                const struct inotify_event* event = (const struct inotify_event*) (events.data + pos);
+
+                if(event->len > 0 && isGmFile(event->name))
+                    regenerateInDir(&w, event->name, 0);
+
+                pos += sizeof(struct inotify_event) + event->len;
+            }
+        }
+
+
+        // requests from build tools - the finished ones and too slow ones are removed
+        for(int i = clientsNum - 1; i >= 0; --i)
+        {
+            int done;
+
+            if(fds[socketFds + i].revents != 0)
+                done = serveClient(&w, &clients[i]);
+            else
+                done = (now() - clients[i].start > GM_CLIENT_TIMEOUT);
+
+            if(done)
+            {
+                close(clients[i].fd);
+                clients[i] = clients[--clientsNum];
+            }
+        }
+
+        if(fdsNum > 1  &&  (fds[1].revents & POLLIN) )
+        {
+            int client = accept(fds[1].fd, NULL, NULL);
+
+            if(client >= 0)
+            {
+                GM_CLIENT* c = &clients[clientsNum++];
+
+                fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+
+                c->fd = client;
+                c->len = 0;
+                c->start = now();
+            }
+        }
+    }
+
+
+
+    close_fds:
+
+    close(inotifyFd);
+
+    for(int i=0; i<clientsNum; ++i)
+        close(clients[i].fd);
+
+    if(fdsNum > 1)
+    {
+        close(fds[1].fd);
+        unlink(socketPath);
+    }
+
+    for(int i=0; i<w.filesNum; ++i)
+        free(w.files[i].path);
+
+    free(w.files);
+    free(w.realDir);
+
+    return retval;
+}
+
+
+
+#else   // GM_HAVE_INOTIFY
+
+
+int watchDirectory(const char* dir, const char* socketPath, GM_GENERATE_FN generate, void* ctx)
+{
+    (void) dir;
+    (void) socketPath;
+    (void) generate;
+    (void) ctx;
+
+    message(ERR, "'--watch' mode is supported only on Linux\n");
+
+    return -1;
+}
+
+
+#endif  // GM_HAVE_INOTIFY
@@ -0,0 +1,57 @@
+#ifndef GM_WATCH_H
+#define GM_WATCH_H
+
+/*
+File:       gm-watch.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+Persistent mode ('--watch dir'):
+    ('generate' - see GM_GENERATE_FN in m-gen.h)
+    - all .gm files in 'dir' are converted at the beginning,
+    - next, every changed (saved) .gm file is converted immediately (inotify),
+      only hash of last converted content is kept in memory (not parsed document),
+      so unchanged files are skipped,
+    - if 'socketPath' isn't NULL, local UNIX socket is created there.
+      Every request is one line with path of .gm file in 'dir' or its subdirectory
+      (other paths - also links to files outside of 'dir' - are refused), i. e.:
+            gpiodefs.gm
+      File is converted and the answer is sent:
+            OK      or      ERROR
+      (Build tools can ask for regeneration without starting new process).
+      Requests are read without blocking - a client without whole line in 5 s is disconnected.
+
+Works until error, SIGINT or SIGTERM.
+Returns 0 after signal
+    or -1 in case of error (message is printed)
+    - i. e. on systems without inotify.
+*/
+int watchDirectory(const char* dir, const char* socketPath, GM_GENERATE_FN generate, void* ctx);
+
+
+
+#endif // GM_WATCH_H
@@ -0,0 +1,543 @@
+/*
+File:       libmgen.c
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+#define _POSIX_C_SOURCE 200809L     // flockfile()
+
+#include <stdio.h>
+#include <stdlib.h> //malloc(), free()
+#include <string.h>
+#include <stdarg.h>
+
+#include "m-gen.h"
+#include "gm-utils.h"
+#include "gm-output.h"
+#include "gm-document.h"
+#include "gm-ir.h"
+#include "gm-template.h"
+#include "libmgen.h"
+
+
+#if defined __unix__ || defined __APPLE__
+  #include <pthread.h>
+
+  #define GM_HAVE_THREADS
+#endif
+
+
+
+/* MGEN_DOCUMENT is opaque for users of library */
+struct MGEN_DOCUMENT_S{
+
+    GM_DOCUMENT doc;
+
+};
+
+
+
+/* static variables */
+
+
+/* How many informations are printed.
+    selected by mgen_setSilentLevel() ('-s' comand line flag),
+    used by message()
+*/
+static int silentLevel = 0;
+
+/* user's function for messages (NULL - stdout / stderr) */
+static MGEN_MESSAGE_FN messageHandler = NULL;
+static void* messageContext = NULL;
+
+/* recorded warnings of actual thread - see messageRecord() */
+#ifdef GM_HAVE_THREADS
+  static pthread_key_t recordKey;
+  static pthread_once_t recordOnce = PTHREAD_ONCE_INIT;
+
+  static void createRecordKey(void)
+  {
+      pthread_key_create(&recordKey, NULL);
+  }
+#else
+  static GM_BUF* record = NULL;
+#endif
+
+
+
+/*---------------------------------------------------*/
+
+static GM_BUF* getRecord(void)
+{
+#ifdef GM_HAVE_THREADS
+    pthread_once(&recordOnce, &createRecordKey);
+
+    return pthread_getspecific(recordKey);
+#else
+    return record;
+#endif
+}
+
+
+void messageRecord(GM_BUF* buf)
+{
+#ifdef GM_HAVE_THREADS
+    pthread_once(&recordOnce, &createRecordKey);
+
+    pthread_setspecific(recordKey, buf);
+#else
+    record = buf;
+#endif
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+/*
+Print message to output
+    level - predefined macro from m-gen.h (i. e. MSG or ERR )
+    format, ... - printf() syntax
+
+Inspired by DebugPrintf() from lpc21isp project
+    https://github.com/capiman/lpc21isp
+
+*/
+void message(int level, const char* format, ...)
+{
+    va_list args;
+
+
+    const char* prefix[5];
+
+    prefix[MSG]     = P_MSG;
+    prefix[NOTE]    = P_NOTE;
+    prefix[WARN]    = P_WARN;
+    prefix[ERR]     = P_ERR;
+    prefix[FATAL]   = P_FATAL;
+
+    FILE* output = (level == MSG) ? stdout : stderr;
+
+    GM_BUF* recorded = (level == WARN) ? getRecord() : NULL;
+
+
+
+    // recorded also if it isn't printed
+    if(recorded != NULL)
+    {
+        char text[1024];
+
+        va_start(args, format);
+        vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+
+        bufPuts(recorded, text);
+        bufPutc(recorded, '\0');
+    }
+
+
+    if(level < silentLevel)
+        return;
+
+
+    // whole message as one text for user's function
+    if(messageHandler != NULL)
+    {
+        char text[1024];
+        int len = snprintf(text, sizeof(text), "%s", prefix[level]);
+
+        va_start(args, format);
+        vsnprintf(text + len, sizeof(text) - len, format, args);
+        va_end(args);
+
+        messageHandler(level, text, messageContext);
+    }
+
+    else
+    {
+        va_start(args, format);
+
+        // prefix and message together - also if many threads print messages
+#if defined __unix__ || defined __APPLE__
+        flockfile(output);
+#endif
+
+        fprintf(output, "%s", prefix[level]);
+
+        vfprintf(output, format, args);
+
+        fflush(output);
+
+#if defined __unix__ || defined __APPLE__
+        funlockfile(output);
+#endif
+
+        va_end(args);
+    }
+
+
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+void mgen_setMessageHandler(MGEN_MESSAGE_FN handler, void* ctx)
+{
+    messageHandler = handler;
+    messageContext = ctx;
+}
+
+
+
+void mgen_setSilentLevel(int level)
+{
+    silentLevel = level;
+}
+
+
+
+const char* mgen_version(void)
+{
+    return VERSION;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+static void setFlags(TARGET_FLAGS* fls, const MGEN_OPTIONS* options)
+{
+    fls->compatibilityMode = (options != NULL && options->compatibilityMode);
+    fls->inlineFunc = (options != NULL && options->inlineFunc);
+    fls->atomicMode = (options != NULL && options->atomicMode);
+    fls->rmwMode = (options != NULL && options->rmwMode);
+    fls->bitbandMode = (options != NULL && options->bitbandMode);
+}
+
+
+/* moves content of buffer to user */
+static int releaseBuf(GM_BUF* buf, char** data, size_t* size)
+{
+    if(buf->error)
+    {
+        message(ERR, "Out of memory\n");
+        bufFree(buf);
+        return -1;
+    }
+
+    *data = buf->data;
+    *size = buf->size;
+
+    return 0;
+}
+
+
+
+
+/*
+Ends buffer with flush function (mgen_xxxTo() functions)
+retval - result of emitHeader(), exportIR(), ...
+*/
+static int finishStream(GM_BUF* buf, int retval)
+{
+    if(retval == 0 && bufFlush(buf) != 0)
+        retval = -1;
+
+    // errors of 'write' function are reported by caller
+    if(buf->error == 1)
+        message(ERR, "Out of memory\n");
+
+    bufFree(buf);
+
+    return retval;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+MGEN_DOCUMENT* mgen_open(const char* data, size_t size, const MGEN_OPTIONS* options)
+{
+    TARGET_FLAGS fls;
+
+    MGEN_DOCUMENT* doc = malloc(sizeof(MGEN_DOCUMENT));
+
+    if(doc == NULL)
+    {
+        message(ERR, "Out of memory\n");
+        return NULL;
+    }
+
+
+    setFlags(&fls, options);
+
+    if(openDocument(&doc->doc, data, size, &fls) != 0)
+    {
+        mgen_close(doc);
+        return NULL;
+    }
+
+    return doc;
+}
+
+
+
+int mgen_parse(MGEN_DOCUMENT* doc)
+{
+    return parseDocument(&doc->doc);
+}
+
+
+
+int mgen_targetsNum(const MGEN_DOCUMENT* doc)
+{
+    return doc->doc.targetsNum;
+}
+
+
+
+const char* mgen_targetName(const MGEN_DOCUMENT* doc, int target)
+{
+    if(target < 0 || target >= doc->doc.targetsNum)
+        return NULL;
+
+    return getTargetLabels()[doc->doc.targets[target]].name;
+}
+
+
+
+void mgen_setThreads(MGEN_DOCUMENT* doc, int threads)
+{
+    doc->doc.threads = threads;
+}
+
+
+
+void mgen_outputHash(const MGEN_DOCUMENT* doc, int target, const char* outputName, char* hash)
+{
+    documentHash(&doc->doc, target, outputName, hash);
+}
+
+
+
+int mgen_emit(MGEN_DOCUMENT* doc, int target, const char* outputName, char** data, size_t* size)
+{
+    GM_BUF out;
+
+    bufInit(&out);
+
+    if(emitHeader(&doc->doc, target, outputName, &out) != 0)
+    {
+        bufFree(&out);
+        return -1;
+    }
+
+    return releaseBuf(&out, data, size);
+}
+
+
+
+int mgen_exportIR(const MGEN_DOCUMENT* doc, char** data, size_t* size)
+{
+    GM_BUF out;
+
+    bufInit(&out);
+
+    if(exportIR(&doc->doc, &out) != 0)
+    {
+        bufFree(&out);
+        return -1;
+    }
+
+    return releaseBuf(&out, data, size);
+}
+
+
+
+int mgen_importIR(MGEN_DOCUMENT* doc, const char* data, size_t size)
+{
+    return importIR(&doc->doc, data, size);
+}
+
+
+
+int mgen_exportJson(const MGEN_DOCUMENT* doc, char** data, size_t* size)
+{
+    GM_BUF out;
+
+    bufInit(&out);
+
+    if(exportJson(&doc->doc, &out) != 0)
+    {
+        bufFree(&out);
+        return -1;
+    }
+
+    return releaseBuf(&out, data, size);
+}
+
+
+
+int mgen_emitTo(MGEN_DOCUMENT* doc, int target, const char* outputName, MGEN_WRITE_FN write, void* ctx)
+{
+    GM_BUF out;
+
+    bufInit(&out);
+    bufSetFlush(&out, write, ctx);
+
+    return finishStream(&out, emitHeader(&doc->doc, target, outputName, &out));
+}
+
+
+
+int mgen_exportIRTo(const MGEN_DOCUMENT* doc, MGEN_WRITE_FN write, void* ctx)
+{
+    GM_BUF out;
+
+    bufInit(&out);
+    bufSetFlush(&out, write, ctx);
+
+    return finishStream(&out, exportIR(&doc->doc, &out));
+}
+
+
+
+int mgen_exportJsonTo(const MGEN_DOCUMENT* doc, MGEN_WRITE_FN write, void* ctx)
+{
+    GM_BUF out;
+
+    bufInit(&out);
+    bufSetFlush(&out, write, ctx);
+
+    return finishStream(&out, exportJson(&doc->doc, &out));
+}
+
+
+
+void mgen_close(MGEN_DOCUMENT* doc)
+{
+    if(doc == NULL)
+        return;
+
+    closeDocument(&doc->doc);
+    free(doc);
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int mgen_generate(const char* gmData, size_t gmSize, const MGEN_OPTIONS* options,
+                  const char* outputName, char** data, size_t* size)
+{
+    int retval = -1;
+
+    MGEN_DOCUMENT* doc = mgen_open(gmData, gmSize, options);
+
+    if(doc != NULL && mgen_parse(doc) >= 0)
+        retval = mgen_emit(doc, 0, outputName, data, size);
+
+    mgen_close(doc);
+
+    return retval;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int mgen_createInput(const char* targetName, const MGEN_OPTIONS* options, char** data, size_t* size)
+{
+    const TARGET_LABEL* labels = getTargetLabels();
+
+    TARGET_FLAGS fls;
+    GM_BUF out;
+
+
+    for(int i=0; i<HOW_MANY_TARGETS; ++i)
+    {
+        if(strcmp(targetName, labels[i].name) == 0)
+        {
+            setFlags(&fls, options);
+
+            bufInit(&out);
+            createSkeleton(&out, i, &fls);
+
+            return releaseBuf(&out, data, size);
+        }
+    }
+
+
+    message(ERR, "Unknown target: %s\n", targetName);
+
+    return -1;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+int mgen_loadTemplate(const char* data, size_t size, const char* name)
+{
+    const TARGET_LABEL* labels = getTargetLabels();
+
+    GM_TEMPLATE* tpl = templateCompile(data, size, name);
+
+
+    if(tpl == NULL)
+        return -1;
+
+    for(int i=0; i<HOW_MANY_TARGETS; ++i)
+    {
+        if(strcmp(templateName(tpl), labels[i].name) == 0)
+        {
+            templateOverride(tpl);
+            return 0;
+        }
+    }
+
+
+    message(ERR, "%s: unknown target: %s\n", name, templateName(tpl));
+
+    templateFree(tpl);
+
+    return -1;
+}
+
+
+
+
+/*---------------------------------------------------*/
+
+void mgen_free(char* data)
+{
+    free(data);
+}
@@ -0,0 +1,278 @@
+#ifndef LIBMGEN_H
+#define LIBMGEN_H
+
+/*
+File:       libmgen.h
+Project:    m-gen
+Version:    1.3
+
+Copyright (C) 2019 leopardus
+
+This file is part of m-gen
+    https://github.com/Leopardus4/m-gen
+
+m-gen is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 3,
+as published by the Free Software Foundation.
+
+m-gen is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+with m-gen. If not, see
+    http://www.gnu.org/licenses/
+
+
+*/
+
+
+
+/*
+libmgen - m-gen as a library.
+
+Converts .gm file from memory buffer into C header(s) in memory
+    - without any files, temporary files or FILE* streams.
+Program m-gen is a thin wrapper around these functions.
+
+Example:
+
+    MGEN_OPTIONS options = { .compatibilityMode = 0, .inlineFunc = 1 };
+
+    MGEN_DOCUMENT* doc = mgen_open(gmData, gmSize, &options);
+
+    if(doc != NULL && mgen_parse(doc) >= 0)
+    {
+        for(int i=0; i < mgen_targetsNum(doc); ++i)
+        {
+            char* header;
+            size_t size;
+
+            if(mgen_emit(doc, i, "gpiodefs.h", &header, &size) == 0)
+            {
+                // ... use header (size bytes, not terminated by '\0')
+                mgen_free(header);
+            }
+        }
+    }
+
+    mgen_close(doc);
+
+Every document is independent - many documents can be used at once
+    (also in different threads).
+Messages (errors, warnings) are printed to stdout / stderr
+    or given to function set by mgen_setMessageHandler().
+*/
+
+
+#include <stddef.h>     // size_t
+
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+
+
+
+/* message levels - see mgen_setMessageHandler() */
+#define MGEN_MSG    (0)     /* simple message */
+#define MGEN_NOTE   (1)     /* important informations about converting macros */
+#define MGEN_WARN   (2)     /* warning */
+#define MGEN_ERR    (3)     /* error */
+#define MGEN_FATAL  (4)     /* library is not complete */
+
+
+/* length of hash from mgen_outputHash() (with '\0') */
+#define MGEN_HASH_LENGTH    (16 + 1)
+
+
+
+/* Converted .gm file (opaque) */
+typedef struct MGEN_DOCUMENT_S MGEN_DOCUMENT;
+
+
+/* Flags (the same as -c, -I, -a, --rmw and --bitband in m-gen program): 0 or 1 */
+typedef struct{
+
+    int compatibilityMode;
+    int inlineFunc;
+    int atomicMode;
+    int rmwMode;
+    int bitbandMode;
+
+} MGEN_OPTIONS;
+
+
+/*
+Function for messages:
+    level - MGEN_MSG ... MGEN_FATAL
+    text - one message (with prefix, i. e. "Error: ")
+*/
+typedef void (*MGEN_MESSAGE_FN)(int level, const char* text, void* ctx);
+
+
+
+/* Version of library - i. e. "1.3" */
+const char* mgen_version(void);
+
+
+/*
+Sets function for all messages (NULL - default: stdout / stderr).
+ctx is given to handler.
+*/
+void mgen_setMessageHandler(MGEN_MESSAGE_FN handler, void* ctx);
+
+
+/*
+Messages with level lower than 'level' are ignored.
+    0 - all (default), 1 - without MGEN_MSG (as '-s' in m-gen), ...
+*/
+void mgen_setSilentLevel(int level);
+
+
+
+/*
+Opens .gm file from memory (data - 'size' bytes, '\0' is not needed)
+    and reads targets from '$t' section.
+data must be valid until mgen_close().
+options - NULL for default (all 0).
+Returns new document
+    or NULL in case of error (message is printed).
+*/
+MGEN_DOCUMENT* mgen_open(const char* data, size_t size, const MGEN_OPTIONS* options);
+
+
+/*
+Reads and checks all pins.
+Returns number of pins
+    or -1 in case of error (message is printed).
+*/
+int mgen_parse(MGEN_DOCUMENT* doc);
+
+
+/* Number of targets in '$t' section and name of each of them (0 ... targetsNum-1) */
+int mgen_targetsNum(const MGEN_DOCUMENT* doc);
+
+const char* mgen_targetName(const MGEN_DOCUMENT* doc, int target);
+
+
+/*
+Number of threads used by mgen_emit() and mgen_emitTo() for big tables of pins
+    (output is always the same as from one thread).
+    1 - default, 0 - number of CPUs.
+*/
+void mgen_setThreads(MGEN_DOCUMENT* doc, int threads);
+
+
+/*
+Hash of everything what affects output (input, version, options, target, header guard from output name)
+    - it's written in generated header after "m-gen hash: ".
+If existing header has the same hash, it doesn't have to be generated again.
+mgen_parse() is not needed.
+hash - MGEN_HASH_LENGTH chars
+*/
+void mgen_outputHash(const MGEN_DOCUMENT* doc, int target, const char* outputName, char* hash);
+
+
+/*
+Creates header for given target (after mgen_parse()).
+outputName - name of header file (only for header guard)
+*data - new buffer - caller owns it and must release it by mgen_free(),
+*size - its length.
+Returns 0 if success
+    or -1 in case of error.
+*/
+int mgen_emit(MGEN_DOCUMENT* doc, int target, const char* outputName, char** data, size_t* size);
+
+
+void mgen_close(MGEN_DOCUMENT* doc);
+
+
+
+/*
+Function which gets output in parts (see mgen_emitTo()):
+    returns 0 or -1 in case of error (generating is stopped).
+*/
+typedef int (*MGEN_WRITE_FN)(const char* data, size_t size, void* ctx);
+
+/*
+The same as mgen_emit(), mgen_exportIR() and mgen_exportJson(), but output is given
+    to 'write' function in parts (of about 64 KB) - memory doesn't depend on size of output.
+ctx is given to 'write'.
+Returns 0 if success
+    or -1 in case of error (also if 'write' failed - without message).
+*/
+int mgen_emitTo(MGEN_DOCUMENT* doc, int target, const char* outputName, MGEN_WRITE_FN write, void* ctx);
+
+int mgen_exportIRTo(const MGEN_DOCUMENT* doc, MGEN_WRITE_FN write, void* ctx);
+
+int mgen_exportJsonTo(const MGEN_DOCUMENT* doc, MGEN_WRITE_FN write, void* ctx);
+
+
+
+/*
+Compiled form of document (binary IR) - see gm-ir.h for format.
+mgen_exportIR() - after mgen_parse(); *data, *size - as in mgen_emit().
+    Returns 0 if success or -1 in case of error.
+mgen_importIR() - instead of mgen_parse(), for document opened from the same .gm file
+    (data isn't needed after return).
+    Returns number of pins or -1 if data doesn't match this document (nothing is printed).
+*/
+int mgen_exportIR(const MGEN_DOCUMENT* doc, char** data, size_t* size);
+
+int mgen_importIR(MGEN_DOCUMENT* doc, const char* data, size_t size);
+
+
+/*
+All pins of document (after mgen_parse() or mgen_importIR()) as JSON.
+*data, *size - as in mgen_emit()
+Returns 0 if success
+    or -1 in case of error.
+*/
+int mgen_exportJson(const MGEN_DOCUMENT* doc, char** data, size_t* size);
+
+
+
+/*
+All at once - for .gm files with one target:
+    the same as mgen_open(), mgen_parse(), mgen_emit() for first target and mgen_close().
+Returns 0 if success
+    or -1 in case of error.
+*/
+int mgen_generate(const char* gmData, size_t gmSize, const MGEN_OPTIONS* options,
+                  const char* outputName, char** data, size_t* size);
+
+
+/*
+Creates content of new .gm file for given target (i. e. "avr")
+    - the same as 'm-gen --init'.
+*data, *size - as in mgen_emit()
+Returns 0 if success
+    or -1 if target is unknown.
+*/
+int mgen_createInput(const char* targetName, const MGEN_OPTIONS* options, char** data, size_t* size);
+
+
+/*
+Replaces built-in template of target by user's template (.gmt file - see CONTRIBUTING.md),
+    i. e. changed copy of targets/avr.gmt. Target is given by 'target' line of template.
+It's used by all documents opened later (and it's a part of their mgen_outputHash()).
+data - 'size' bytes, not needed after return; name - only for messages.
+Returns 0 if success
+    or -1 in case of error (message is printed).
+*/
+int mgen_loadTemplate(const char* data, size_t size, const char* name);
+
+
+/* Releases buffers from mgen_emit(), mgen_generate() and mgen_createInput() */
+void mgen_free(char* data);
+
+
+
+#ifdef __cplusplus
+  }
+#endif
+
+
+#endif // LIBMGEN_H
@@ -26,18 +26,24 @@ with m-gen. If not, see
 
 
 #include <stdio.h>
-#include <string.h> //strcmp()
+#include <stdlib.h> //strtol()
+#include <string.h> //strcmp(), memchr()
 #include <stdarg.h>
+#include <ctype.h> //tolower()
 
 
 #include "m-gen.h"
 #include "gm-utils.h"
 #include "gm-common.h"
+#include "gm-input.h"
+#include "gm-output.h"
+#include "gm-document.h"
+#include "gm-watch.h"
+#include "gm-batch.h"
+#include "gm-stats.h"
+#include "gm-cache.h"
 
-// targets:
-#include "avr.h"
-#include "lpc111x.h"
-#include "lpc17xx.h"
+#include "libmgen.h"
 
 
 
@@ -45,32 +51,33 @@ with m-gen. If not, see
 
 /* Function declarations */
 
-static int readParameters  (int argc, char * argv [], FLAGS* fls, TARGET_LABEL labels[]);
+static int readParameters  (int argc, char * argv [], FLAGS* fls, const TARGET_LABEL labels[]);
+static int loadTemplates(const FLAGS* fls);
 
-static int createInputFile(const FLAGS* fls, const TARGET_ATTRIBUTES* atr, const char* targetname);
+static int createInputFile(const FLAGS* fls, const char* targetname);
 
-static int generateMacros(FLAGS* fls, const TARGET_LABEL labels[]);
+static int convertFiles(FLAGS* fls);
+static int generateMacros(FLAGS* fls);
 
+static int createDepFile(const FLAGS* fls, char* const outputNames[], int outputsNum);
+static int createStamp(const FLAGS* fls);
 
-static void help(TARGET_LABEL labels[]);
-
-static void printMainPage(void);
-static void printVersion(void);
-static void printProgHeader(void);
+static int generateFile(const char* path, void* ctx);
 
+static bool isStdio(const char* name);
+static bool writesToStdout(const FLAGS* fls);
+static int writeStdout(const char* data, size_t size, void* ctx);
 
+static double spanStart(void);
 
-/* static variables */
-
-
-/* How many informations are printed.
-    selected by '-s' comand line flag,
-    used by message()
-*/
-static int silentLevel = 0;
+static int checkParallel(MGEN_DOCUMENT* doc, int target, const char* outputName, int threads);
 
 
+static void help(const TARGET_LABEL labels[]);
 
+static void printMainPage(void);
+static void printVersion(void);
+static void printProgHeader(void);
 
 
 
@@ -79,41 +86,24 @@ int main(int argc, char * argv [])
 
     int ret_val=0;
 
+    // beginning of time for '--stats' and '--trace'
+    double start = statsNow();
 
-    // pointers to initializers
-    TARGET_LABEL labels[HOW_MANY_TARGETS] = {
 
-        //AVR
-        [_AVR] = {
-            .name = "avr",
-            .getData = &avr_getData
-        },
+    // all supported targets - see gm-document.c
+    const TARGET_LABEL* labels = getTargetLabels();
 
-        [_LPC111X] = {
-            .name = "lpc111x",
-            .getData = &lpc111x_getData
-        },
-
-        [_LPC17XX] = {
-            .name = "lpc17xx",
-            .getData = &lpc17xx_getData
-        }
 
-        // next targets should be initialized here
 
-    };
-    /*
-    This array contains references to supported targets.
-    All operations on it must use following syntax:
-    labels[_TARGETMACRO] or labels[TARGETS_enumeration]
-    _TARGETMACRO is defined in gm.h file as a constans number.
-    enumeration TARGETS - i. e. flags.target - see below.
-    */
+    //structure initialized by labels[x].getData()
+    TARGET_ATTRIBUTES targetAttrs = {0};
 
 
+    // all input files (or directories) - pointers to argv
+    const char* inputFiles[argc];
 
-    //structure initialized by labels[x].getData()
-    TARGET_ATTRIBUTES targetAttrs = {0};
+    // user's templates ('--template') - pointers to argv
+    const char* templateFiles[argc];
 
 
     //flags given as parameters
@@ -130,11 +120,41 @@ int main(int argc, char * argv [])
 
         .targetFlags.inlineFunc = false,
 
+        .targetFlags.atomicMode = false,
+
+        .targetFlags.rmwMode = false,
+
+        .targetFlags.bitbandMode = false,
+
 
         .target = ANY,
 
-        .inputFileName[0] = 0,
-        .outputFileName[0] = 0,
+        .inputFileName = NULL,
+        .outputFileName = NULL,
+
+        .depFile = false,
+        .depFileName = NULL,
+        .stampFileName = NULL,
+        .irFile = false,
+        .jsonFile = false,
+        .watchDir = NULL,
+        .socketName = NULL,
+
+        .programName = argv[0],
+
+        .inputFiles = inputFiles,
+        .inputFilesNum = 0,
+        .jobs = 0,
+        .checkParallel = false,
+        .stats = false,
+        .traceFileName = NULL,
+
+        .templateFiles = templateFiles,
+        .templateFilesNum = 0,
+
+        .cacheDir = NULL,
+        .cacheSize = 0,
+        .cacheLink = false,
     };
 
 
@@ -150,6 +170,21 @@ int main(int argc, char * argv [])
     if(ret_val != 0)
         return ret_val;
 
+    statsEnable(flags.stats, flags.traceFileName);
+    statsSpan("arguments", NULL, start);
+
+
+    // before any use of targets
+    ret_val = loadTemplates(&flags);
+
+    if(ret_val != 0)
+        return ret_val;
+
+
+    // header written to standard output - other messages would be mixed with it
+    if(flags.init == false && writesToStdout(&flags))
+        mgen_setSilentLevel(1);
+
 
 
 
@@ -178,7 +213,8 @@ int main(int argc, char * argv [])
 
         if(targetAttrs.help == NULL
            || targetAttrs.init == NULL
-           || targetAttrs.macroGen == NULL )
+           || targetAttrs.validate == NULL
+           || targetAttrs.emit == NULL )
         {
             message(FATAL, "%s\n", ERR_MSG_INCOMPLETE_SOURCES);
             return 101;
@@ -202,7 +238,7 @@ int main(int argc, char * argv [])
     else if(flags.init==true)
     {
         if (flags.target != ANY)
-            return createInputFile(&flags, &targetAttrs, labels[flags.target].name);
+            return createInputFile(&flags, labels[flags.target].name);
         else
         {
             message(ERR, "Target not specified\n");
@@ -212,7 +248,19 @@ int main(int argc, char * argv [])
     }
 
     else
-        return generateMacros(&flags, labels);
+    {
+        if(flags.cacheDir != NULL
+            && cacheEnable(flags.cacheDir, flags.cacheSize, flags.cacheLink) != 0)
+            return 1;
+
+        ret_val = convertFiles(&flags);
+
+        // '--stats' & '--trace'
+        if(statsFinish() != 0)
+            ret_val = 1;
+
+        return ret_val;
+    }
 }
 
 
@@ -227,7 +275,7 @@ int main(int argc, char * argv [])
 /*---------------------------------------------------*/
 
 /* Reading arguments */
-int readParameters( int argc, char * argv [], FLAGS* fls, TARGET_LABEL labels[] )
+int readParameters( int argc, char * argv [], FLAGS* fls, const TARGET_LABEL labels[] )
 {
 
     for(int i=1; i<argc; ++i)
@@ -252,9 +300,14 @@ int readParameters( int argc, char * argv [], FLAGS* fls, TARGET_LABEL labels[]
 
         else if(strcmp(argv[i], "-o")==0)
         {
+            if(i + 1 >= argc)
+            {
+                message(ERR, "File name expected after %s\n", argv[i]);
+                return 1;
+            }
+
             fls->otherName = true;
-            strncpy(fls->outputFileName, argv[++i], (FILENAME_LENGTH - 1) );    //next argument - output file name
-            fls->outputFileName[FILENAME_LENGTH - 1]=0;
+            fls->outputFileName = argv[++i];    //next argument - output file name
         }
 
 
@@ -286,7 +339,7 @@ int readParameters( int argc, char * argv [], FLAGS* fls, TARGET_LABEL labels[]
 
         // 'silent mode' - only errors & warnings will be printed
         else if(strcmp(argv[i], "-s")==0)
-            silentLevel = 1;
+            mgen_setSilentLevel(1);
 
 
         // 'compatibility mode' - some additional macros
@@ -302,12 +355,152 @@ int readParameters( int argc, char * argv [], FLAGS* fls, TARGET_LABEL labels[]
 
 
 
+        // 'atomic' mode - no read-modify-write of whole port (if possible)
+        else if( (strcmp(argv[i], "-a")==0)
+              || (strcmp(argv[i], "--atomic")==0) )
+            fls->targetFlags.atomicMode = true;
+
+
+
+        // 'rmw' mode - old read-modify-write macros
+        else if(strcmp(argv[i], "--rmw")==0)
+            fls->targetFlags.rmwMode = true;
+
+
+
+        // 'bitband' mode - bit-band alias addresses
+        else if(strcmp(argv[i], "--bitband")==0)
+            fls->targetFlags.bitbandMode = true;
+
+
+
+        // number of threads (batch mode or big table of pins)
+        else if(strncmp(argv[i], "-j", 2)==0)
+        {
+            const char* number = (argv[i][2] != 0) ? &argv[i][2] : argv[++i];
+            char* end;
+
+            if(number == NULL
+                || (fls->jobs = (int) strtol(number, &end, 10)) <= 0
+                || *end != 0)
+            {
+                message(ERR, "Number of jobs expected after -j\n");
+                return 1;
+            }
+        }
+
+
+        // compiled .gm file & JSON dump
+        else if(strcmp(argv[i], "--ir")==0)
+            fls->irFile = true;
+
+        else if(strcmp(argv[i], "--json")==0)
+            fls->jsonFile = true;
+
+
+        // determinism of parallel emitting
+        else if(strcmp(argv[i], "--check-parallel")==0)
+            fls->checkParallel = true;
+
+
+        // statistics & trace file ('--trace=file.json' or '--trace file.json')
+        else if(strcmp(argv[i], "--stats")==0)
+            fls->stats = true;
+
+        else if(strncmp(argv[i], "--trace", 7)==0  &&  (argv[i][7] == '=' || argv[i][7] == 0))
+        {
+            fls->traceFileName = (argv[i][7] == '=') ? &argv[i][8] : argv[++i];
+
+            if(fls->traceFileName == NULL || fls->traceFileName[0] == 0)
+            {
+                message(ERR, "File name expected after --trace\n");
+                return 1;
+            }
+        }
+
+
+        // dependency file (make / ninja)
+        else if(strcmp(argv[i], "-MD")==0)
+            fls->depFile = true;
+
+        else if( (strcmp(argv[i], "-MF")==0)
+              || (strcmp(argv[i], "--stamp")==0)
+              || (strcmp(argv[i], "--watch")==0)
+              || (strcmp(argv[i], "--socket")==0)
+              || (strcmp(argv[i], "--template")==0)
+              || (strcmp(argv[i], "--cache")==0) )
+        {
+            const char** name;
+
+            if(strcmp(argv[i], "-MF")==0)
+                name = &fls->depFileName;
+            else if(strcmp(argv[i], "--cache")==0)
+                name = &fls->cacheDir;
+            else if(strcmp(argv[i], "--template")==0)
+                name = &fls->templateFiles[fls->templateFilesNum++];
+            else if(strcmp(argv[i], "--stamp")==0)
+                name = &fls->stampFileName;
+            else if(strcmp(argv[i], "--watch")==0)
+                name = &fls->watchDir;
+            else
+                name = &fls->socketName;
+
+            if(i + 1 >= argc)
+            {
+                message(ERR, "File name expected after %s\n", argv[i]);
+                return 1;
+            }
+
+            if(name == &fls->depFileName)
+                fls->depFile = true;
+
+            *name = argv[++i];   //next argument - file name
+        }
+
+
+        // shared cache of headers - max. size ('--cache-size 500M') and hard links
+        else if(strcmp(argv[i], "--cache-size")==0)
+        {
+            char* end = NULL;
+
+            if(i + 1 < argc)
+                fls->cacheSize = strtoull(argv[++i], &end, 10);
+
+            if(end == NULL || end == argv[i])
+            {
+                message(ERR, "Size expected after --cache-size\n");
+                return 1;
+            }
+
+            // suffix: k, M, G (not case sensitive) - 1024, 1024^2, 1024^3
+            const char* suffixes = "kmg";
+            const char* suffix = (*end != 0) ? strchr(suffixes, tolower((unsigned char) *end)) : NULL;
+
+            if(suffix != NULL)
+            {
+                for(const char* s = suffixes; s <= suffix; ++s)
+                    fls->cacheSize *= 1024;
+
+                ++end;
+            }
+
+            if(*end != 0 || fls->cacheSize == 0)
+            {
+                message(ERR, "Wrong size of cache: %s\n", argv[i]);
+                return 1;
+            }
+        }
+
+        else if(strcmp(argv[i], "--cache-link")==0)
+            fls->cacheLink = true;
+
+
         //Here insert new supported parameters
         // ...
 
 
-        // Wrong parameter
-        else if(argv[i][0] == '-')
+        // Wrong parameter ("-" alone is standard input)
+        else if(argv[i][0] == '-' && argv[i][1] != 0)
             {
                 message(ERR, "Unknown parameter: %s\n", argv[i]);
                 return 1;
@@ -315,18 +508,50 @@ int readParameters( int argc, char * argv [], FLAGS* fls, TARGET_LABEL labels[]
 
 
         // If actual parameter is not a flag (first character !=  '-' ),
-        // it's a name of input file.
+        // it's a name of input file ("-" - standard input).
         else
         {
-            if(fls->inputFileName[0] == 0)
-                strncpy(fls->inputFileName, argv[i], (FILENAME_LENGTH - 1) );
-            else
+            if(fls->inputFileName == NULL)
+                fls->inputFileName = argv[i];
+            else if(fls->init == true)
             {
                 message(ERR, "Too many input files given: %s and %s\n", fls->inputFileName, argv[i]);
                 return 1;
             }
+
+            fls->inputFiles[fls->inputFilesNum++] = argv[i];
+        }
+
+    }
+
+    return 0;
+}
+
+
+/*---------------------------------------------------*/
+/*
+Loads user's templates ('--template file.gmt') - they replace built-in templates of targets.
+Returns 0 if success or 1 in case of error.
+*/
+int loadTemplates(const FLAGS* fls)
+{
+    for(int i=0; i<fls->templateFilesNum; ++i)
+    {
+        GM_INPUT input;
+        int retval;
+
+        if(openInput(&input, fls->templateFiles[i]) != 0)
+        {
+            perror(fls->templateFiles[i]);
+            return 1;
         }
 
+        retval = mgen_loadTemplate(input.data, input.size, fls->templateFiles[i]);
+
+        closeInput(&input);
+
+        if(retval != 0)
+            return 1;
     }
 
     return 0;
@@ -338,21 +563,30 @@ int readParameters( int argc, char * argv [], FLAGS* fls, TARGET_LABEL labels[]
 This function creates an input file (.gm)
 */
 
-int createInputFile(const FLAGS* fls, const TARGET_ATTRIBUTES* atr, const char* targetname)
+int createInputFile(const FLAGS* fls, const char* targetname)
 {
-    message(MSG, "Generating file %s\n"
-           "\tTarget: %s\n", fls->inputFileName, targetname);
+    MGEN_OPTIONS options = {
+        .compatibilityMode = fls->targetFlags.compatibilityMode,
+        .inlineFunc = fls->targetFlags.inlineFunc,
+        .atomicMode = fls->targetFlags.atomicMode,
+        .rmwMode = fls->targetFlags.rmwMode,
+        .bitbandMode = fls->targetFlags.bitbandMode
+    };
 
+    GM_BUF out;
 
 
-    if(fls->inputFileName[0] == 0)
+    if(fls->inputFileName == NULL)
     {
         message(ERR, "Please put file name\n");
         return 1;
     }
 
 
-    FILE* fp;
+    message(MSG, "Generating file %s\n"
+           "\tTarget: %s\n", fls->inputFileName, targetname);
+
+
 
     /* If file already exist, return error */
     if(fileExist(fls->inputFileName))
@@ -366,540 +600,922 @@ int createInputFile(const FLAGS* fls, const TARGET_ATTRIBUTES* atr, const char*
 
 
 
-    /* Creating skelet of file */
+    /* Creating skelet of file (libmgen) */
+
+    bufInit(&out);
 
-    fp = fopen(fls->inputFileName, "w");
+    if(mgen_createInput(targetname, &options, &out.data, &out.size) != 0)
+        return 1;
 
-    if(fp == NULL)
+    if(writeOutput(&out, fls->inputFileName, NULL) != 0)
     {
         perror(fls->inputFileName);
+        mgen_free(out.data);
         return 1;
     }
 
-
-    fprintf(fp, "File auto-generated by m-gen v%s program. \n"
-    			"	(see: https://github.com/Leopardus4/m-gen ) \n"
-         		"Please write some macro prototypes and use m-gen to create C header file from it.\n"
-         		"\n", VERSION);
+    mgen_free(out.data);
 
 
-    /*
-    All sections in input file starts at sequence '$x'
-    where 'x' is reserved letter for definite section
-    */
-
-    /*
-    Printing target name in format:
-
-        $t
-        TARGET
-
-    */
-    fprintf(fp, "$t" "\n");
-    fprintf(fp, "%s\n\n", targetname);
+    message(MSG, "Done\n");
 
-    /*
-    Printing comment about file in format:
+    return 0;
+}
 
-        $c
-        Example
-        long
-        comment
 
-    */
-    fprintf(fp, "$c" "\n");
-    fprintf(fp, "Write here your comment\n"
-         "    about whole file\n\n");
 
 
-    /*
-    Creating macros section and 'other' section.
-    This fragment calls proper function (via pointer from TARGET_ATTRIBUTES structure).
+/*---------------------------------------------------*/
+/*
+Converting .gm files: one file, batch mode or persistent mode (and stamp)
+*/
 
-    Called function must write following sections:
+int convertFiles(FLAGS* fls)
+{
+    // stamp can be created alone (without input file) - i. e. by separate rule in Makefile
+    if(fls->stampFileName != NULL)
+    {
+        if(createStamp(fls) != 0)
+            return 1;
 
-    (example for AVR)
+        if(fls->inputFileName == NULL && fls->watchDir == NULL)
+            return 0;
+    }
 
-        $m
-        Mode PORT PIN Name Comment
 
-        i   B   4   SDATA1 Exemplary comment...
+    if(fls->watchDir != NULL)
+    {
+        if(fls->inputFileName != NULL || fls->otherName == true)
+        {
+            message(ERR, "Don't use input file name and '-o' option with '--watch'\n");
+            return 1;
+        }
 
-        $o
-        Some info how to use this sheet
-        Explanation of $m
-          - MCU-dependent data (port, pin) should be written by called function
-          - other - mode, name, comment - written below
+        return (watchDirectory(fls->watchDir, fls->socketName,
+                        &generateFile, fls) == 0) ? 0 : 1;
+    }
 
-    */
 
-    atr->init(fp, &(fls->targetFlags) );
+    // one file - as always
+    if(fls->inputFilesNum <= 1  &&  ! pathIsDirectory(fls->inputFileName))
+        return generateMacros(fls);
 
 
     /*
-    additional informations about *.gm file (at the end of '$o' section)
+    Batch mode - many files (or directories) at once
     */
+    {
+        GM_FILE_LIST list;
+        int errors = 0;
 
-    //mode of pin
-    fprintf(fp,
-        "\n"
-        "   MODE: type of GPIO. \n");
+        if(fls->otherName == true || fls->depFileName != NULL)
+        {
+            message(ERR, "Don't use '-o' and '-MF' options with many input files\n");
+            return 1;
+        }
 
-    printPinModes(fp);
+        for(int i=0; i<fls->inputFilesNum; ++i)
+        {
+            if(isStdio(fls->inputFiles[i]))
+            {
+                message(ERR, "Standard input ('-') can't be used with many input files\n");
+                return 1;
+            }
+        }
 
+        fileListInit(&list);
 
-    //Name, comment
-    fprintf(fp,
-        "                                                                   \n"
-        "   Name:                                                           \n"
-        "   Symbolic name for pin (i.e. function in project) without spaces \n"
-        "   (up to 120 characters)                                          \n"
-        "                                                                   \n"
-        "   Comment:                                                        \n"
-        "   Few words about pin function in project                         \n"
-        "   ( only one line - do not use 'Enter'; max 500 characters)       \n"
-        "                                                                   \n"
-        );
+        for(int i=0; i<fls->inputFilesNum && errors == 0; ++i)
+        {
+            if(fileListAdd(&list, fls->inputFiles[i]) != 0)
+                errors = 1;
+        }
 
+        if(errors == 0)
+        {
+            errors = runBatch(&list, fls->jobs, &generateFile, fls);
 
+            if(errors != 0)
+                message(ERR, "%d of %d files cannot be converted\n", errors, list.num);
+            else
+                message(MSG, "Done. %d files converted.\n", list.num);
+        }
 
-    fprintf(fp,
-        "                                                                   \n"
-        "Write some macros and use 'm-gen filename' command                 \n"
-        "   to create C header file with '#define' macros.                  \n"
-        "Use 'm-gen --help' for more info.                                  \n"
-        "                                                                   \n"
-        "-------------------------------------------------------------------\n"
-        "                                                                   \n"
-        "Do not use single 'dollar' character ($$) in this file             \n"
-        "   ( if it's necessary, use two $$ ).                              \n"
-        "Do not use '*/' sequence in comments                               \n"
-        "   (comments will be automaticcaly placed in /* ... */ )           \n"
-        "Do not edit '$$t' section.                                         \n"
-        "                                                                   \n"
-        );
+        fileListFree(&list);
 
+        return (errors == 0) ? 0 : 1;
+    }
+}
 
-    fclose(fp);
 
 
-    message(MSG, "Done\n");
+/*---------------------------------------------------*/
 
-    return 0;
-}
 
+int generateMacros(FLAGS* fls)
+{
+    int retval = 0;
 
+    int macrosNum = -1;     // stays -1 if all files are up to date
 
+    int targetsNum = 0;
 
-/*---------------------------------------------------*/
+    // all names are allocated - there are no limits of paths
+    char* outputNames[HOW_MANY_TARGETS] = {NULL};
+    bool upToDate[HOW_MANY_TARGETS];
+    int upToDateNum = 0;
 
+    // hashes of outputs - keys of cache ('--cache dir'), headers copied from it
+    char hashes[HOW_MANY_TARGETS][MGEN_HASH_LENGTH];
+    bool cached[HOW_MANY_TARGETS] = {false};
+    int cachedNum = 0;
 
-int generateMacros(FLAGS* fls, const TARGET_LABEL labels[])
-{
-    /* This file will be used to store changes.
-    If process fails, tmpfile will be deleted
-    (If previous output file already exist, it wouldn't be deleted).
-    */
-    char tempFile[] = ".m_gen_tmp.tmp";
+    char* irName = NULL;
+    bool irLoaded = false;
+
+    MGEN_OPTIONS options = {
+        .compatibilityMode = fls->targetFlags.compatibilityMode,
+        .inlineFunc = fls->targetFlags.inlineFunc,
+        .atomicMode = fls->targetFlags.atomicMode,
+        .rmwMode = fls->targetFlags.rmwMode,
+        .bitbandMode = fls->targetFlags.bitbandMode
+    };
 
-    char headerGuard[FILENAME_LENGTH] = {0};
+    MGEN_DOCUMENT* doc;
 
-    int retval = 0;
+    // 'm-gen - -o -' : .gm file from stdin, header(s) to stdout (without temporary files & backups)
+    bool fromStdin = isStdio(fls->inputFileName);
+    bool toStdout = writesToStdout(fls);
 
-    int macrosNum;
+    // output names - for header guards only if 'toStdout'
+    const char* nameBase = (fls->otherName == true) ? fls->outputFileName : fls->inputFileName;
 
-    TARGET_ATTRIBUTES attrs = {0};
+    // for '--stats' and '--trace'
+    double fileStart = spanStart();
+    double start;
 
 
 
-    if(fls->inputFileName[0] == 0)
+    if(fls->inputFileName == NULL)
     {
         message(ERR, "Please put input file name\n");
         return 1;
     }
 
 
-    /*
-        Changing 'filename.gm' to 'filename.h' (default).
-    */
+    if(fls->target != ANY)
+    {
+        message(ERR, "Don't use '-t' option\n"
+            "   ('target' will be read from .gm file).\n");
 
-    if(fls->otherName == false)
-        changeExtension(fls->outputFileName, fls->inputFileName, FILENAME_LENGTH, ".h");
+        return 1;
+    }
 
 
+    if(fromStdin && (fls->irFile == true || fls->jsonFile == true))
+    {
+        message(ERR, "Don't use '--ir' and '--json' options with standard input\n");
+        return 1;
+    }
+
+    if(toStdout && fls->depFile == true)
+    {
+        message(ERR, "Don't use '-MD' and '-MF' options with standard output\n");
+        return 1;
+    }
 
-    message(MSG, "Generating file %s  from  %s\n", fls->outputFileName, fls->inputFileName);
+    if(toStdout)
+        nameBase = fromStdin ? "stdout.h" : fls->inputFileName;
 
 
 
     /*
-        Input file - *.gm
+        Input file - *.gm (whole file is mapped into memory)
     */
-    FILE* inFp = fopen(fls-> inputFileName, "r");
+    GM_INPUT input;
 
+    start = spanStart();
 
-    if(inFp == NULL)
+    if(openInput(&input, fls->inputFileName) != 0)
     {
         perror(fls->inputFileName);
         return 1;
     }
 
-
+    statsSpan("read", fls->inputFileName, start);
+    statsCount(input.size, 0, 0);
 
 
 
     /*
-        Output file - temporary
+        Sections & targets (libmgen)
     */
 
-    if(fileExist(tempFile))
-        remove(tempFile);
+    start = spanStart();
 
+    doc = mgen_open(input.data, input.size, &options);
 
-    FILE* outFp = fopen(tempFile, "w");
+    statsSpan("sections", fls->inputFileName, start);
+
+    if(doc == NULL)
+    {
+        retval = 1;
+        goto close_fs;
+    }
+
+    targetsNum = mgen_targetsNum(doc);
 
 
 
     /*
-        Reading targetname
+        Changing 'filename.gm' to 'filename.h' (default).
+        For many targets - one file for each: 'filename_target.h'
     */
 
+    if(targetsNum == 1)
     {
-        char targetName[TARGET_NAME_LENGTH] = {0};
-        int i;
-
+        if(fls->otherName == false || toStdout)
+            outputNames[0] = changeExtension(nameBase, ".h");
+        else
+            outputNames[0] = duplicateString(fls->outputFileName);
+    }
 
-        if(fls->target != ANY)
+    else
+    {
+        for(int i=0; i<targetsNum; ++i)
         {
-            message(ERR, "Don't use '-t' option\n"
-                "   ('target' will be read from .gm file).\n");
+            char suffix[TARGET_NAME_LENGTH + 4];
 
-            retval = 1;
-            goto close_fs;
+            snprintf(suffix, sizeof(suffix), "_%s.h", mgen_targetName(doc, i));
+
+            outputNames[i] = changeExtension(nameBase, suffix);
         }
+    }
 
 
-        if( findSection(inFp, 't') < 0) // go to start of '$t' section in .gm file
+    for(int i=0; i<targetsNum; ++i)
+    {
+        if(outputNames[i] == NULL)
         {
+            message(ERR, "Out of memory\n");
             retval = 1;
             goto close_fs;
         }
+    }
 
-        fscanf(inFp, " %31s", targetName);
 
 
-        for(i=0; i<HOW_MANY_TARGETS; ++i)
-        {
-            if(strcmp(targetName, labels[i].name)==0)
-                fls->target = i;
-        }
+    /*
+        Hash of everything what affects output file.
+        If the same hash is already written in output file, it's up to date
+        - it isn't touched (make won't rebuild files which include it).
+    */
+
+    start = spanStart();
+
+    for(int i=0; i<targetsNum; ++i)
+    {
+        char oldHash[MGEN_HASH_LENGTH];
+
+        mgen_outputHash(doc, i, outputNames[i], hashes[i]);
+
+        // standard output - always written
+        upToDate[i] = toStdout == false
+                        && readOutputHash(outputNames[i], oldHash, sizeof(oldHash)) == 0
+                        && strcmp(oldHash, hashes[i]) == 0;
+
+        if(upToDate[i])
+            ++upToDateNum;
+    }
+
+    statsSpan("check", fls->inputFileName, start);
 
 
-        if(fls->target == ANY)
+
+    /*
+        Shared cache ('--cache dir') - headers generated before (i. e. by other build
+        with the same .gm file, flags & version) are copied without parsing & emitting.
+        (Not for standard output and '--check-parallel' - they need emitting)
+    */
+
+    if(cacheEnabled() && toStdout == false && fls->checkParallel == false && upToDateNum < targetsNum)
+    {
+        start = spanStart();
+
+        for(int i=0; i<targetsNum; ++i)
         {
-            message(ERR, "Unknown target '%s'\n", targetName);
+            char* prevFile;
 
-            retval = 1;
-            goto close_fs;
+            if(upToDate[i])
+                continue;
+
+            if( (prevFile = changeExtension(outputNames[i], "_prev.h.txt")) != NULL
+                && cacheFetch(hashes[i], outputNames[i], prevFile) == 0)
+            {
+                cached[i] = true;
+                ++cachedNum;
+            }
+
+            free(prevFile);
         }
+
+        statsSpan("cache", fls->inputFileName, start);
+        statsCache(cachedNum, targetsNum - upToDateNum - cachedNum);
     }
 
 
-    message(MSG, "\tTarget: %s\n", labels[fls->target].name);
 
+    /*
+        Compiled .gm file - if it's valid for this .gm file, pins are loaded from it
+        (without parsing). In other case it will be written again.
+    */
 
+    if(fls->irFile == true)
+    {
+        GM_INPUT ir;
 
+        irName = changeExtension(fls->inputFileName, ".gmc");
 
-    //initilalizing attrs structure
-    if(labels[fls->target].getData == NULL)
-    {
-        message(FATAL, "%s\n", ERR_MSG_INCOMPLETE_SOURCES);
+        start = spanStart();
 
-        retval = 1;
-        goto close_fs;
-    }
+        if(irName != NULL && openInput(&ir, irName) == 0)
+        {
+            macrosNum = mgen_importIR(doc, ir.data, ir.size);
 
+            statsCount(ir.size, 0, 0);
+            closeInput(&ir);
+        }
+
+        statsSpan("load ir", irName, start);
 
-    labels[fls->target].getData(&attrs);
+        irLoaded = (macrosNum >= 0);
+    }
 
 
-    if(attrs.macroGen == NULL)
+    if(upToDateNum + cachedNum == targetsNum  &&  (fls->irFile == false || irLoaded)  &&  fls->jsonFile == false)
     {
-        message(FATAL, "%s\n", ERR_MSG_INCOMPLETE_SOURCES);
+        for(int i=0; i<targetsNum; ++i)
+            message(MSG, cached[i] ? "%s copied from cache\n" : "%s is up to date\n", outputNames[i]);
+
+        macrosNum = -1;
 
-        retval = 1;
         goto close_fs;
     }
 
 
 
+    if(upToDateNum + cachedNum < targetsNum)
+    {
+        if(targetsNum == 1)
+        {
+            message(MSG, "Generating file %s  from  %s\n", outputNames[0], fls->inputFileName);
 
-    /*
-        Creating content of .h file.
-    */
+            message(MSG, "\tTarget: %s\n", mgen_targetName(doc, 0));
+        }
 
+        else
+        {
+            message(MSG, "Generating %d files from  %s\n", targetsNum, fls->inputFileName);
 
+            for(int i=0; i<targetsNum; ++i)
+                message(MSG, "\t%s  (target: %s)\n", outputNames[i], mgen_targetName(doc, i));
+        }
+    }
 
-    /*
-        #ifndef NAME_H
-        #define NAME_H
 
 
-        ... at the end
-        #endif // NAME_H
-    */
+    if(irLoaded)
+        message(MSG, "\tPins loaded from %s\n", irName);
 
-    createHeaderGuard(headerGuard, fls->outputFileName, FILENAME_LENGTH);
+    else
+    {
+        // all pins are read at once (for all targets)
+        start = spanStart();
 
-    fprintf(outFp, "#ifndef %s\n", headerGuard);
-    fprintf(outFp, "#define %s\n\n", headerGuard);
+        macrosNum = mgen_parse(doc);
 
+        statsSpan("parse", fls->inputFileName, start);
 
-    /*
-        "extern C" for C++
-        (for macros it doesn't matter, but for future implementation of functions ... )
-    */
+        // ERROR - message is already printed
+        if(macrosNum < 0)
+        {
+            retval = 1;
+            goto close_fs;
+        }
+    }
+
+    // big tables of pins are emitted by many threads
+    mgen_setThreads(doc, fls->jobs);
 
-    fprintf(outFp, "#ifdef __cplusplus\n"
-                    "  extern \"C\" {\n"
-                    "#endif\n\n" );
 
 
     /*
-        Preface
+        Standard output - all headers one after another, written in parts
+        (in one pass, without temporary files and backups).
     */
-    fprintf(outFp,
-         "/*\n"
-         "File auto-generated by m-gen v%s\n"
-         "    (see https://github.com/Leopardus4/m-gen )\n"
-         "\n"
-         "DO NOT EDIT THIS FILE!\n"
-         "Please edit apprioritate .gm file and run m-gen\n"
-         "\n"
-         "*/\n\n", VERSION);
 
+    if(toStdout)
+    {
+        for(int i=0; i<targetsNum && retval == 0; ++i)
+        {
+            size_t written = 0;
+
+            start = spanStart();
 
+            if(mgen_emitTo(doc, i, outputNames[i], &writeStdout, &written) != 0)
+                retval = 1;
+
+            statsSpan("emit", outputNames[i], start);
+            statsCount(0, written, 0);
+        }
+
+        if(fflush(stdout) != 0 || ferror(stdout))
+        {
+            perror("stdout");
+            retval = 1;
+        }
+    }
 
 
     /*
-        User's comment from .gm file
+        Output files are written directly to temporary files (in parts - memory doesn't depend
+        on size of output) and renamed at once only if there are no errors
+        (If previous output file already exist, it wouldn't be deleted).
     */
 
-    fprintf(outFp, "/*\n");
-
+    else
     {
-        char c;
+        GM_OUTPUT outs[HOW_MANY_TARGETS];
+        bool opened[HOW_MANY_TARGETS] = {false};
+
 
-        if(findSection(inFp, 'c') < 0)
+        for(int i=0; i<targetsNum && retval == 0; ++i)
         {
-            retval = 1;
-            goto close_fs;
+            if(upToDate[i] || cached[i])
+                continue;
+
+            if(outputOpen(&outs[i], outputNames[i]) != 0)
+            {
+                perror(outputNames[i]);
+                retval = 1;
+                break;
+            }
+
+            opened[i] = true;
+
+            start = spanStart();
+
+            if(fls->checkParallel == true
+                && checkParallel(doc, i, outputNames[i], fls->jobs) != 0)
+            {
+                retval = 1;
+            }
+
+            else if(mgen_emitTo(doc, i, outputNames[i], &outputWrite, &outs[i]) != 0)
+            {
+                if(outs[i].error)
+                    perror(outputNames[i]);
+
+                retval = 1;
+            }
+
+            statsSpan("emit", outputNames[i], start);
+            statsCount(0, outs[i].written, 0);
         }
 
-        do  //loop breaks at the end of section, but ignores every two "$$"
+
+        /*
+        From temporary files to output files ...
+        */
+
+        start = spanStart();
+
+        for(int i=0; i<targetsNum; ++i)
         {
-            while( (c = fgetc(inFp)) != '$')
-                {
-                    if(c == EOF)
-                        goto endComment;
-                    fputc(c, outFp);
-                }
+            char* prevFile;
 
-        } while((c = fgetc(inFp)) == '$');
+            if(opened[i] == false)
+            {
+                if(upToDate[i] && retval == 0)
+                    message(MSG, "\t%s is up to date\n", outputNames[i]);
 
-    }
+                if(cached[i] && retval == 0)
+                    message(MSG, "\t%s copied from cache\n", outputNames[i]);
 
-    endComment:
+                continue;
+            }
 
-    fprintf(outFp, "*/\n");
+            if(retval != 0)
+            {
+                outputAbort(&outs[i]);
+                continue;
+            }
 
+            prevFile = changeExtension(outputNames[i], "_prev.h.txt");
 
+            if(prevFile == NULL)
+            {
+                message(ERR, "Out of memory\n");
+                outputAbort(&outs[i]);
+                retval = 1;
+            }
 
-    fprintf(outFp, "\n\n\n\n//------------------------------------------------------------------------//\n\n");
+            else if(outputCommit(&outs[i], prevFile) != 0)
+            {
+                perror(outputNames[i]);
+                retval = 1;
+            }
+
+            // new header - for next builds
+            else if(cacheEnabled())
+                cacheStore(hashes[i], outputNames[i]);
+
+            free(prevFile);
+        }
+
+        statsSpan("write", fls->inputFileName, start);
+    }
 
 
 
     /*
-        Macros - proper function is called.
+        Compiled .gm file and JSON dump - written only if they are changed
+        and only after headers (if emitting fails, old compiled file isn't replaced
+        - next run parses .gm file again and prints its warnings)
     */
 
-    if(findSection(inFp, 'm') < 0)  //go to '$m' section
+    for(int i=0; i<2 && retval == 0; ++i)
     {
-        retval = 1;
-        goto close_fs;
-    }
+        GM_OUTPUT out;
+        char* name;
 
+        if(i == 0 && fls->irFile == true && irLoaded == false)
+            name = changeExtension(fls->inputFileName, ".gmc");
 
-    /* Checking for modes */
+        else if(i == 1 && fls->jsonFile == true)
+            name = changeExtension(fls->inputFileName, ".json");
 
-    // compatibility mode
-    if(fls->targetFlags.compatibilityMode == true)
-    {
-        if(attrs.presentModes.compatibilityMode == false)
-            message(NOTE, "%s module doesn't support compatibility mode\n", labels[fls->target].name);
-    }
+        else
+            continue;
 
-    // inline functions
-    if(fls->targetFlags.inlineFunc == true)
-    {
-        if(attrs.presentModes.inlineFunc == false)
-            message(NOTE, "%s module doesn't support inline functions\n"
-                          "\tIt will generate #defines\n", labels[fls->target].name);
-    }
 
+        if(name == NULL)
+        {
+            message(ERR, "Out of memory\n");
+            retval = 1;
+            break;
+        }
+
+        start = spanStart();
+
+        if(outputOpen(&out, name) != 0)
+        {
+            perror(name);
+            retval = 1;
+        }
+
+        else if( ((i == 0) ? mgen_exportIRTo(doc, &outputWrite, &out)
+                           : mgen_exportJsonTo(doc, &outputWrite, &out)) != 0)
+        {
+            if(out.error)
+                perror(name);
+
+            outputAbort(&out);
+            retval = 1;
+        }
+
+        else if(outputIsEqual(&out))
+            outputAbort(&out);
+
+        else if(outputCommit(&out, NULL) != 0)
+        {
+            perror(name);
+            retval = 1;
+        }
+
+        statsSpan("export", name, start);
+        statsCount(0, out.written, 0);
 
+        free(name);
+    }
 
 
-    // function from proper target module
-    macrosNum = attrs.macroGen(inFp, outFp, &(fls->targetFlags));
 
+    close_fs:
 
+    mgen_close(doc);
+    closeInput(&input);
 
 
-    //ERROR - should be printed by target module, here only line number is printed
-    if(macrosNum < 0)
+    if(retval == 0 && fls->depFile == true)
     {
-        message(MSG, "\t(line: %d )\n", getActualLine(inFp));
-        retval = 1;
-        goto close_fs;
+        start = spanStart();
+
+        retval = createDepFile(fls, outputNames, targetsNum);
+
+        statsSpan("depfile", fls->inputFileName, start);
     }
 
+    for(int i=0; i<targetsNum; ++i)
+        free(outputNames[i]);
 
+    free(irName);
 
+    statsSpan("file", fls->inputFileName, fileStart);
 
-    /*
-        "User guide" - macros usage
-    */
+    if(retval != 0)
+        return 1;
 
-    fprintf(outFp, "\n\n" "/*" "\n\n");
+    if(macrosNum < 0 || upToDateNum + cachedNum == targetsNum)
+        return 0;
 
-    fprintf(outFp, "Description:\n\n");
+    statsCount(0, 0, macrosNum);
 
-    printPinMacros(outFp);
 
-    fprintf(outFp, "*/");
-    fprintf(outFp, "\n\n\n\n//------------------------------------------------------------------------//\n\n");
+    message(MSG, "Done. Macros for %d pins written.\n", macrosNum);
 
 
 
-    /*
-        end of ' extern "C" '
-    */
+    return 0;
+}
 
-    fprintf(outFp,  "\n"
-                    "#ifdef __cplusplus\n"
-                    "  }\n"
-                    "#endif\n\n" );
 
 
+/*---------------------------------------------------*/
 
-    /*
-        #endif of Header guard
-    */
-    fprintf(outFp, "#endif    // %s\n", headerGuard);
+/*
+Writes file name to dependency file - spaces and special characters are escaped
+    (the same way as in gcc's .d files)
+*/
+static void bufPutDepName(GM_BUF* out, const char* name)
+{
+    for(; *name; ++name)
+    {
+        if(*name == ' ' || *name == '#' || *name == '\\')
+            bufPutc(out, '\\');
 
+        else if(*name == '$')
+            bufPutc(out, '$');
 
+        bufPutc(out, *name);
+    }
+}
 
-    close_fs:
 
-    fclose(outFp);
-    fclose(inFp);
 
+/*
+Creates dependency file (make / ninja format) like gcc '-MD':
+    output files : input file, m-gen executable, stamp, templates
+File is written only if its content has changed.
+*/
+int createDepFile(const FLAGS* fls, char* const outputNames[], int outputsNum)
+{
+    char* depFileName;
+    char* programPath;
 
-    /*
-    From tmp file to output file ...
-    */
+    GM_BUF out;
 
-    if(retval != 0)
+    int retval = 0;
+
+
+    if(fls->depFileName != NULL)
+        depFileName = duplicateString(fls->depFileName);
+
+    // 'file.h' -> 'file.d' , for many targets: 'file.gm' or 'other_name.h' -> 'file.d'
+    else if(outputsNum == 1)
+        depFileName = changeExtension(outputNames[0], ".d");
+
+    else if(fls->otherName == true)
+        depFileName = changeExtension(fls->outputFileName, ".d");
+
+    else
+        depFileName = changeExtension(fls->inputFileName, ".d");
+
+
+    if(depFileName == NULL)
     {
-        remove(tempFile);
+        message(ERR, "Out of memory\n");
         return 1;
     }
 
-    else
+
+    bufInit(&out);
+
+    for(int i=0; i<outputsNum; ++i)
     {
-        if(fileExist(fls->outputFileName))
-        {
-            char prevFile[FILENAME_LENGTH];
+        if(i > 0)
+            bufPutc(&out, ' ');
 
-            changeExtension(prevFile, fls->outputFileName, FILENAME_LENGTH, "_prev.h.txt");
+        bufPutDepName(&out, outputNames[i]);
+    }
 
-            if(fileExist(prevFile))
-                remove(prevFile);
+    bufPuts(&out, ": ");
 
-            rename(fls->outputFileName, prevFile);
-        }
+    bufPutDepName(&out, fls->inputFileName);
 
-    rename(tempFile, fls->outputFileName);
+    if( (programPath = getProgramPath(fls->programName)) != NULL)
+    {
+        bufPutc(&out, ' ');
+        bufPutDepName(&out, programPath);
 
+        free(programPath);
     }
 
+    if(fls->stampFileName != NULL)
+    {
+        bufPutc(&out, ' ');
+        bufPutDepName(&out, fls->stampFileName);
+    }
 
-    // ha ha ha
-    for(int i=0; i<3; ++i)
+    for(int i=0; i<fls->templateFilesNum; ++i)
     {
-        message(MSG, ".");
-        sleep(1);
+        bufPutc(&out, ' ');
+        bufPutDepName(&out, fls->templateFiles[i]);
     }
 
+    bufPutc(&out, '\n');
 
-    message(MSG, " Done. Macros for %d pins written.\n", macrosNum);
 
+    if(fileIsEqual(&out, depFileName) == 0  &&  writeOutput(&out, depFileName, NULL) != 0)
+    {
+        perror(depFileName);
+        retval = 1;
+    }
 
+    bufFree(&out);
+    free(depFileName);
 
-    return 0;
+    return retval;
 }
 
 
 
+
 /*---------------------------------------------------*/
 
+/*
+Creates stamp file - m-gen version and flags which affect output files.
+File is written only if its content has changed, so it can be used as dependency:
+    make runs m-gen only if .gm file, m-gen version or flags are changed.
+*/
+int createStamp(const FLAGS* fls)
+{
+    GM_BUF out;
+
+    int retval = 0;
+
+
+    bufInit(&out);
+
+    bufPrintf(&out, "m-gen v%s%s%s%s%s%s\n", VERSION,
+        fls->targetFlags.compatibilityMode ? " -c" : "",
+        fls->targetFlags.inlineFunc ? " -I" : "",
+        fls->targetFlags.atomicMode ? " -a" : "",
+        fls->targetFlags.rmwMode ? " --rmw" : "",
+        fls->targetFlags.bitbandMode ? " --bitband" : "" );
+
+    // content of templates - in dependency file
+    for(int i=0; i<fls->templateFilesNum; ++i)
+        bufPrintf(&out, "--template %s\n", fls->templateFiles[i]);
+
+
+    if(fileIsEqual(&out, fls->stampFileName) == 0)
+    {
+        message(MSG, "Writing stamp %s\n", fls->stampFileName);
+
+        if(writeOutput(&out, fls->stampFileName, NULL) != 0)
+        {
+            perror(fls->stampFileName);
+            retval = 1;
+        }
+    }
+
+    bufFree(&out);
+
+    return retval;
+}
+
+
+
+
 /*---------------------------------------------------*/
 
 /*
-Print message to output
-    level - predefined macro from m-gen.h (i. e. MSG or ERR )
-    format, ... - printf() syntax
+Called by watchDirectory() for every changed .gm file
+    and by runBatch() for every input file (many threads at once)
+    - the same as 'm-gen path [flags]'
+ctx - FLAGS from command line
+*/
+int generateFile(const char* path, void* ctx)
+{
+    FLAGS fls = *(const FLAGS*) ctx;
+
+
+    fls.inputFileName = path;
 
-Inspired by DebugPrintf() from lpc21isp project
-    https://github.com/capiman/lpc21isp
+    // default names for every file
+    fls.depFileName = NULL;
 
+    // files are already converted by many threads (batch mode)
+    fls.jobs = 1;
+
+    return generateMacros(&fls);
+}
+
+
+
+/*---------------------------------------------------*/
+/*
+Standard input / output - file name "-"
 */
-void message(int level, const char* format, ...)
+
+bool isStdio(const char* name)
 {
-    va_list args;
+    return name != NULL && strcmp(name, "-") == 0;
+}
 
 
-    const char* prefix[5];
+// header(s) written to stdout: 'm-gen file.gm -o -' or 'm-gen -' (without '-o')
+bool writesToStdout(const FLAGS* fls)
+{
+    if(fls->otherName == true)
+        return isStdio(fls->outputFileName);
 
-    prefix[MSG]     = P_MSG;
-    prefix[NOTE]    = P_NOTE;
-    prefix[WARN]    = P_WARN;
-    prefix[ERR]     = P_ERR;
-    prefix[FATAL]   = P_FATAL;
+    return isStdio(fls->inputFileName);
+}
 
-    FILE* output = (level == MSG) ? stdout : stderr;
 
+// output function for mgen_emitTo() - ctx: size_t, number of written bytes
+int writeStdout(const char* data, size_t size, void* ctx)
+{
+    *(size_t*) ctx += size;
 
+    return (fwrite(data, 1, size, stdout) == size) ? 0 : -1;
+}
 
-    if(level >= silentLevel)
-    {
-        va_start(args, format);
 
 
-        fprintf(output, "%s", prefix[level]);
+/*---------------------------------------------------*/
+/*
+Start of span for statsSpan() - clock is read only if '--stats' or '--trace' is given
+*/
+double spanStart(void)
+{
+    return statsEnabled() ? statsNow() : 0;
+}
 
-        vfprintf(output, format, args);
 
-        fflush(output);
 
+/*---------------------------------------------------*/
+/*
+Hash of output - for checkParallel()
+*/
 
-        va_end(args);
+static int hashOutput(const char* data, size_t size, void* ctx)
+{
+    unsigned long long* hash = ctx;
+
+    *hash = hashData(*hash, data, size);
+
+    return 0;
+}
+
+
+/*
+'--check-parallel': output of given target is emitted by one thread and by 'threads' threads
+    - both must be the same.
+Returns 0 or -1 (message is printed).
+*/
+
+int checkParallel(MGEN_DOCUMENT* doc, int target, const char* outputName, int threads)
+{
+    unsigned long long serial = GM_HASH_INIT;
+    unsigned long long parallel = GM_HASH_INIT;
+
+
+    mgen_setThreads(doc, 1);
+
+    if(mgen_emitTo(doc, target, outputName, &hashOutput, &serial) != 0)
+        return -1;
+
+    mgen_setThreads(doc, threads);
+
+    if(mgen_emitTo(doc, target, outputName, &hashOutput, &parallel) != 0)
+        return -1;
+
+    if(serial != parallel)
+    {
+        message(ERR, "Parallel output differs from serial one: %s\n", outputName);
+        return -1;
     }
 
+    message(MSG, "\tParallel output checked: %s\n", outputName);
 
+    return 0;
 }
 
+
+
 /*---------------------------------------------------*/
 
 /*---------------------------------------------------*/
@@ -916,7 +1532,7 @@ void printMainPage(void)
 
 /*---------------------------------------------------*/
 
-void help(TARGET_LABEL labels[])
+void help(const TARGET_LABEL labels[])
 {
     printf ("Usage:                                                                                             \n"
             "    m-gen --init file.gm -t target                                                                 \n"
@@ -926,6 +1542,10 @@ void help(TARGET_LABEL labels[])
             "                                                                                                   \n"
             "Then use:                                                                                          \n"
             "    m-gen file.gm [-s] [-c] [-I] [ -o other_name.h ]                                               \n"
+            "or:                                                                                                \n"
+            "    m-gen file1.gm file2.gm dir ... [-s] [-c] [-I] [ -j jobs ]                                     \n"
+            "or:                                                                                                \n"
+            "    m-gen --watch dir [-s] [-c] [-I] [ --socket name ]                                             \n"
             "to convert it to macros in new .h file.                                                            \n"
             "                                                                                                   \n"
             " [...] - optional                                                                                  \n"
@@ -944,6 +1564,12 @@ void help(TARGET_LABEL labels[])
             "                                                                                                   \n"
             "   <-o othername>        Output file will get name \"othername\".                                  \n"
             "                           When unused, output file will be named \"input_filename.h\".            \n"
+            "                           If .gm file has many targets in '$t' section (i.e. \"avr lpc17xx\"),     \n"
+            "                           one file is created for each: \"othername_avr.h\", ...                  \n"
+            "                           \"-o -\" - header is written to standard output (with many targets:      \n"
+            "                           all headers one after another), without temporary files and backups.    \n"
+            "                           Input file \"-\" - .gm file is read from standard input (pipe), header   \n"
+            "                           goes to standard output: m-gen - < pins.gm > pins.h                     \n"
             "                                                                                                   \n"
             "   -s                    Silent mode. Basic informations will not be printed, only errors.         \n"
             "                           Useful for automatic usage - in makefiles, etc.                         \n"
@@ -954,6 +1580,52 @@ void help(TARGET_LABEL labels[])
             "                                                                                                   \n"
             "   -I  (--inline)        'inline' mode. Creating 'static inline' functions instead of #defines     \n"
             "                                                                                                   \n"
+            "   -a  (--atomic)        'atomic' mode. Macros don't read-modify-write registers shared with       \n"
+            "                           other pins, if target has other way (i. e. lpc17xx: toggle() uses       \n"
+            "                           FIOSET / FIOCLR instead of FIOPIN ^= ...). Safe with interrupts.        \n"
+            "                                                                                                   \n"
+            "   --rmw                 Old read-modify-write macros instead of faster ones (i. e. lpc111x:       \n"
+            "                           DATA |= ... instead of one store to MASKED_ACCESS[]).                   \n"
+            "                                                                                                   \n"
+            "   --bitband             Direction, pull-up and reading of one pin by bit-band alias addresses     \n"
+            "                           (i. e. lpc17xx: one store / load instead of FIODIR |= ...).             \n"
+            "                                                                                                   \n"
+            "   -MD                   Write dependency file for make / ninja (\"output_filename.d\")            \n"
+            "   <-MF depfile>         The same, but dependency file will be named \"depfile\"                   \n"
+            "                                                                                                   \n"
+            "   <--stamp stampfile>   Write m-gen version & flags to \"stampfile\" (only if they are changed).  \n"
+            "                           Can be used without input file. See examples/blink/Makefile             \n"
+            "                                                                                                   \n"
+            "   --ir                  Write compiled .gm file (\"input_filename.gmc\") - next time pins are     \n"
+            "                           loaded from it (if .gm file is not changed), without parsing.           \n"
+            "   --json                Write all pins as JSON (\"input_filename.json\") - for other tools.      \n"
+            "                                                                                                   \n"
+            "   <--watch dir>         Persistent mode (Linux): converts all .gm files in \"dir\", then waits      \n"
+            "                           and converts every saved .gm file immediately.                          \n"
+            "   <--socket name>       (with --watch) Local UNIX socket for requests: one line with path         \n"
+            "                           of .gm file - m-gen converts it and answers \"OK\" or \"ERROR\".          \n"
+            "                                                                                                   \n"
+            "   <-j jobs>             Many input files (directories are searched for .gm files) are converted   \n"
+            "                           in \"jobs\" threads (default: number of CPUs). Run from make, m-gen      \n"
+            "                           takes job slots from make jobserver (use '+' before recipe).            \n"
+            "                           For one file: big table of pins is emitted by \"jobs\" threads.         \n"
+            "   --check-parallel      Emit every output also by one thread and stop if it's different          \n"
+            "                           (output of many threads must be always the same).                       \n"
+            "                                                                                                   \n"
+            "   --stats               Print time of every phase (parsing, emitting, writing, ...), bytes read   \n"
+            "                           and written and pins per second (to stderr).                            \n"
+            "   <--trace=file.json>   Write the same phases to \"file.json\" (Chrome trace format - see         \n"
+            "                           chrome://tracing or ui.perfetto.dev).                                    \n"
+            "                                                                                                   \n"
+            "   <--template file.gmt> Use \"file.gmt\" instead of built-in template of target (i. e. changed copy \n"
+            "                           of targets/avr.gmt - see CONTRIBUTING.md). Can be given many times.     \n"
+            "                                                                                                   \n"
+            "   <--cache dir>         Shared cache of headers (POSIX): header generated before from the same   \n"
+            "                           .gm file, flags, target & output name is copied from \"dir\"             \n"
+            "                           without parsing (i. e. one cache for CI builds and developers).         \n"
+            "   <--cache-size size>   Max. size of cache (i. e. 500M, 2G; default: 1G) - least recently used    \n"
+            "                           headers are removed. Size in bytes or with suffix k, M, G (any case).   \n"
+            "   --cache-link          Headers are hard links to files in cache (don't edit them in place).     \n"
             "                                                                                                   \n"
             "                                                                                                   \n"
             "                                                                                                   \n"
@@ -27,7 +27,16 @@ with m-gen. If not, see
 
 */
 
-#define VERSION "1.2"
+#define VERSION "1.3"
+
+
+/*
+Hash of input file, version and flags - written in every output file as:
+    GM_HASH_TAG "0123456789abcdef"
+If it's the same, output file is up to date.
+*/
+#define GM_HASH_TAG     "m-gen hash: "
+#define GM_HASH_LENGTH  (16 + 1)    /* 64-bit hex + '\0' */
 
 
 /* boolean : true / false */
@@ -58,9 +67,6 @@ typedef enum{
 } TARGETS;
 
 
-#define FILENAME_LENGTH (256)
-
-
 /* Flags for target module */
 
 /*
@@ -76,7 +82,7 @@ To add new mode:
 
 Target modules get following structure in two ways:
         * first in xx_getData() - module can inform that it supports this mode
-        * and in xx_macroGen() - it should do sth if flag is set
+        * and in xx_validate() / xx_emit() - it should do sth if flag is set
 */
 typedef struct{
 
@@ -86,6 +92,16 @@ typedef struct{
     // creating 'static inline' functions instead of #defines
     bool inlineFunc;
 
+    // macros don't read-modify-write registers shared with other pins, if target can avoid it
+    //  (i. e. toggle by FIOSET / FIOCLR instead of FIOPIN ^= ...)
+    bool atomicMode;
+
+    // read-modify-write of whole port instead of faster macros (i. e. lpc111x: DATA |= ... like m-gen 1.2)
+    bool rmwMode;
+
+    // single-bit accesses by bit-band alias addresses (Cortex M3 - i. e. lpc17xx)
+    bool bitbandMode;
+
 } TARGET_FLAGS;
 
 /*
@@ -102,80 +118,327 @@ typedef struct{
 
     TARGETS target;
 
-    char inputFileName[FILENAME_LENGTH];
-    char outputFileName[FILENAME_LENGTH];
+    // file names (from command line) - NULL if not given
+    const char* inputFileName;
+    const char* outputFileName;
+
+    // dependency file for make / ninja: '-MD' (default name) or '-MF name'
+    bool depFile;
+    const char* depFileName;
+
+    // version & flags stamp: '--stamp name' (NULL if not used)
+    const char* stampFileName;
+
+    // compiled .gm file ('--ir' - "input.gmc") and JSON dump ('--json' - "input.json")
+    bool irFile;
+    bool jsonFile;
+
+    // persistent mode: '--watch dir' and optional '--socket name' (NULL if not used)
+    const char* watchDir;
+    const char* socketName;
+
+    // argv[0] - for path of m-gen executable in dependency file
+    const char* programName;
+
+    // all input files / directories (first one is also in inputFileName)
+    const char** inputFiles;
+    int inputFilesNum;
+
+    // threads in batch mode, or threads emitting big table of one file: '-j N' (0 - number of processors)
+    int jobs;
+
+    // '--check-parallel' - output emitted by many threads is compared with output from one thread
+    bool checkParallel;
+
+    // '--stats' - time of phases, bytes & pins printed at the end; '--trace=file.json' (NULL if not used)
+    bool stats;
+    const char* traceFileName;
+
+    // user's templates of targets: '--template file.gmt' (can be given many times)
+    const char** templateFiles;
+    int templateFilesNum;
+
+    // shared cache of headers: '--cache dir' (NULL if not used), '--cache-size N[k|M|G]' (0 - default), '--cache-link'
+    const char* cacheDir;
+    unsigned long long cacheSize;
+    bool cacheLink;
 } FLAGS;
 
 
 
+/*
+Function which converts one .gm file - used by '--watch' mode and batch mode
+    (see gm-watch.h and gm-batch.h)
+path - path of .gm file (directory + name)
+ctx - pointer given to watchDirectory() / runBatch()
+Returns 0 if success
+    or non-zero value in case of error (message should be printed).
+*/
+typedef int (*GM_GENERATE_FN)(const char* path, void* ctx);
+
+
 
-#define DESCRIPTION_LENGTH 256
 
 /*
-This structure contains attributes and pointers to functions for one specific target
+String view - fragment of input file (.gm) in memory.
+    Not terminated by '\0' - use "%.*s" with GM_STR_ARG(s) in printf()
 */
 typedef struct{
 
-        //some informations about target
-    char description[DESCRIPTION_LENGTH];
+    const char* str;
+    int len;
 
-        // supported modes
-        // if module supports any mode, it should set flag to 'true' in target_getdata() function
-    TARGET_FLAGS presentModes;
+} GM_STR;
 
-        // functions pointers
-    void    (*init)     (FILE* fp, const TARGET_FLAGS* fls);
-    int     (*macroGen) (FILE* inFp, FILE* outFp, const TARGET_FLAGS* fls);
-    void    (*help)     (void);
+#define GM_STR_ARG(s)   (s).len, (s).str
 
-} TARGET_ATTRIBUTES;
 
 
+/*
+Lexer - reads input file (.gm) from memory and keeps position (line & column)
+    of read characters, so there is no need to re-read file
+    to find line number for diagnostics.
+
+See lexXxx() functions in gm-common.h
+*/
+typedef struct{
+
+        // next character & end of data
+    const char* pos;
+    const char* end;
+
+        // position of next character
+    int line;
+    int column;
+
+        // position of beginning of last read token (word / row)
+    int tokenLine;
+    int tokenColumn;
+
+} GM_LEXER;
+
 
-#define TARGET_NAME_LENGTH   32
 
 /*
-    structure - label to target
+One row from '$m' section (one pin):
+    Mode PORT PIN Name Comment
+
+or if there are many targets in '$t' section - PORT and PIN for each target:
+    Mode PORT1 PIN1 PORT2 PIN2 ... Name Comment
+
+All members point directly into input file.
+comment - rest of line after name (with whitespaces and '\n')
+*/
+typedef struct{
+
+    GM_STR mode;
+    GM_STR port[HOW_MANY_TARGETS];
+    GM_STR pin[HOW_MANY_TARGETS];
+    GM_STR name;
+    GM_STR comment;
+
+    int line;   // line number in input file
+
+} GM_ROW;
+
+
+
+
+/*
+Arena - memory for many small objects (pins, names, ...),
+    allocated in big chunks and freed at once.
+
+See arenaXxx() functions in gm-table.h
 */
+typedef struct GM_ARENA_CHUNK{
+
+    struct GM_ARENA_CHUNK* next;
+
+    size_t size;
+    size_t used;
+
+    char data[];
+
+} GM_ARENA_CHUNK;
+
 
 typedef struct{
 
-char name[TARGET_NAME_LENGTH];  //short, only lowercase, digits and '-' (instead of '_' and whitespaces)
+    GM_ARENA_CHUNK* head;
 
-void (*getData)(TARGET_ATTRIBUTES* atrs);    //pointer to target's initializer
+} GM_ARENA;
 
-} TARGET_LABEL;
 
 
+/*
+One pin from '$m' section after parsing - target independent.
+
+port & pin are set by target module (validate() function)
+    - i. e. for AVR: port = 'B', pin = 3
+    - for LPC: port = 2, pin = 4
+*/
+typedef struct{
+
+    char mode;          // 'i', 'o', 'd', 'l', 'h' or 'b' - see printPinModes()
+
+    short port;
+    short pin;
+
+    int line;           // line number in input file
+
+    GM_STR name;        // interned - the same names share one string (terminated by '\0')
+    GM_STR comment;     // points directly into input file (with whitespaces and '\n')
+
+} GM_PIN;
+
+
+
+/* max. number of pins in one group - bits of value of group's macros */
+#define GM_GROUP_PINS   (32)
 
 /*
-Required size of arrays for symbolic pin name and comment from .gm file
+One group of pins from '$g' section (one line):
+    Name PIN_NAME PIN_NAME ...
+Bit 0 of value of group's macros is the first pin, bit 1 - the second one, ...
 */
-#define GM_PINNAME_LENGTH   (128)
+typedef struct{
+
+    GM_STR name;                // points directly into input file
+    int line;                   // line number in input file
+
+    int pins[GM_GROUP_PINS];    // indexes of pins in table
+    int count;
+
+} GM_GROUP;
+
+
+
+/*
+Array of all pins from '$m' section (in order from input file)
+
+If there are many targets in one .gm file, each target has its own array
+    (with the same names and comments) - see tableSelectTarget()
+*/
+typedef struct{
+
+    GM_PIN* pins;   // pins for selected target
+    int count;
+    int capacity;   // allocated pins (for each target) - see tableReserve()
+
+    GM_PIN* targetPins[HOW_MANY_TARGETS];
+    int targetsNum;
+
+    GM_ARENA arena;     // memory for names
 
-#define GM_COMMENT_LENGTH   (512)
+    // hash table for interning names: index of pin or -1
+    int* nameSlots;
+    unsigned int nameSlotsNum;  // power of 2
+    unsigned int namesNum;      // used slots
 
+    // hash index of ports & pins of selected target (see tableFindPin() in gm-table.h)
+    int* pinSlots;              // index of first pin with given port & pin or -1
+    int* pinNext;               // for each pin: next pin with the same port & pin or -1
+    unsigned int pinSlotsNum;   // power of 2
 
+    // part of table emitted by other thread (see gm-emit.h) - without index
+    bool isPart;
+
+    // groups of pins from '$g' section (the same for all targets) - see parseGroups()
+    GM_GROUP* groups;
+    int groupsNum;
+    int groupsCapacity;
+
+} GM_TABLE;
 
 
 
 
 /*
-for slow program ha ha
+Output buffer - whole generated file (.h) is created in memory
+    and written to disk at once,
+    or (with flush function) it's written in parts of constant size.
+
+See bufXxx() functions in gm-output.h
 */
-#ifdef __WIN32
-  #include <windows.h>
+typedef struct{
 
-  #define sleep(seconds) Sleep(1000 * (seconds))
+    char* data;
+    size_t size;        // used bytes
+    size_t capacity;    // allocated bytes
+
+    int error;          // 1 if memory allocation failed, 2 if flush() failed
+
+    // optional (see bufSetFlush()) - full buffer is given to this function and cleared,
+    // so memory doesn't grow with size of output file
+    int (*flush)(const char* data, size_t size, void* ctx);
+    void* flushCtx;
+
+} GM_BUF;
+
+
+
+
+#define DESCRIPTION_LENGTH 256
+
+/*
+This structure contains attributes and pointers to functions for one specific target
+*/
+typedef struct{
+
+        //some informations about target
+    char description[DESCRIPTION_LENGTH];
+
+        // supported modes
+        // if module supports any mode, it should set flag to 'true' in target_getdata() function
+    TARGET_FLAGS presentModes;
+
+        // hash of target's template (built-in or '--template') - part of hash of output file,
+        // so changed macros are never taken as up to date (0 - module written in C)
+    unsigned long long templateHash;
+
+        // functions pointers
+    void    (*init)     (GM_BUF* out, const TARGET_FLAGS* fls);   // '$m' & '$o' sections of new .gm file
+    void    (*help)     (void);
+
+        // checks one row from '$m' section and sets pin->port & pin->pin
+        // returns 0 or -1 in case of error (function should print info about error)
+    int     (*validate) (GM_PIN* pin, GM_STR port, GM_STR pinNr, const TARGET_FLAGS* fls);
+
+        // optional (can be NULL) - writes macros used by all pins (before macros of pins)
+        // If it's set, emit() writes only macros of pins and they must depend only on given pin:
+        //   big tables are divided into parts, emitted at once by many threads (see gm-emit.h)
+        // returns 0 or -1 in case of error
+    int     (*begin)    (GM_BUF* out, const TARGET_FLAGS* fls);
+
+        // writes macros for all pins from table
+        // returns 0 or -1 in case of error
+    int     (*emit)     (GM_BUF* out, const GM_TABLE* table, const TARGET_FLAGS* fls);
+
+        // optional (can be NULL) - writes macros of one group of pins ('$g' section)
+        // (after macros of all pins - whole table is given)
+        // returns 0 or -1 in case of error
+    int     (*group)    (GM_BUF* out, const GM_TABLE* table, const GM_GROUP* group, const TARGET_FLAGS* fls);
+
+} TARGET_ATTRIBUTES;
+
+
+
+#define TARGET_NAME_LENGTH   32
+
+/*
+    structure - label to target
+*/
+
+typedef struct{
+
+char name[TARGET_NAME_LENGTH];  //short, only lowercase, digits and '-' (instead of '_' and whitespaces)
+
+void (*getData)(TARGET_ATTRIBUTES* atrs);    //pointer to target's initializer
+
+} TARGET_LABEL;
 
-#elif defined __unix__
-  #include <unistd.h>
 
-#else
-  #define sleep(seconds)
-        //do nothing
 
-#endif // __WIN32 / __unix__
 
 
 
@@ -188,6 +451,13 @@ Print message to output
 */
 void message(int level, const char* format, ...);
 
+/*
+Warnings (WARN) of actual thread are also added to 'record' (text without prefix,
+    each one terminated by '\0') - also if they aren't printed. NULL - end of recording.
+Used while pins are parsed - warnings are kept in compiled .gm file and printed again when it's loaded.
+*/
+void messageRecord(GM_BUF* record);
+
 /*
 Macros for message() - to categorize message value
 
@@ -32,14 +32,9 @@ with m-gen. If not, see
 
 /* functions declarations */
 
+// module described by template (see GM_TEMPLATE_TARGET() in gm-template.h)
 void avr_getData(TARGET_ATTRIBUTES* atrs);
 
-void avr_init(FILE* fp, const TARGET_FLAGS* fls);
-
-int  avr_generateMacros(FILE* inFp, FILE* outFp, const TARGET_FLAGS* fls);
-
-void avr_help(void);
-
 
 /*---------------------------------------------------*/
 
@@ -0,0 +1,254 @@
+"# m-gen target template - Atmel AVR (ATtiny & ATmega)\n"
+"#\n"
+"# Format of template files - see CONTRIBUTING.md\n"
+"# (compiled into m-gen - targets/avr_gmt.h is created by 'make' from this file)\n"
+"\n"
+"\n"
+"target avr\n"
+"description Atmel ATtiny and ATmega 8 bit RISC microcontrollers\n"
+"supports compat\n"
+"\n"
+"\n"
+"# PORT: 'PORTB', 'B', 'portb' or 'b' (letter 'B' in macros)\n"
+"port letter prefix PORT\n"
+"\n"
+"# PIN: 'PB4', '4' or 'pb4'\n"
+"pin number 0 9 prefix P\?\n"
+"\n"
+"\n"
+"# groups of pins ('$g' section) - 8 bit ports\n"
+"portbits 8\n"
+"\n"
+"# type of mask / value - group with more than 16 pins doesn't fit in 16 bits\n"
+"text groupType = \"uint16_t\"\n"
+"text groupType if wide = \"uint32_t\"\n"
+"\n"
+"# copy of port for ${name}_read() - every PINx is read only once\n"
+"text groupIn = \"gm_${port}\"\n"
+"\n"
+"\n"
+"\n"
+"# new .gm file ('m-gen --init')\n"
+"init\n"
+"$m\n"
+"Mode PORT PIN Name Comment\n"
+"\n"
+"l	B	4	led_status	Write here your own macros...\n"
+"\n"
+"$o\n"
+"Format:                                                            $\n"
+"   PORT:                                                           $\n"
+"   AVR port name in format: (i. e.) 'PORTB', 'B', 'portb', or 'b'  $\n"
+"                                                                   $\n"
+"   PIN:                                                            $\n"
+"   AVR pin number (in PORT) in format: (i. e.) 'PB4', '4' or 'pb4' $\n"
+"end\n"
+"\n"
+"\n"
+"help\n"
+"AVR help $\n"
+"\n"
+"Atmel AVR MCUs have some gpio pins.\n"
+"They are grouped into ports (PORTA, PORTB, ...)\n"
+"Each port contains up to 8 pins (PA0-PA7, PB0-PB7, ...)\n"
+"Note that not every MCU has all pins in port and all ports\n"
+"  i. e. ATmega256 has up to 38 gpios, but ATtiny4 in SOT-23 package has only 4 gpios $\n"
+"end\n"
+"\n"
+"\n"
+"\n"
+"# macros used by all pins\n"
+"begin\n"
+"\n"
+"/* Toggle of pin - writing 1 to PINx toggles PORTx bit (one instruction) on most AVRs.\n"
+"   Older cores (ATmega8/16/32/64/128, ATmega8515/8535, ...) don't have it - there PORTx ^= ... is used.\n"
+"   ( #define gm_PIN_TOGGLE 0 or 1 before #include to choose )\n"
+" */\n"
+"#ifndef gm_PIN_TOGGLE\n"
+"  #if defined(__AVR_ATmega8__) || defined(__AVR_ATmega8A__) || defined(__AVR_ATmega16__) || defined(__AVR_ATmega16A__) \\\n"
+"   || defined(__AVR_ATmega32__) || defined(__AVR_ATmega32A__) || defined(__AVR_ATmega64__) || defined(__AVR_ATmega64A__) \\\n"
+"   || defined(__AVR_ATmega128__) || defined(__AVR_ATmega128A__) || defined(__AVR_ATmega103__) \\\n"
+"   || defined(__AVR_ATmega161__) || defined(__AVR_ATmega162__) || defined(__AVR_ATmega163__) || defined(__AVR_ATmega323__) \\\n"
+"   || defined(__AVR_ATmega8515__) || defined(__AVR_ATmega8535__) || defined(__AVR_ATtiny26__) || defined(__AVR_ATtiny28__) \\\n"
+"   || defined(__AVR_AT90S2313__) || defined(__AVR_AT90S4433__) || defined(__AVR_AT90S8515__) || defined(__AVR_AT90S8535__)\n"
+"    #define gm_PIN_TOGGLE   0\n"
+"  #else\n"
+"    #define gm_PIN_TOGGLE   1\n"
+"  #endif\n"
+"#endif\n"
+"\n"
+"#ifndef gm_TOGGLE\n"
+"  #if gm_PIN_TOGGLE\n"
+"    #define gm_TOGGLE(port, bit)    do{PIN##port = (1<<(bit));} while(0)\n"
+"  #else\n"
+"    #define gm_TOGGLE(port, bit)    do{PORT##port ^= (1<<(bit));} while(0)\n"
+"  #endif\n"
+"#endif\n"
+"\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"\?if compat\n"
+"\n"
+"\n"
+"/* gpio_enableAccess() - empty macro\n"
+"   Used only for compatibility with other MCUs\n"
+"   ( configured by 'm-gen -c' flag )\n"
+" */\n"
+"\n"
+"#define gpio_enableAccess()    do{} while(0)\n"
+"\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"\?endif\n"
+"end\n"
+"\n"
+"\n"
+"# after macros of every pin\n"
+"after\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"# group of pins - one read-modify-write of every port (one write if group has all pins of port)\n"
+"group\n"
+"/* ${name} - group of pins: ${pins}\n"
+"	 (bit 0 of mask / value - the first pin) */\n"
+"\n"
+"#define ${name}_set(mask)    do{ \\\n"
+"    ${groupType} gm_mask = (mask); \\\n"
+"\?port\n"
+"    PORT${port} |= ${toPort:gm_mask}; \\\n"
+"\?endport\n"
+"    } while(0)\n"
+"\n"
+"#define ${name}_clear(mask)  do{ \\\n"
+"    ${groupType} gm_mask = (mask); \\\n"
+"\?port\n"
+"    PORT${port} &= ~${toPort:gm_mask}; \\\n"
+"\?endport\n"
+"    } while(0)\n"
+"\n"
+"#define ${name}_write(value) do{ \\\n"
+"    ${groupType} gm_value = (value); \\\n"
+"\?port\n"
+"\?if full\n"
+"    PORT${port} = ${toPort:gm_value}; \\\n"
+"\?else\n"
+"    PORT${port} = (PORT${port} & ~${mask}) | ${toPort:gm_value}; \\\n"
+"\?endif\n"
+"\?endport\n"
+"    } while(0)\n"
+"\n"
+"#define ${name}_read()       ({ \\\n"
+"\?port\n"
+"    ${groupType} gm_${port} = PIN${port}; \\\n"
+"\?endport\n"
+"    (${groupType}) (${fromPort:groupIn}); })\n"
+"\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"\n"
+"mode i\n"
+"/* ${name} - P${port}${pin} - digital input $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_dirIn()      do{DDR${port} &= ~(1<<P${port}${pin}); PORT${port} &= ~(1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_isHigh()     ( (PIN${port} & (1<<P${port}${pin})) != 0 )\n"
+"\n"
+"#define ${name}_isLow()      ( (PIN${port} & (1<<P${port}${pin})) == 0 )\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode o\n"
+"/* ${name} - P${port}${pin} - digital output $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_dirOut()     do{DDR${port} |= (1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_setHigh()    do{PORT${port} |= (1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_setLow()     do{PORT${port} &= ~(1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_toggle()     gm_TOGGLE(${port}, P${port}${pin})\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode d\n"
+"/* ${name} - P${port}${pin} - digital input and output $\n"
+"	 ${comment} */\n"
+"\n"
+"\?if compat\n"
+"#define ${name}_init()       do{} while(0)\n"
+"\n"
+"\?endif\n"
+"#define ${name}_dirIn()      do{DDR${port} &= ~(1<<P${port}${pin}); PORT${port} &= ~(1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_dirOut()     do{DDR${port} |= (1<<P${port}${pin});} while(0)\n"
+"\n"
+"\n"
+"#define ${name}_isHigh()     ( (PIN${port} & (1<<P${port}${pin})) != 0 )\n"
+"\n"
+"#define ${name}_isLow()      ( (PIN${port} & (1<<P${port}${pin})) == 0 )\n"
+"\n"
+"\n"
+"#define ${name}_setHigh()    do{PORT${port} |= (1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_setLow()     do{PORT${port} &= ~(1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_toggle()     gm_TOGGLE(${port}, P${port}${pin})\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode l\n"
+"/* ${name} - P${port}${pin} - active low output $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_asOutput()   do{DDR${port} |= (1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_On()         do{PORT${port} &= ~(1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_Off()        do{PORT${port} |= (1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_toggle()     gm_TOGGLE(${port}, P${port}${pin})\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode h\n"
+"/* ${name} - P${port}${pin} - active high output $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_asOutput()   do{DDR${port} |= (1<<P${port}${pin}); PORT${port} &= ~(1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_On()         do{PORT${port} |= (1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_Off()        do{PORT${port} &= ~(1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_toggle()     gm_TOGGLE(${port}, P${port}${pin})\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode b\n"
+"/* ${name} - P${port}${pin} - active low input with internal pull-up resistor $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_asInput()    do{DDR${port} &= ~(1<<P${port}${pin}); PORT${port} |= (1<<P${port}${pin});} while(0)\n"
+"\n"
+"#define ${name}_isActive()   ( (PIN${port} & (1<<P${port}${pin})) == 0 )\n"
+"\n"
+"#define ${name}_isInactive() ( (PIN${port} & (1<<P${port}${pin})) != 0 )\n"
+"\n"
+"end\n"
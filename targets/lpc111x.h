@@ -35,14 +35,9 @@ with m-gen. If not, see
 
 /* functions declarations */
 
+// module described by template (see GM_TEMPLATE_TARGET() in gm-template.h)
 void lpc111x_getData(TARGET_ATTRIBUTES* atrs);
 
-void lpc111x_init(FILE* fp, const TARGET_FLAGS* fls);
-
-int  lpc111x_generateMacros(FILE* inFp, FILE* outFp, const TARGET_FLAGS* fls);
-
-void lpc111x_help(void);
-
 
 /*---------------------------------------------------*/
 
@@ -0,0 +1,278 @@
+"# m-gen target template - NXP LPC111x (ARM Cortex M0)\n"
+"#\n"
+"# Format of template files - see CONTRIBUTING.md\n"
+"# (compiled into m-gen - targets/lpc111x_gmt.h is created by 'make' from this file)\n"
+"\n"
+"\n"
+"target lpc111x\n"
+"description NXP LPC1110-1115 32-bit ARM Cortex M0 microcontrollers\n"
+"supports rmw\n"
+"\n"
+"\n"
+"port number 0 3\n"
+"pin number 0 11\n"
+"\n"
+"\n"
+"# LPC_IOCON register of pin and representation of GPIO function in it\n"
+"text iocon = \"PIO${port}_${pin}\"\n"
+"int func = 0\n"
+"\n"
+"# special pins\n"
+"at 0 0    iocon = \"RESET_PIO0_0\"    func = 1\n"
+"at 0 10   iocon = \"SWCLK_PIO0_10\"   func = 1\n"
+"at 1 3    iocon = \"SWDIO_PIO1_3\"    func = 1\n"
+"\n"
+"# pins: R_PIOx_y\n"
+"at 0 11   iocon = \"R_PIO0_11\"       func = 1\n"
+"at 1 0    iocon = \"R_PIO1_0\"        func = 1\n"
+"at 1 1    iocon = \"R_PIO1_1\"        func = 1\n"
+"at 1 2    iocon = \"R_PIO1_2\"        func = 1\n"
+"\n"
+"\n"
+"# checked in order ('error' stops conversion of the file)\n"
+"# message may contain ${port}, ${pin} and ${line} - line number in .gm file\n"
+"check 0 0   *   warn    \"Pin PIO0_0 is the RESET pin\\n\\t(line: ${line} )\"\n"
+"check 0 10  *   warn    \"Pin PIO0_10 is the SWCLK debug pin\\n\\t(line: ${line} )\"\n"
+"check 1 3   *   warn    \"Pin PIO1_3 is the SWDIO debug pin\\n\\t(line: ${line} )\"\n"
+"\n"
+"check 0 4   od  warn    \"PIO0_4 is open drain output\\n\\t(line: ${line} )\"\n"
+"check 0 4   h   error   \"PIO0_4 is ONLY open drain output (only active-low mode avaiable)\"\n"
+"check 0 5   od  warn    \"PIO0_5 is open drain output\\n\\t(line: ${line} )\"\n"
+"check 0 5   h   error   \"PIO0_5 is ONLY open drain output (only active-low mode avaiable)\"\n"
+"\n"
+"check 0 1   *   warn    \"PIO0_1 is 'bootloader select' pin\"\n"
+"\n"
+"\n"
+"# groups of pins ('$g' section) - 12 bit ports\n"
+"portbits 12\n"
+"\n"
+"# copy of port for ${name}_read() - every DATA is read only once\n"
+"text groupIn = \"gm_${port}\"\n"
+"\n"
+"# one bit of DATA - masked access: address selects bits, so one store / load\n"
+"#   changes / reads only this pin (other pins of port are not touched),\n"
+"#   or in 'rmw' mode read-modify-write of whole DATA register (macros of m-gen 1.2)\n"
+"text high   = \"LPC_GPIO${port}->MASKED_ACCESS[(1<<${pin})] = (1<<${pin})\"\n"
+"text low    = \"LPC_GPIO${port}->MASKED_ACCESS[(1<<${pin})] = 0\"\n"
+"text toggle = \"LPC_GPIO${port}->MASKED_ACCESS[(1<<${pin})] ^= (1<<${pin})\"\n"
+"text state  = \"LPC_GPIO${port}->MASKED_ACCESS[(1<<${pin})]\"\n"
+"\n"
+"text high if rmw   = \"LPC_GPIO${port}->DATA |= (1<<${pin})\"\n"
+"text low if rmw    = \"LPC_GPIO${port}->DATA &= ~(1<<${pin})\"\n"
+"text state if rmw  = \"LPC_GPIO${port}->DATA & (1<<${pin})\"\n"
+"\n"
+"\n"
+"\n"
+"init\n"
+"$m\n"
+"Mode PORT PIN Name Comment\n"
+"\n"
+"l   2   4   led_status    Write here your own macros...\n"
+"\n"
+"$o\n"
+"Format:                                                            $\n"
+"   PORT:                                                           $\n"
+"   LPC port number in format: (i. e.) '2'                          $\n"
+"                                                                   $\n"
+"   PIN:                                                            $\n"
+"   LPC pin number (in PORT) in format: (i. e.) '4'                 $\n"
+"end\n"
+"\n"
+"\n"
+"help\n"
+"NXP LPC111x family ( ARM Cortex M0 core )                               $\n"
+"                                                                        $\n"
+"GPIO are grouped in 4 ports (0-3).                                      $\n"
+"Each port contain up to 12 pins (0-11).                                 $\n"
+"See part datasheet for details.                                         $\n"
+"                                                                        $\n"
+"Note that there are some specific pins:                                 $\n"
+"    PIO0_0  - RESET pin                                                 $\n"
+"    PIO0_1  - BOOTLOADER pin                                            $\n"
+"                                                                        $\n"
+"    PIO0_10 - SWCLK                                                     $\n"
+"    PIO1_3  - SWDIO                                                     $\n"
+"                                                                        $\n"
+"    PIO0_4 and PIO0_5 - open drain outputs                              $\n"
+"                                                                        $\n"
+"                                                                        $\n"
+"                                                                        $\n"
+"This module supports lpc111x MCU-s.                                     $\n"
+"Other chips (11Cxx, 110x, 112x, ...) has not been tested                $\n"
+"and may required some modifications. If you are interested,             $\n"
+"it's possible to easy add new module for m-gen. See:                    $\n"
+"    https://github.com/Leopardus4/m-gen/blob/master/CONTRIBUTING.md     $\n"
+"                                                                        $\n"
+"end\n"
+"\n"
+"\n"
+"\n"
+"# macros used by all pins\n"
+"begin\n"
+"#define gm_SYSAHBCLKCRTL_IOCON  (1<<16)\n"
+"\n"
+"#define gm_DIGITALMODE          (1<<7)\n"
+"\n"
+"#define gm_PULLUP               (1<<4)\n"
+"\n"
+"\n"
+"\n"
+"/* gpio_enableAccess() must be used before any other macros for all gpios */\n"
+"\n"
+"#define gpio_enableAccess() \\\n"
+"    do{LPC_SYSCON->SYSAHBCLKCTRL |= gm_SYSAHBCLKCRTL_IOCON;} while(0)\n"
+"\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"# after macros of every pin\n"
+"after\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"# group of pins - one write of every port: MASKED_ACCESS[] changes only bits from address\n"
+"group\n"
+"/* ${name} - group of pins: ${pins}\n"
+"	 (bit 0 of mask / value - the first pin) */\n"
+"\n"
+"#define ${name}_set(mask)    do{ \\\n"
+"    uint32_t gm_mask = (mask); \\\n"
+"\?port\n"
+"    LPC_GPIO${port}->MASKED_ACCESS[${toPort:gm_mask}] = ${mask}; \\\n"
+"\?endport\n"
+"    } while(0)\n"
+"\n"
+"#define ${name}_clear(mask)  do{ \\\n"
+"    uint32_t gm_mask = (mask); \\\n"
+"\?port\n"
+"    LPC_GPIO${port}->MASKED_ACCESS[${toPort:gm_mask}] = 0; \\\n"
+"\?endport\n"
+"    } while(0)\n"
+"\n"
+"#define ${name}_write(value) do{ \\\n"
+"    uint32_t gm_value = (value); \\\n"
+"\?port\n"
+"\?if full\n"
+"    LPC_GPIO${port}->DATA = ${toPort:gm_value}; \\\n"
+"\?else\n"
+"    LPC_GPIO${port}->MASKED_ACCESS[${mask}] = ${toPort:gm_value}; \\\n"
+"\?endif\n"
+"\?endport\n"
+"    } while(0)\n"
+"\n"
+"#define ${name}_read()       ({ \\\n"
+"\?port\n"
+"    uint32_t gm_${port} = LPC_GPIO${port}->DATA; \\\n"
+"\?endport\n"
+"    (${fromPort:groupIn}); })\n"
+"\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"\n"
+"mode i\n"
+"/* ${name} - ${iocon} - digital input $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_dirIn()      do{LPC_IOCON->${iocon} = gm_DIGITALMODE | (${func}<<0);} while(0)\n"
+"\n"
+"#define ${name}_isHigh()     ((${state}) != 0)\n"
+"\n"
+"#define ${name}_isLow()      ((${state}) == 0)\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode o\n"
+"/* ${name} - ${iocon} - digital output $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_dirOut()     do{LPC_IOCON->${iocon} = gm_DIGITALMODE | (${func}<<0); \\\n"
+"    LPC_GPIO${port}->DIR |= (1<<${pin});} while(0)\n"
+"\n"
+"#define ${name}_setHigh()    do{${high};} while(0)\n"
+"\n"
+"#define ${name}_setLow()     do{${low};} while(0)\n"
+"\n"
+"#define ${name}_toggle()     do{${toggle};} while(0)\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode d\n"
+"/* ${name} - ${iocon} - digital input and output $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_init()       do{LPC_IOCON->${iocon} = gm_DIGITALMODE | (${func}<<0);} while(0)\n"
+"\n"
+"#define ${name}_dirIn()      do{LPC_GPIO${port}->DIR &= ~(1<<${pin});} while(0)\n"
+"\n"
+"#define ${name}_dirOut()     do{LPC_GPIO${port}->DIR |= (1<<${pin});} while(0)\n"
+"\n"
+"\n"
+"#define ${name}_isHigh()     ((${state}) != 0)\n"
+"\n"
+"#define ${name}_isLow()      ((${state}) == 0)\n"
+"\n"
+"\n"
+"#define ${name}_setHigh()    do{${high};} while(0)\n"
+"\n"
+"#define ${name}_setLow()     do{${low};} while(0)\n"
+"\n"
+"#define ${name}_toggle()     do{${toggle};} while(0)\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode l\n"
+"/* ${name} - ${iocon} - active low output $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_asOutput()   do{LPC_IOCON->${iocon} = gm_DIGITALMODE | (${func}<<0); \\\n"
+"    LPC_GPIO${port}->DIR |= (1<<${pin}); ${high};} while(0)\n"
+"\n"
+"#define ${name}_On()         do{${low};} while(0)\n"
+"\n"
+"#define ${name}_Off()        do{${high};} while(0)\n"
+"\n"
+"#define ${name}_toggle()     do{${toggle};} while(0)\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode h\n"
+"/* ${name} - ${iocon} - active high output $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_asOutput()   do{LPC_IOCON->${iocon} = gm_DIGITALMODE | (${func}<<0); \\\n"
+"    LPC_GPIO${port}->DIR |= (1<<${pin}); ${low};} while(0)\n"
+"\n"
+"#define ${name}_Off()        do{${low};} while(0)\n"
+"\n"
+"#define ${name}_On()         do{${high};} while(0)\n"
+"\n"
+"#define ${name}_toggle()     do{${toggle};} while(0)\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"mode b\n"
+"/* ${name} - ${iocon} - active low input with internal pull-up resistor $\n"
+"	 ${comment} */\n"
+"\n"
+"#define ${name}_asInput()    do{LPC_IOCON->${iocon} = gm_DIGITALMODE | gm_PULLUP | (${func}<<0);} while(0)\n"
+"\n"
+"#define ${name}_isActive()   ((${state}) == 0)\n"
+"\n"
+"#define ${name}_isInactive() ((${state}) != 0)\n"
+"\n"
+"end\n"
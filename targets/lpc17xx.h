@@ -38,14 +38,9 @@ Changelog:
 
 /* functions declarations */
 
+// module described by template (see GM_TEMPLATE_TARGET() in gm-template.h)
 void lpc17xx_getData(TARGET_ATTRIBUTES* atrs);
 
-void lpc17xx_init(FILE* fp, const TARGET_FLAGS* fls);
-
-int  lpc17xx_generateMacros(FILE* inFp, FILE* outFp, const TARGET_FLAGS* fls);
-
-void lpc17xx_help(void);
-
 
 /*---------------------------------------------------*/
 
@@ -0,0 +1,322 @@
+"# m-gen target template - NXP LPC175x & LPC176x (ARM Cortex M3)\n"
+"#\n"
+"# Format of template files - see CONTRIBUTING.md\n"
+"# (compiled into m-gen - targets/lpc17xx_gmt.h is created by 'make' from this file)\n"
+"\n"
+"\n"
+"target lpc17xx\n"
+"description NXP LPC175x & 176x series 32-bit ARM Cortex M3 microcontrollers\n"
+"supports compat inline atomic bitband\n"
+"\n"
+"\n"
+"port number 0 4\n"
+"pin number 0 31\n"
+"\n"
+"\n"
+"# macro:  ${proc}name${procBody}...${procEnd}      - without returned value\n"
+"#         ${cond}name${condBody}...${condEnd}      - conditionals (if-else)\n"
+"text proc       = \"#define \"\n"
+"text procBody   = \"() \\\\\\n    do{\"\n"
+"text procEnd    = \" } while(0)\\n\"\n"
+"\n"
+"text cond       = \"#define \"\n"
+"text condBody   = \"() \\\\\\n    (\"\n"
+"text condEnd    = \")\\n\"\n"
+"\n"
+"# 'inline' mode - uint32_t is returned (the fastest type for 32bit CPU)\n"
+"text proc if inline     = \"static inline void \"\n"
+"text procBody if inline = \"(void) {\\n    \"\n"
+"text procEnd if inline  = \"\\n}\\n\"\n"
+"\n"
+"text cond if inline     = \"static inline uint32_t \"\n"
+"text condBody if inline = \"(void) {\\n    return (uint32_t) (\"\n"
+"text condEnd if inline  = \");\\n}\\n\"\n"
+"\n"
+"\n"
+"# Every pin has two bits in PINMODE register, so there are 10 PINMODE registers (instead of 5)\n"
+"int pinmode = port*2 + pin/16\n"
+"int pinmodeShift = (pin%16) * 2\n"
+"\n"
+"# 'bitband' mode - one bit of register is one word in bit-band alias region of Cortex M3:\n"
+"#   alias = 0x22000000 + (register - 0x20000000)*32 + bit*4   (GPIO - 0x2009C000, SRAM region)\n"
+"#   alias = 0x42000000 + (register - 0x40000000)*32 + bit*4   (PINCON - 0x4002C000, peripherals)\n"
+"#   so direction, pull-up and state of pin are one store / load of constant address\n"
+"int gpio      = 0x9C000 + port*0x20\n"
+"int fiodirBit = 0x22000000 + gpio*32 + pin*4\n"
+"int fiopinBit = 0x22000000 + (gpio + 0x14)*32 + pin*4\n"
+"int pullUpBit = 0x42000000 + (0x2C040 + pinmode*4)*32 + (pinmodeShift + 1)*4\n"
+"\n"
+"text disablePullUp = \"LPC_PINCON->PINMODE${pinmode} |= (0x2 << ${pinmodeShift})\"\n"
+"text enablePullUp  = \"LPC_PINCON->PINMODE${pinmode} &= ~(0x2 << ${pinmodeShift})\"\n"
+"\n"
+"# direction & state of pin - read-modify-write of FIODIR, FIOPIN & mask\n"
+"text dirIn  = \"LPC_GPIO${port}->FIODIR &= ~(1<<${pin})\"\n"
+"text dirOut = \"LPC_GPIO${port}->FIODIR |= (1<<${pin})\"\n"
+"text state  = \"LPC_GPIO${port}->FIOPIN & (1<<${pin})\"\n"
+"\n"
+"# the same in 'bitband' mode - one store / load of bit-band alias (addresses - see above)\n"
+"text disablePullUp if bitband = \"gm_BITBAND(${hex:pullUpBit}) = 1\"\n"
+"text enablePullUp if bitband  = \"gm_BITBAND(${hex:pullUpBit}) = 0\"\n"
+"text dirIn if bitband         = \"gm_BITBAND(${hex:fiodirBit}) = 0\"\n"
+"text dirOut if bitband        = \"gm_BITBAND(${hex:fiodirBit}) = 1\"\n"
+"text state if bitband         = \"gm_BITBAND(${hex:fiopinBit})\"\n"
+"\n"
+"# toggle - one read-modify-write of FIOPIN,\n"
+"#   or in 'atomic' mode FIOCLR / FIOSET (other pins of port are never written)\n"
+"text toggle = \"LPC_GPIO${port}->FIOPIN ^= (1<<${pin});\"\n"
+"text toggle if atomic = \"if(${state}) LPC_GPIO${port}->FIOCLR = (1<<${pin}); else LPC_GPIO${port}->FIOSET = (1<<${pin});\"\n"
+"\n"
+"\n"
+"# groups of pins ('$g' section) - 32 bit ports\n"
+"portbits 32\n"
+"\n"
+"# mask / value - copied once in macros (parameters of functions in 'inline' mode)\n"
+"text groupMask     = \"gm_mask\"\n"
+"text groupValue    = \"gm_value\"\n"
+"text groupNotValue = \"~gm_value\"\n"
+"\n"
+"text groupMask if inline     = \"mask\"\n"
+"text groupValue if inline    = \"value\"\n"
+"text groupNotValue if inline = \"~value\"\n"
+"\n"
+"# copy of port for ${name}_read() - every FIOPIN is read only once\n"
+"text groupIn       = \"gm_${port}\"\n"
+"\n"
+"# write() of group with all pins of byte / half-word of port (i. e. 8- or 16-bit bus):\n"
+"#   one store to FIOPIN0 ... FIOPIN3 / FIOPINL, FIOPINH (other pins of port are not touched)\n"
+"int fioByte = pin/8\n"
+"\n"
+"\n"
+"\n"
+"init\n"
+"$m\n"
+"Mode PORT PIN Name Comment\n"
+"\n"
+"l   2   4   led_status    Write here your own macros...\n"
+"\n"
+"$o\n"
+"Format:                                                            $\n"
+"   PORT:                                                           $\n"
+"   LPC port number in format: (i. e.) '2'                          $\n"
+"                                                                   $\n"
+"   PIN:                                                            $\n"
+"   LPC pin number (in PORT) in format: (i. e.) '4'                 $\n"
+"end\n"
+"\n"
+"\n"
+"help\n"
+"NXP LPC175x & LPC176x series ( ARM Cortex M3 core )                     $\n"
+"                                                                        $\n"
+"This module doesn't check if you use valid pin                          $\n"
+"- it must be checked in part datasheet / user manual.                   $\n"
+"                                                                        $\n"
+"LPC177x & 178x series are not supported, BUT                            $\n"
+"if you are interested, it's possible to easy add new module for m-gen.  $\n"
+"See: https://github.com/Leopardus4/m-gen/blob/master/CONTRIBUTING.md    $\n"
+"                                                                        $\n"
+"end\n"
+"\n"
+"\n"
+"\n"
+"# macros used by all pins\n"
+"begin\n"
+"\?if bitband\n"
+"\n"
+"\n"
+"/* word of bit-band alias region - one bit of GPIO / PINCON register */\n"
+"#ifndef gm_BITBAND\n"
+"#define gm_BITBAND(address)     (*(volatile uint32_t*) (address))\n"
+"#endif\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"\?endif\n"
+"\?if compat\n"
+"\n"
+"\n"
+"/* gpio_enableAccess() - empty macro\n"
+"   Used only for compatibility with other MCUs\n"
+"   ( configured by 'm-gen -c' flag )\n"
+" */\n"
+"\n"
+"${proc}gpio_enableAccess${procBody}${procEnd}\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"\?endif\n"
+"end\n"
+"\n"
+"\n"
+"# after macros of every pin\n"
+"after\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"# group of pins - FIOSET / FIOCLR of every port (FIOPIN if group has all pins of port,\n"
+"#   byte / half-word FIOPINx if group has all pins of its byte / half-word)\n"
+"group\n"
+"/* ${name} - group of pins: ${pins}\n"
+"	 (bit 0 of mask / value - the first pin) */\n"
+"\n"
+"\?if inline\n"
+"static inline void ${name}_set(uint32_t mask) {\n"
+"\?port\n"
+"    LPC_GPIO${port}->FIOSET = ${toPort:groupMask};\n"
+"\?endport\n"
+"}\n"
+"static inline void ${name}_clear(uint32_t mask) {\n"
+"\?port\n"
+"    LPC_GPIO${port}->FIOCLR = ${toPort:groupMask};\n"
+"\?endport\n"
+"}\n"
+"static inline void ${name}_write(uint32_t value) {\n"
+"\?port\n"
+"\?if full\n"
+"    LPC_GPIO${port}->FIOPIN = ${toPort:groupValue};\n"
+"\?else\n"
+"\?if byte\n"
+"    LPC_GPIO${port}->FIOPIN${fioByte} = ${toLane:groupValue};\n"
+"\?else\n"
+"\?if half\n"
+"\?if upper\n"
+"    LPC_GPIO${port}->FIOPINH = ${toLane:groupValue};\n"
+"\?else\n"
+"    LPC_GPIO${port}->FIOPINL = ${toLane:groupValue};\n"
+"\?endif\n"
+"\?else\n"
+"    LPC_GPIO${port}->FIOCLR = ${toPort:groupNotValue};\n"
+"    LPC_GPIO${port}->FIOSET = ${toPort:groupValue};\n"
+"\?endif\n"
+"\?endif\n"
+"\?endif\n"
+"\?endport\n"
+"}\n"
+"static inline uint32_t ${name}_read(void) {\n"
+"\?port\n"
+"    uint32_t gm_${port} = LPC_GPIO${port}->FIOPIN;\n"
+"\?endport\n"
+"    return ${fromPort:groupIn};\n"
+"}\n"
+"\?else\n"
+"#define ${name}_set(mask) \\\n"
+"    do{ \\\n"
+"    uint32_t gm_mask = (mask); \\\n"
+"\?port\n"
+"    LPC_GPIO${port}->FIOSET = ${toPort:groupMask}; \\\n"
+"\?endport\n"
+"    } while(0)\n"
+"#define ${name}_clear(mask) \\\n"
+"    do{ \\\n"
+"    uint32_t gm_mask = (mask); \\\n"
+"\?port\n"
+"    LPC_GPIO${port}->FIOCLR = ${toPort:groupMask}; \\\n"
+"\?endport\n"
+"    } while(0)\n"
+"#define ${name}_write(value) \\\n"
+"    do{ \\\n"
+"    uint32_t gm_value = (value); \\\n"
+"\?port\n"
+"\?if full\n"
+"    LPC_GPIO${port}->FIOPIN = ${toPort:groupValue}; \\\n"
+"\?else\n"
+"\?if byte\n"
+"    LPC_GPIO${port}->FIOPIN${fioByte} = ${toLane:groupValue}; \\\n"
+"\?else\n"
+"\?if half\n"
+"\?if upper\n"
+"    LPC_GPIO${port}->FIOPINH = ${toLane:groupValue}; \\\n"
+"\?else\n"
+"    LPC_GPIO${port}->FIOPINL = ${toLane:groupValue}; \\\n"
+"\?endif\n"
+"\?else\n"
+"    LPC_GPIO${port}->FIOCLR = ${toPort:groupNotValue}; \\\n"
+"    LPC_GPIO${port}->FIOSET = ${toPort:groupValue}; \\\n"
+"\?endif\n"
+"\?endif\n"
+"\?endif\n"
+"\?endport\n"
+"    } while(0)\n"
+"#define ${name}_read() \\\n"
+"    ({ \\\n"
+"\?port\n"
+"    uint32_t gm_${port} = LPC_GPIO${port}->FIOPIN; \\\n"
+"\?endport\n"
+"    (${fromPort:groupIn}); })\n"
+"\?endif\n"
+"\n"
+"\n"
+"//------------------------------------------------------------------------//\n"
+"\n"
+"end\n"
+"\n"
+"\n"
+"\n"
+"mode i\n"
+"/* ${name} - P${port}[${pin}] - digital input $\n"
+"	 ${comment} */\n"
+"\n"
+"${proc}${name}_dirIn${procBody}${dirIn}; ${disablePullUp};${procEnd}\n"
+"${cond}${name}_isHigh${condBody}${state}${condEnd}\n"
+"${cond}${name}_isLow${condBody}(${state}) == 0${condEnd}\n"
+"end\n"
+"\n"
+"\n"
+"mode o\n"
+"/* ${name} - P${port}[${pin}] - digital output $\n"
+"	 ${comment} */\n"
+"\n"
+"${proc}${name}_dirOut${procBody}${dirOut}; ${disablePullUp};${procEnd}\n"
+"${proc}${name}_setHigh${procBody}LPC_GPIO${port}->FIOSET = (1<<${pin});${procEnd}\n"
+"${proc}${name}_setLow${procBody}LPC_GPIO${port}->FIOCLR = (1<<${pin});${procEnd}\n"
+"${proc}${name}_toggle${procBody}${toggle}${procEnd}\n"
+"end\n"
+"\n"
+"\n"
+"mode d\n"
+"/* ${name} - P${port}[${pin}] - digital input and output $\n"
+"	 ${comment} */\n"
+"\n"
+"${proc}${name}_init${procBody}${disablePullUp};${procEnd}\n"
+"${proc}${name}_dirIn${procBody}${dirIn};${procEnd}\n"
+"${proc}${name}_dirOut${procBody}${dirOut};${procEnd}\n"
+"${cond}${name}_isHigh${condBody}${state}${condEnd}\n"
+"${cond}${name}_isLow${condBody}(${state}) == 0${condEnd}\n"
+"${proc}${name}_setHigh${procBody}LPC_GPIO${port}->FIOSET = (1<<${pin});${procEnd}\n"
+"${proc}${name}_setLow${procBody}LPC_GPIO${port}->FIOCLR = (1<<${pin});${procEnd}\n"
+"${proc}${name}_toggle${procBody}${toggle}${procEnd}\n"
+"end\n"
+"\n"
+"\n"
+"mode l\n"
+"/* ${name} - P${port}[${pin}] - active low output $\n"
+"	 ${comment} */\n"
+"\n"
+"${proc}${name}_On${procBody}LPC_GPIO${port}->FIOCLR = (1<<${pin});${procEnd}\n"
+"${proc}${name}_Off${procBody}LPC_GPIO${port}->FIOSET = (1<<${pin});${procEnd}\n"
+"${proc}${name}_asOutput${procBody}${dirOut}; ${disablePullUp}; ${name}_Off();${procEnd}\n"
+"${proc}${name}_toggle${procBody}${toggle}${procEnd}\n"
+"end\n"
+"\n"
+"\n"
+"mode h\n"
+"/* ${name} - P${port}[${pin}] - active high output $\n"
+"	 ${comment} */\n"
+"\n"
+"${proc}${name}_On${procBody}LPC_GPIO${port}->FIOSET = (1<<${pin});${procEnd}\n"
+"${proc}${name}_Off${procBody}LPC_GPIO${port}->FIOCLR = (1<<${pin});${procEnd}\n"
+"${proc}${name}_asOutput${procBody}${dirOut}; ${disablePullUp}; ${name}_Off();${procEnd}\n"
+"${proc}${name}_toggle${procBody}${toggle}${procEnd}\n"
+"end\n"
+"\n"
+"\n"
+"mode b\n"
+"/* ${name} - P${port}[${pin}] - active low input with internal pull-up resistor $\n"
+"	 ${comment} */\n"
+"\n"
+"${proc}${name}_asInput${procBody}${dirIn}; ${enablePullUp};${procEnd}\n"
+"${cond}${name}_isActive${condBody}(${state}) == 0${condEnd}\n"
+"${cond}${name}_isInactive${condBody}${state}${condEnd}\n"
+"end\n"